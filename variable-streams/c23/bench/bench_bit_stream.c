@@ -0,0 +1,924 @@
+#include "bit_stream.h"
+#include <sys/resource.h>
+#include <time.h>
+
+// Number of values encoded per run
+#define BENCH_VALUE_COUNT (1 << 20)
+
+// Number of writers created in the setup benchmark
+#define BENCH_WRITER_COUNT 2000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Fills values/widths with a reproducible mix of field widths from 1 to 64 bits
+static size_t generate_fields(uint64_t* values, uint8_t* widths, size_t count) {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    size_t total_bits = 0;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        widths[i] = (uint8_t)(seed % 64) + 1;
+        values[i] = seed * 0xD1B54A32D192ED03ULL;
+        total_bits += widths[i];
+    }
+    return total_bits;
+}
+
+static void report(const char* name, double seconds, size_t total_bits) {
+    printf("%-32s %8.2f ms  %8.3f ns/bit  %8.1f MB/s\n",
+           name, seconds * 1e3, seconds * 1e9 / (double)total_bits,
+           (double)total_bits / 8.0 / seconds / 1e6);
+}
+
+static void bench_bit_stream_write(const uint64_t* values, const uint8_t* widths, size_t count, size_t total_bits) {
+    BitStream* stream = bit_stream_new();
+    
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_write_bits(stream, values[i], widths[i]);
+    }
+    double elapsed = now_seconds() - start;
+    
+    report("bit_stream_write_bits", elapsed, total_bits);
+    bit_stream_free(stream);
+}
+
+static void bench_bit_stream_writer_write(const uint64_t* values, const uint8_t* widths, size_t count, size_t total_bits) {
+    FILE* file = tmpfile();
+    if (file == NULL) {
+        return;
+    }
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 1 << 16);
+    
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_writer_write_bits(writer, values[i], widths[i]);
+    }
+    bit_stream_writer_flush(writer);
+    double elapsed = now_seconds() - start;
+    
+    report("bit_stream_writer_write_bits", elapsed, total_bits);
+    bit_stream_writer_free(writer);
+    fclose(file);
+}
+
+static void bench_bit_stream_writer_setup(void) {
+    // A short record written through a writer with a large buffer; the
+    // buffer is no longer zeroed up front, so only the bytes written count
+    FILE* file = tmpfile();
+    if (file == NULL) {
+        return;
+    }
+    
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_WRITER_COUNT; i++) {
+        BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 1 << 20);
+        bit_stream_writer_write_bits(writer, (uint64_t)i, 48);
+        bit_stream_writer_flush(writer);
+        bit_stream_writer_free(writer);
+    }
+    double elapsed = now_seconds() - start;
+    
+    report("bit_stream_writer_with_capacity", elapsed, (size_t)BENCH_WRITER_COUNT * 48);
+    fclose(file);
+}
+
+// Number of bytes after the first free byte that a single write is checked
+// over: a 64-bit value spans at most nine bytes
+#define BENCH_TOUCH_WINDOW 16
+
+// Number of 1 MiB writers alive at once when counting page faults
+#define BENCH_FAULT_WRITER_COUNT 64
+
+// Bytes stored by one call, measured on two buffers that hold the same bits
+// but opposite poison in the free bytes: a byte the call stored holds the
+// same value in both, a byte it left alone still holds its poison. Bytes
+// stored past the value's final byte are counted as stray.
+typedef struct {
+    size_t stored;
+    size_t stray;
+} ByteTouches;
+
+static void poison_free_bytes(uint8_t* zeros, uint8_t* ones, size_t first_free) {
+    memset(zeros + first_free, 0x00, BENCH_TOUCH_WINDOW);
+    memset(ones + first_free, 0xFF, BENCH_TOUCH_WINDOW);
+}
+
+static void count_touches(const uint8_t* zeros, const uint8_t* ones, size_t first_free, size_t end_bit,
+                          ByteTouches* touches) {
+    size_t value_end = (end_bit + 7) / 8;
+    for (size_t i = first_free; i < first_free + BENCH_TOUCH_WINDOW; i++) {
+        if (zeros[i] == ones[i]) {
+            touches->stored++;
+            if (i >= value_end) {
+                touches->stray++;
+            }
+        }
+    }
+}
+
+static void report_touches(const char* name, const ByteTouches* touches, size_t total_bits, bool matches) {
+    printf("%-32s %8.3f stored/bit  %8zu stray  %s\n",
+           name, (double)touches->stored / (double)total_bits, touches->stray,
+           matches ? "output ok" : "output differs");
+}
+
+static void bench_bytes_touched(const uint64_t* values, const uint8_t* widths, size_t count, size_t total_bits) {
+    // Bytes stored per bit by bit_stream_write_bits and
+    // bit_stream_writer_write_bits, checked call by call
+    size_t total_bytes = (total_bits + 7) / 8;
+    BitStream* reference = bit_stream_new();
+    BitStream* zeros = bit_stream_new();
+    BitStream* ones = bit_stream_new();
+    if (reference == NULL || zeros == NULL || ones == NULL) {
+        bit_stream_free(reference);
+        bit_stream_free(zeros);
+        bit_stream_free(ones);
+        return;
+    }
+    
+    // Size both buffers up front so no write reallocates, then empty them
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_write_bits(reference, values[i], widths[i]);
+    }
+    BitStreamCheckpoint empty = bit_stream_checkpoint(zeros);
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_write_bits(zeros, values[i], widths[i]);
+        bit_stream_write_bits(ones, values[i], widths[i]);
+    }
+    bit_stream_write_bits(zeros, 0, 8 * BENCH_TOUCH_WINDOW);
+    bit_stream_write_bits(ones, 0, 8 * BENCH_TOUCH_WINDOW);
+    bit_stream_rollback(zeros, empty);
+    bit_stream_rollback(ones, empty);
+    
+    ByteTouches touches = {0, 0};
+    size_t position = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t first_free = (position + 7) / 8;
+        poison_free_bytes(zeros->buffer, ones->buffer, first_free);
+        bit_stream_write_bits(zeros, values[i], widths[i]);
+        bit_stream_write_bits(ones, values[i], widths[i]);
+        position += widths[i];
+        count_touches(zeros->buffer, ones->buffer, first_free, position, &touches);
+    }
+    bool matches = memcmp(zeros->buffer, reference->buffer, total_bytes) == 0 &&
+                   memcmp(ones->buffer, reference->buffer, total_bytes) == 0;
+    report_touches("write_bits bytes stored", &touches, total_bits, matches);
+    
+    // The same values through writers whose buffers never need a flush
+    FILE* zeros_file = tmpfile();
+    FILE* ones_file = tmpfile();
+    size_t capacity = total_bytes + BENCH_TOUCH_WINDOW;
+    BitStreamWriter* zeros_writer = (zeros_file != NULL) ? bit_stream_writer_with_capacity(zeros_file, capacity) : NULL;
+    BitStreamWriter* ones_writer = (ones_file != NULL) ? bit_stream_writer_with_capacity(ones_file, capacity) : NULL;
+    if (zeros_writer != NULL && ones_writer != NULL) {
+        touches.stored = 0;
+        touches.stray = 0;
+        position = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t first_free = (position + 7) / 8;
+            poison_free_bytes(zeros_writer->buffer, ones_writer->buffer, first_free);
+            bit_stream_writer_write_bits(zeros_writer, values[i], widths[i]);
+            bit_stream_writer_write_bits(ones_writer, values[i], widths[i]);
+            position += widths[i];
+            count_touches(zeros_writer->buffer, ones_writer->buffer, first_free, position, &touches);
+        }
+        matches = memcmp(zeros_writer->buffer, ones_writer->buffer, total_bytes) == 0;
+        report_touches("writer_write_bits bytes stored", &touches, total_bits, matches);
+    }
+    bit_stream_writer_free(zeros_writer);
+    bit_stream_writer_free(ones_writer);
+    if (zeros_file != NULL) {
+        fclose(zeros_file);
+    }
+    if (ones_file != NULL) {
+        fclose(ones_file);
+    }
+    
+    // Pages first touched while creating writers with a 1 MiB buffer and
+    // writing one 48-bit record to each; the writers are kept alive so every
+    // buffer is fresh memory, and zeroing one would touch all 256 pages
+    FILE* file = tmpfile();
+    BitStreamWriter* writers[BENCH_FAULT_WRITER_COUNT];
+    if (file != NULL) {
+        struct rusage before;
+        struct rusage after;
+        getrusage(RUSAGE_SELF, &before);
+        for (int i = 0; i < BENCH_FAULT_WRITER_COUNT; i++) {
+            writers[i] = bit_stream_writer_with_capacity(file, 1 << 20);
+            bit_stream_writer_write_bits(writers[i], (uint64_t)i, 48);
+            bit_stream_writer_flush(writers[i]);
+        }
+        getrusage(RUSAGE_SELF, &after);
+        printf("%-32s %8.2f page faults/writer\n", "writer_with_capacity 1 MiB",
+               (double)(after.ru_minflt - before.ru_minflt) / BENCH_FAULT_WRITER_COUNT);
+        for (int i = 0; i < BENCH_FAULT_WRITER_COUNT; i++) {
+            bit_stream_writer_free(writers[i]);
+        }
+        fclose(file);
+    }
+    
+    bit_stream_free(reference);
+    bit_stream_free(zeros);
+    bit_stream_free(ones);
+}
+
+static void report_values(const char* name, double seconds, size_t count) {
+    printf("%-32s %8.2f ms  %8.3f ns/val  %8.1f Mval/s\n",
+           name, seconds * 1e3, seconds * 1e9 / (double)count,
+           (double)count / seconds / 1e6);
+}
+
+static void bench_rice_block_read(size_t count) {
+    // Geometric gaps with a mean of about 16, decoded in blocks of 128
+    uint64_t* gaps = (uint64_t*)malloc(count * sizeof(uint64_t));
+    uint64_t* decoded = (uint64_t*)malloc(count * sizeof(uint64_t));
+    BitStream* stream = bit_stream_new();
+    if (gaps == NULL || decoded == NULL || stream == NULL) {
+        free(gaps);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        gaps[i] = (uint64_t)__builtin_ctzll(seed | (1ULL << 63)) * 11 + (seed >> 60);
+    }
+    for (size_t i = 0; i < count; i += 128) {
+        bit_stream_write_rice_block(stream, gaps + i, 128);
+    }
+    
+    bit_stream_reset(stream);
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i += 128) {
+        bit_stream_read_rice_block(stream, decoded + i, 128);
+    }
+    double elapsed = now_seconds() - start;
+    
+    report_values("bit_stream_read_rice_block", elapsed, count);
+    free(gaps);
+    free(decoded);
+    bit_stream_free(stream);
+}
+
+static void bench_varint_read(const uint64_t* values, size_t count) {
+    // Protobuf-like varints of 1 to 5 bytes
+    uint64_t* decoded = (uint64_t*)malloc(count * sizeof(uint64_t));
+    uint32_t* small = (uint32_t*)malloc(count * sizeof(uint32_t));
+    uint32_t* small_decoded = (uint32_t*)malloc(count * sizeof(uint32_t));
+    BitStream* varints = bit_stream_new();
+    BitStream* vbytes = bit_stream_new();
+    if (decoded == NULL || small == NULL || small_decoded == NULL || varints == NULL || vbytes == NULL) {
+        free(decoded);
+        free(small);
+        free(small_decoded);
+        bit_stream_free(varints);
+        bit_stream_free(vbytes);
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        small[i] = (uint32_t)(values[i] >> (32 + values[i] % 32));
+    }
+    for (size_t i = 0; i < count; i++) {
+        decoded[i] = small[i];
+    }
+    bit_stream_write_varint_batch(varints, decoded, count);
+    bit_stream_write_stream_vbyte(vbytes, small, count);
+    bit_stream_reset(varints);
+    bit_stream_reset(vbytes);
+    
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_read_varint(varints);
+    }
+    double elapsed = now_seconds() - start;
+    report_values("bit_stream_read_varint", elapsed, count);
+    
+    bit_stream_reset(varints);
+    start = now_seconds();
+    bit_stream_read_varint_batch(varints, decoded, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_stream_read_varint_batch", elapsed, count);
+    
+    start = now_seconds();
+    bit_stream_read_stream_vbyte(vbytes, small_decoded, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_stream_read_stream_vbyte", elapsed, count);
+    
+    free(decoded);
+    free(small);
+    free(small_decoded);
+    bit_stream_free(varints);
+    bit_stream_free(vbytes);
+}
+
+static void bench_delta_read(size_t count) {
+    // Millisecond samples with nanosecond jitter, as 64-bit timestamps
+    uint64_t* timestamps = (uint64_t*)malloc(count * sizeof(uint64_t));
+    uint64_t* decoded = (uint64_t*)malloc(count * sizeof(uint64_t));
+    BitStream* deltas = bit_stream_new();
+    BitStream* second_deltas = bit_stream_new();
+    if (timestamps == NULL || decoded == NULL || deltas == NULL || second_deltas == NULL) {
+        free(timestamps);
+        free(decoded);
+        bit_stream_free(deltas);
+        bit_stream_free(second_deltas);
+        return;
+    }
+    
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    uint64_t time = 1700000000000000000ULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        time += 1000000 + seed % 64;
+        timestamps[i] = time;
+    }
+    bit_stream_write_delta(deltas, timestamps, count);
+    bit_stream_write_delta_of_delta(second_deltas, timestamps, count);
+    bit_stream_reset(deltas);
+    bit_stream_reset(second_deltas);
+    
+    double start = now_seconds();
+    bit_stream_read_delta(deltas, decoded, count);
+    double elapsed = now_seconds() - start;
+    report_values("bit_stream_read_delta", elapsed, count);
+    
+    start = now_seconds();
+    bit_stream_read_delta_of_delta(second_deltas, decoded, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_stream_read_delta_of_delta", elapsed, count);
+    
+    free(timestamps);
+    free(decoded);
+    bit_stream_free(deltas);
+    bit_stream_free(second_deltas);
+}
+
+static void bench_huffman_read(size_t count) {
+    // Skewed byte events where each symbol is about twice as likely as the next
+    uint8_t* symbols = (uint8_t*)malloc(count);
+    uint8_t* decoded = (uint8_t*)malloc(count);
+    BitStream* stream = bit_stream_new();
+    if (symbols == NULL || decoded == NULL || stream == NULL) {
+        free(symbols);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t histogram[16] = {0};
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        unsigned symbol = (unsigned)__builtin_ctzll(seed | (1ULL << 15));
+        symbols[i] = (uint8_t)symbol;
+        histogram[symbol]++;
+    }
+    HuffmanCode* code = huffman_code_from_histogram(histogram, 16);
+    bit_stream_write_huffman(stream, code, symbols, count);
+    bit_stream_reset(stream);
+    
+    double start = now_seconds();
+    bit_stream_read_huffman(stream, code, decoded, count);
+    double elapsed = now_seconds() - start;
+    report_values("bit_stream_read_huffman", elapsed, count);
+    
+    huffman_code_free(code);
+    free(symbols);
+    free(decoded);
+    bit_stream_free(stream);
+}
+
+static void bench_tans_read(size_t count) {
+    // The same skewed byte events as the Huffman run, through an 11-bit table
+    uint8_t* symbols = (uint8_t*)malloc(count);
+    uint8_t* decoded = (uint8_t*)malloc(count);
+    BitStream* stream = bit_stream_new();
+    if (symbols == NULL || decoded == NULL || stream == NULL) {
+        free(symbols);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t histogram[16] = {0};
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        unsigned symbol = (unsigned)__builtin_ctzll(seed | (1ULL << 15));
+        symbols[i] = (uint8_t)symbol;
+        histogram[symbol]++;
+    }
+    TansCode* code = tans_code_from_histogram(histogram, 16, 11);
+    bit_stream_write_tans(stream, code, symbols, count);
+    bit_stream_set_position(stream, bit_stream_length(stream));
+    
+    double start = now_seconds();
+    bit_stream_read_tans(stream, code, decoded, count);
+    double elapsed = now_seconds() - start;
+    report_values("bit_stream_read_tans", elapsed, count);
+    
+    tans_code_free(code);
+    free(symbols);
+    free(decoded);
+    bit_stream_free(stream);
+}
+
+static void bench_arithmetic_decode(size_t count) {
+    // Eight flag contexts, each 95% zero
+    BitStream* stream = bit_stream_new();
+    ArithmeticEncoder* encoder = arithmetic_encoder_new(stream, 8);
+    ArithmeticDecoder* decoder = arithmetic_decoder_new(stream, 8);
+    if (stream == NULL || encoder == NULL || decoder == NULL) {
+        arithmetic_encoder_free(encoder);
+        arithmetic_decoder_free(decoder);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        arithmetic_encoder_encode_flag(encoder, i % 8, seed % 20 == 0);
+    }
+    arithmetic_encoder_finish(encoder);
+    bit_stream_reset(stream);
+    
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        arithmetic_decoder_decode_flag(decoder, i % 8);
+    }
+    double elapsed = now_seconds() - start;
+    report_values("arithmetic_decoder_decode_flag", elapsed, count);
+    printf("%-32s %8.3f bits/flag\n", "arithmetic_coded_flag_size", (double)bit_stream_length(stream) / (double)count);
+    
+    arithmetic_encoder_free(encoder);
+    arithmetic_decoder_free(decoder);
+    bit_stream_free(stream);
+}
+
+static void bench_rle_hybrid_read(size_t count) {
+    // Dictionary indices of 10 bits, mostly bit-packed with some repeats
+    uint32_t* values = (uint32_t*)malloc(count * sizeof(uint32_t));
+    uint32_t* decoded = (uint32_t*)malloc(count * sizeof(uint32_t));
+    uint8_t* bytes = (uint8_t*)malloc(rle_hybrid_max_encoded_length(count, 10));
+    if (values == NULL || decoded == NULL || bytes == NULL) {
+        free(values);
+        free(decoded);
+        free(bytes);
+        return;
+    }
+    
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 256 >= 224) {
+            values[i] = values[i - 1];
+            continue;
+        }
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        values[i] = (uint32_t)(seed >> 54);
+    }
+    size_t length = rle_hybrid_encode(values, count, 10, bytes);
+    
+    double start = now_seconds();
+    rle_hybrid_decode(bytes, length, 10, decoded, count);
+    double elapsed = now_seconds() - start;
+    report_values("rle_hybrid_decode", elapsed, count);
+    
+    free(values);
+    free(decoded);
+    free(bytes);
+}
+
+static void bench_dictionary_read(size_t count) {
+    // 64-bit identifiers of 1000 devices
+    uint64_t* values = (uint64_t*)malloc(count * sizeof(uint64_t));
+    uint64_t* decoded = (uint64_t*)malloc(count * sizeof(uint64_t));
+    BitStream* stream = bit_stream_new();
+    if (values == NULL || decoded == NULL || stream == NULL) {
+        free(values);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        values[i] = (seed % 1000) * 0x9E3779B97F4A7C15ULL;
+    }
+    double start = now_seconds();
+    bit_stream_write_dictionary(stream, values, count);
+    double elapsed = now_seconds() - start;
+    report_values("dictionary_write", elapsed, count);
+    printf("%-32s %8.3f bits/value\n", "dictionary_coded_size", (double)bit_stream_length(stream) / (double)count);
+    
+    bit_stream_reset(stream);
+    start = now_seconds();
+    bit_stream_read_dictionary(stream, decoded, count);
+    elapsed = now_seconds() - start;
+    report_values("dictionary_read", elapsed, count);
+    
+    free(values);
+    free(decoded);
+    bit_stream_free(stream);
+}
+
+static void bench_xor_double_read(size_t count) {
+    // Sensor readings at 0.01 resolution drifting slowly, held half the time
+    double* samples = (double*)malloc(count * sizeof(double));
+    double* decoded = (double*)malloc(count * sizeof(double));
+    BitStream* stream = bit_stream_new();
+    if (samples == NULL || decoded == NULL || stream == NULL) {
+        free(samples);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    int64_t centis = 2150;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        if (seed % 2 == 0) {
+            centis += (int64_t)(seed % 5) - 2;
+        }
+        samples[i] = (double)centis / 100.0;
+    }
+    bit_stream_write_xor_double(stream, samples, count);
+    printf("%-32s %8.3f bytes/value\n", "xor_double_coded_size", (double)bit_stream_length(stream) / 8.0 / (double)count);
+    
+    // Touch the output first so page faults stay out of the timing
+    memset(decoded, 0, count * sizeof(double));
+    bit_stream_reset(stream);
+    double start = now_seconds();
+    bit_stream_read_xor_double(stream, decoded, count);
+    double elapsed = now_seconds() - start;
+    report_values("xor_double_read", elapsed, count);
+    
+    free(samples);
+    free(decoded);
+    bit_stream_free(stream);
+}
+
+static void bench_quantized_double(size_t count) {
+    // Readings over [-40, 125] kept to 0.01, 15 bits each
+    double* samples = (double*)malloc(count * sizeof(double));
+    double* decoded = (double*)malloc(count * sizeof(double));
+    BitStream* stream = bit_stream_new();
+    Quantizer quantizer;
+    if (samples == NULL || decoded == NULL || stream == NULL || !quantizer_init(&quantizer, -40.0, 125.0, 0.01).success) {
+        free(samples);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        samples[i] = -40.0 + 165.0 * (double)(seed >> 11) / 9007199254740992.0;
+    }
+    memset(decoded, 0, count * sizeof(double));
+    
+    double start = now_seconds();
+    bit_stream_write_quantized_double(stream, &quantizer, samples, count);
+    double elapsed = now_seconds() - start;
+    report_values("write_quantized_double", elapsed, count);
+    
+    bit_stream_reset(stream);
+    start = now_seconds();
+    bit_stream_read_quantized_double(stream, &quantizer, decoded, count);
+    elapsed = now_seconds() - start;
+    report_values("read_quantized_double", elapsed, count);
+    
+    free(samples);
+    free(decoded);
+    bit_stream_free(stream);
+}
+
+static void bench_bit_width_required(const uint64_t* values, size_t count) {
+    double start = now_seconds();
+    volatile uint8_t width = bit_width_required_u64(values, count);
+    double elapsed = now_seconds() - start;
+    report_values("bit_width_required_u64", elapsed, count);
+    
+    start = now_seconds();
+    width = bit_width_required_i64((const int64_t*)values, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_width_required_i64", elapsed, count);
+    (void)width;
+}
+
+static void bench_bool_array(const uint64_t* values, size_t count) {
+    // Presence flags taken from the low bit of the field values
+    bool* flags = (bool*)malloc(count * sizeof(bool));
+    bool* decoded = (bool*)malloc(count * sizeof(bool));
+    BitStream* stream = bit_stream_new();
+    if (flags == NULL || decoded == NULL || stream == NULL) {
+        free(flags);
+        free(decoded);
+        bit_stream_free(stream);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        flags[i] = (values[i] & 1) != 0;
+    }
+    memset(decoded, 0, count * sizeof(bool));
+    
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_write_bits(stream, flags[i], 1);
+    }
+    double elapsed = now_seconds() - start;
+    report_values("write_bits_1bit_flags", elapsed, count);
+    
+    BitStream* packed = bit_stream_new();
+    start = now_seconds();
+    bit_stream_write_bool_array(packed, flags, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_stream_write_bool_array", elapsed, count);
+    
+    bit_stream_reset(packed);
+    start = now_seconds();
+    bit_stream_read_bool_array(packed, decoded, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_stream_read_bool_array", elapsed, count);
+    
+    start = now_seconds();
+    volatile uint64_t ones = bit_stream_popcount_range(packed, 1, count);
+    elapsed = now_seconds() - start;
+    report_values("bit_stream_popcount_range", elapsed, count);
+    (void)ones;
+    
+    free(flags);
+    free(decoded);
+    bit_stream_free(packed);
+    bit_stream_free(stream);
+}
+
+static void bench_rank_select(const uint64_t* values, size_t count) {
+    // Presence flags set for one value in four, queried at random positions
+    bool* flags = (bool*)malloc(count * sizeof(bool));
+    size_t* positions = (size_t*)malloc(count * sizeof(size_t));
+    BitStream* stream = bit_stream_new();
+    if (flags == NULL || positions == NULL || stream == NULL) {
+        free(flags);
+        free(positions);
+        bit_stream_free(stream);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        flags[i] = (values[i] & 3) == 0;
+        positions[i] = (size_t)((values[i] * 0x9E3779B97F4A7C15ULL) % count);
+    }
+    bit_stream_write_bool_array(stream, flags, count);
+    
+    double start = now_seconds();
+    RankSelectIndex* index = rank_select_index_new(stream);
+    double elapsed = now_seconds() - start;
+    report_values("rank_select_index_new", elapsed, count);
+    if (index == NULL) {
+        free(flags);
+        free(positions);
+        bit_stream_free(stream);
+        return;
+    }
+    
+    uint64_t ones = rank_select_index_ones(index);
+    volatile uint64_t sink = 0;
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        sink += rank_select_index_rank1(index, positions[i]);
+    }
+    elapsed = now_seconds() - start;
+    report_values("rank_select_index_rank1", elapsed, count);
+    
+    // The same positions, taken as ranks of set bits
+    for (size_t i = 0; i < count; i++) {
+        positions[i] %= ones;
+    }
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        sink += rank_select_index_select1(index, positions[i]);
+    }
+    elapsed = now_seconds() - start;
+    report_values("rank_select_index_select1", elapsed, count);
+    
+    // Rank by scanning, for a thousandth of the queries
+    for (size_t i = 0; i < count; i++) {
+        positions[i] = (size_t)((values[i] * 0x9E3779B97F4A7C15ULL) % count);
+    }
+    size_t scans = count / 1000;
+    start = now_seconds();
+    for (size_t i = 0; i < scans; i++) {
+        sink += bit_stream_popcount_range(stream, 0, positions[i]);
+    }
+    elapsed = now_seconds() - start;
+    report_values("popcount_range_rank", elapsed, scans);
+    (void)sink;
+    
+    rank_select_index_free(index);
+    free(flags);
+    free(positions);
+    bit_stream_free(stream);
+}
+
+static void bench_elias_fano(const uint64_t* values, size_t count) {
+    // Sorted offsets with gaps below 256, looked up at random
+    uint64_t* offsets = (uint64_t*)malloc(count * sizeof(uint64_t));
+    uint64_t* decoded = (uint64_t*)malloc(count * sizeof(uint64_t));
+    size_t* indices = (size_t*)malloc(count * sizeof(size_t));
+    BitStream* stream = bit_stream_new();
+    if (offsets == NULL || decoded == NULL || indices == NULL || stream == NULL) {
+        free(offsets);
+        free(decoded);
+        free(indices);
+        bit_stream_free(stream);
+        return;
+    }
+    uint64_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        offset += values[i] >> 56;
+        offsets[i] = offset;
+        indices[i] = (size_t)((values[i] * 0x9E3779B97F4A7C15ULL) % count);
+    }
+    
+    bit_stream_write_elias_fano(stream, offsets, count);
+    printf("%-32s %8.3f bits/value\n", "elias_fano_size", (double)bit_stream_length(stream) / (double)count);
+    
+    bit_stream_reset(stream);
+    double start = now_seconds();
+    bit_stream_read_elias_fano(stream, decoded, count);
+    double elapsed = now_seconds() - start;
+    report_values("bit_stream_read_elias_fano", elapsed, count);
+    
+    EliasFano* sequence = elias_fano_from_values(offsets, count);
+    if (sequence == NULL) {
+        free(offsets);
+        free(decoded);
+        free(indices);
+        bit_stream_free(stream);
+        return;
+    }
+    volatile uint64_t sink = 0;
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        sink += elias_fano_access(sequence, indices[i]);
+    }
+    elapsed = now_seconds() - start;
+    report_values("elias_fano_access", elapsed, count);
+    
+    // Targets just above random values, gathered first
+    for (size_t i = 0; i < count; i++) {
+        decoded[i] = offsets[indices[i]] + 1;
+    }
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        sink += elias_fano_next_geq(sequence, decoded[i]);
+    }
+    elapsed = now_seconds() - start;
+    report_values("elias_fano_next_geq", elapsed, count);
+    (void)sink;
+    
+    elias_fano_free(sequence);
+    free(offsets);
+    free(decoded);
+    free(indices);
+    bit_stream_free(stream);
+}
+
+// Composite key for bench_keys: (signed offset, 8-byte name, varint sequence)
+typedef struct {
+    int64_t offset;
+    uint8_t name[8];
+    uint64_t sequence;
+} BenchTuple;
+
+// Encoded keys fit this many bytes, zero padded
+#define BENCH_KEY_BYTES 24
+
+static int compare_bench_tuples(const void* a, const void* b) {
+    const BenchTuple* x = (const BenchTuple*)a;
+    const BenchTuple* y = (const BenchTuple*)b;
+    if (x->offset != y->offset) {
+        return (x->offset < y->offset) ? -1 : 1;
+    }
+    int order = memcmp(x->name, y->name, sizeof(x->name));
+    if (order != 0) {
+        return order;
+    }
+    return (x->sequence > y->sequence) - (x->sequence < y->sequence);
+}
+
+static int compare_bench_keys(const void* a, const void* b) {
+    return memcmp(a, b, BENCH_KEY_BYTES);
+}
+
+static void bench_keys(const uint64_t* values, size_t count) {
+    BenchTuple* tuples = (BenchTuple*)malloc(count * sizeof(BenchTuple));
+    uint8_t* keys = (uint8_t*)calloc(count, BENCH_KEY_BYTES);
+    BitStream* stream = bit_stream_new();
+    if (tuples == NULL || keys == NULL || stream == NULL) {
+        free(tuples);
+        free(keys);
+        bit_stream_free(stream);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        tuples[i].offset = (int64_t)(values[i] >> 44) - (1 << 19);
+        for (size_t j = 0; j < 8; j++) {
+            tuples[i].name[j] = (uint8_t)('a' + (values[i] >> (4 * j)) % 4);
+        }
+        tuples[i].sequence = values[i] >> (values[i] % 64);
+    }
+    
+    // Each key is written from an empty stream and copied to its slot
+    BitStreamCheckpoint empty = bit_stream_checkpoint(stream);
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        bit_stream_rollback(stream, empty);
+        bit_stream_write_key_signed(stream, tuples[i].offset, 24);
+        bit_stream_write_key_bytes(stream, tuples[i].name, 8);
+        bit_stream_write_key_varint(stream, tuples[i].sequence);
+        memcpy(keys + i * BENCH_KEY_BYTES, stream->buffer, (bit_stream_length(stream) + 7) / 8);
+    }
+    double elapsed = now_seconds() - start;
+    report_values("key_encode", elapsed, count);
+    
+    start = now_seconds();
+    qsort(tuples, count, sizeof(BenchTuple), compare_bench_tuples);
+    elapsed = now_seconds() - start;
+    report_values("qsort_tuples_field_compare", elapsed, count);
+    
+    start = now_seconds();
+    qsort(keys, count, BENCH_KEY_BYTES, compare_bench_keys);
+    elapsed = now_seconds() - start;
+    report_values("qsort_keys_memcmp", elapsed, count);
+    
+    free(tuples);
+    free(keys);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    uint64_t* values = (uint64_t*)malloc(BENCH_VALUE_COUNT * sizeof(uint64_t));
+    uint8_t* widths = (uint8_t*)malloc(BENCH_VALUE_COUNT);
+    if (values == NULL || widths == NULL) {
+        free(values);
+        free(widths);
+        return 1;
+    }
+    
+    size_t total_bits = generate_fields(values, widths, BENCH_VALUE_COUNT);
+    
+    bench_bit_stream_write(values, widths, BENCH_VALUE_COUNT, total_bits);
+    bench_bit_stream_writer_write(values, widths, BENCH_VALUE_COUNT, total_bits);
+    bench_bit_stream_writer_setup();
+    bench_bytes_touched(values, widths, BENCH_VALUE_COUNT, total_bits);
+    bench_rice_block_read(BENCH_VALUE_COUNT);
+    bench_varint_read(values, BENCH_VALUE_COUNT);
+    bench_delta_read(BENCH_VALUE_COUNT);
+    bench_huffman_read(BENCH_VALUE_COUNT);
+    bench_tans_read(BENCH_VALUE_COUNT);
+    bench_arithmetic_decode(BENCH_VALUE_COUNT);
+    bench_rle_hybrid_read(BENCH_VALUE_COUNT);
+    bench_dictionary_read(BENCH_VALUE_COUNT);
+    bench_xor_double_read(BENCH_VALUE_COUNT);
+    bench_quantized_double(BENCH_VALUE_COUNT);
+    bench_bit_width_required(values, BENCH_VALUE_COUNT);
+    bench_bool_array(values, BENCH_VALUE_COUNT);
+    bench_rank_select(values, BENCH_VALUE_COUNT);
+    bench_elias_fano(values, BENCH_VALUE_COUNT);
+    bench_keys(values, BENCH_VALUE_COUNT);
+    
+    free(values);
+    free(widths);
+    return 0;
+}
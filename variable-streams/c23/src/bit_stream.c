@@ -1,4 +1,5 @@
 #include "bit_stream.h"
+#include "bit_stream_bits.h"
 
 // Helper function to create a BitStreamResult with an error
 static BitStreamResult create_error_result(BitStreamErrorCode code) {
@@ -29,6 +30,26 @@ static BitStreamResult create_u128_result(UInt128 value) {
     return result;
 }
 
+// Helper function to create a BitStreamResult with an i64 value
+static BitStreamResult create_i64_result(int64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with an i128 value
+static BitStreamResult create_i128_result(Int128 value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i128 = value;
+    return result;
+}
+
 // Helper function to create a BitStreamResult with a BitValue
 static BitStreamResult create_bit_value_result(BitValue value) {
     BitStreamResult result;
@@ -39,6 +60,16 @@ static BitStreamResult create_bit_value_result(BitValue value) {
     return result;
 }
 
+// Helper function to create a BitStreamResult with a reserved field handle
+static BitStreamResult create_field_result(BitStreamField field) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.field = field;
+    return result;
+}
+
 // Helper function to create a BitStreamResult with success status
 static BitStreamResult create_success_result(void) {
     BitStreamResult result;
@@ -60,6 +91,10 @@ BitStream* bit_stream_new(void) {
     stream->byte_pos = 0;
     stream->bit_pos = 0;
     stream->bit_length = 0;
+    stream->undo = NULL;
+    stream->undo_count = 0;
+    stream->undo_capacity = 0;
+    stream->live_checkpoints = 0;
     
     return stream;
 }
@@ -89,6 +124,7 @@ BitStream* bit_stream_from_bytes(const uint8_t* bytes, size_t length) {
 void bit_stream_free(BitStream* stream) {
     if (stream != NULL) {
         free(stream->buffer);
+        free(stream->undo);
         free(stream);
     }
 }
@@ -217,13 +253,33 @@ BitStreamResult bit_stream_read_bit_value(BitStream* stream, uint8_t bit_count)
     }
 }
 
+// Logs bytes [first, end) before an in-place overwrite changes them, so that
+// a rollback can put them back
+static BitStreamResult save_overwritten_bytes(BitStream* stream, size_t first, size_t end) {
+    size_t required = stream->undo_count + (end - first);
+    if (required > stream->undo_capacity) {
+        size_t new_capacity = (required > stream->undo_capacity * 2) ? required : stream->undo_capacity * 2;
+        BitStreamUndo* new_undo = (BitStreamUndo*)realloc(stream->undo, new_capacity * sizeof(BitStreamUndo));
+        if (new_undo == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO);
+        }
+        stream->undo = new_undo;
+        stream->undo_capacity = new_capacity;
+    }
+    
+    for (size_t i = first; i < end; i++) {
+        stream->undo[stream->undo_count].byte_index = i;
+        stream->undo[stream->undo_count].value = stream->buffer[i];
+        stream->undo_count++;
+    }
+    return create_success_result();
+}
+
 BitStreamResult bit_stream_write_bits(BitStream* stream, uint64_t value, uint8_t bit_count) {
     if (bit_count == 0 || bit_count > 64) {
         return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
     }
     
-    uint8_t bits_written = 0;
-    
     // Ensure the buffer has enough space
     size_t required_bytes = (bit_stream_position(stream) + bit_count + 7) / 8;
     if (required_bytes > stream->buffer_capacity) {
@@ -242,40 +298,79 @@ BitStreamResult bit_stream_write_bits(BitStream* stream, uint64_t value, uint8_t
         stream->buffer_capacity = new_capacity;
     }
     
-    // Ensure buffer_size is large enough
+    // Bytes at or beyond the old buffer_size hold no data yet, so they are
+    // stored outright rather than zeroed first and then merged into. Bytes
+    // inside the old buffer_size are merged so that bits outside the written
+    // range survive an overwrite in the middle of the stream.
+    size_t existing_bytes = stream->buffer_size;
+    if (stream->live_checkpoints > 0 && bit_stream_position(stream) < stream->bit_length) {
+        size_t end = (required_bytes < existing_bytes) ? required_bytes : existing_bytes;
+        BitStreamResult result = save_overwritten_bytes(stream, stream->byte_pos, end);
+        if (!result.success) {
+            return result;
+        }
+    }
     if (required_bytes > stream->buffer_size) {
-        // Zero out any new bytes
-        memset(stream->buffer + stream->buffer_size, 0, required_bytes - stream->buffer_size);
         stream->buffer_size = required_bytes;
     }
     
-    while (bits_written < bit_count) {
-        uint8_t bits_left_in_byte = 8 - stream->bit_pos;
-        uint8_t bits_to_write = (bit_count - bits_written < bits_left_in_byte) ? 
-                                (bit_count - bits_written) : bits_left_in_byte;
+    if (bit_count < 64) {
+        value &= (1ULL << bit_count) - 1;
+    }
+    
+    uint8_t* dst = stream->buffer + stream->byte_pos;
+    size_t index = stream->byte_pos;
+    uint8_t bits_left_in_byte = 8 - stream->bit_pos;
+    
+    if (bit_count <= bits_left_in_byte) {
+        // The whole value lands inside the current byte
+        uint8_t byte_shift = bits_left_in_byte - bit_count;
+        uint8_t bits = (uint8_t)(value << byte_shift);
+        if (index < existing_bytes) {
+            uint8_t byte_mask = (uint8_t)(((1U << bit_count) - 1) << byte_shift);
+            *dst = (uint8_t)((*dst & ~byte_mask) | bits);
+        } else {
+            *dst = bits;
+        }
+    } else {
+        uint8_t remaining = bit_count - bits_left_in_byte;
         
-        // Extract the bits to write
-        uint8_t shift = bit_count - bits_written - bits_to_write;
-        uint64_t mask = ((1ULL << bits_to_write) - 1) << shift;
-        uint8_t extracted_bits = (uint8_t)((value & mask) >> shift);
+        // Head: the most significant bits complete the current byte
+        uint8_t head = (uint8_t)(value >> remaining);
+        if (index < existing_bytes) {
+            uint8_t byte_mask = (uint8_t)((1U << bits_left_in_byte) - 1);
+            *dst = (uint8_t)((*dst & ~byte_mask) | head);
+        } else {
+            *dst = head;
+        }
+        dst++;
+        index++;
         
-        // Write the bits to the current byte
-        uint8_t byte_shift = bits_left_in_byte - bits_to_write;
-        uint8_t byte_mask = ~(((1U << bits_to_write) - 1) << byte_shift);
-        stream->buffer[stream->byte_pos] &= byte_mask;
-        stream->buffer[stream->byte_pos] |= extracted_bits << byte_shift;
+        // Body: whole bytes are stored without reading them back
+        while (remaining >= 8) {
+            remaining -= 8;
+            *dst++ = (uint8_t)(value >> remaining);
+            index++;
+        }
         
-        // Update position
-        bits_written += bits_to_write;
-        stream->bit_pos += bits_to_write;
-        if (stream->bit_pos == 8) {
-            stream->byte_pos += 1;
-            stream->bit_pos = 0;
+        // Tail: the least significant bits start the next byte
+        if (remaining > 0) {
+            uint8_t tail = (uint8_t)(value << (8 - remaining));
+            if (index < existing_bytes) {
+                uint8_t byte_mask = (uint8_t)(0xFFU << (8 - remaining));
+                *dst = (uint8_t)((*dst & ~byte_mask) | tail);
+            } else {
+                *dst = tail;
+            }
         }
     }
     
+    // Update position
+    size_t new_position = bit_stream_position(stream) + bit_count;
+    stream->byte_pos = new_position / 8;
+    stream->bit_pos = new_position % 8;
+    
     // Update the bit length if we've written beyond the current length
-    size_t new_position = bit_stream_position(stream);
     if (new_position > stream->bit_length) {
         stream->bit_length = new_position;
     }
@@ -335,6 +430,8 @@ uint8_t* bit_stream_into_bytes(BitStream* stream, size_t* length) {
     stream->byte_pos = 0;
     stream->bit_pos = 0;
     stream->bit_length = 0;
+    stream->undo_count = 0;
+    stream->live_checkpoints = 0;
     
     return buffer;
 }
@@ -342,8 +439,404 @@ uint8_t* bit_stream_into_bytes(BitStream* stream, size_t* length) {
 void bit_stream_reset(BitStream* stream) {
     stream->byte_pos = 0;
     stream->bit_pos = 0;
+    
+    // Starting over ends every checkpoint, so nothing is left to roll back
+    stream->undo_count = 0;
+    stream->live_checkpoints = 0;
 }
 
 bool bit_stream_is_eof(const BitStream* stream) {
     return bit_stream_position(stream) >= stream->bit_length;
-}
\ No newline at end of file
+}
+
+BitStreamCheckpoint bit_stream_checkpoint(BitStream* stream) {
+    stream->live_checkpoints++;
+    
+    BitStreamCheckpoint checkpoint;
+    checkpoint.bit_position = bit_stream_position(stream);
+    checkpoint.bit_length = stream->bit_length;
+    checkpoint.overwrite_count = stream->undo_count;
+    return checkpoint;
+}
+
+BitStreamResult bit_stream_rollback(BitStream* stream, BitStreamCheckpoint checkpoint) {
+    // The stream must still hold everything that existed at the checkpoint
+    if (checkpoint.bit_length > stream->bit_length || checkpoint.bit_position > checkpoint.bit_length ||
+        checkpoint.overwrite_count > stream->undo_count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_CHECKPOINT);
+    }
+    
+    // Put back the bytes overwritten in place since, newest first
+    while (stream->undo_count > checkpoint.overwrite_count) {
+        const BitStreamUndo* undo = &stream->undo[--stream->undo_count];
+        stream->buffer[undo->byte_index] = undo->value;
+    }
+    
+    // An empty stream has no bytes left for older entries to restore
+    if (checkpoint.bit_length == 0) {
+        stream->undo_count = 0;
+    }
+    
+    // Truncate to the checkpointed length; bits appended since are dropped
+    stream->bit_length = checkpoint.bit_length;
+    stream->buffer_size = (checkpoint.bit_length + 7) / 8;
+    
+    // Clear the unused bits of the final byte so the padding stays zero
+    uint8_t used_bits = checkpoint.bit_length % 8;
+    if (used_bits > 0) {
+        stream->buffer[stream->buffer_size - 1] &= (uint8_t)(0xFF << (8 - used_bits));
+    }
+    
+    stream->byte_pos = checkpoint.bit_position / 8;
+    stream->bit_pos = checkpoint.bit_position % 8;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_release_checkpoint(BitStream* stream, BitStreamCheckpoint checkpoint) {
+    if (stream->live_checkpoints == 0 || checkpoint.overwrite_count > stream->undo_count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_CHECKPOINT);
+    }
+    
+    // Entries logged since the checkpoint are still needed by any older
+    // checkpoint that is live; once none is, the log is dropped
+    stream->live_checkpoints--;
+    if (stream->live_checkpoints == 0) {
+        stream->undo_count = 0;
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reserve_field(BitStream* stream, uint8_t bit_count) {
+    BitStreamField field;
+    field.bit_position = bit_stream_position(stream);
+    field.bit_count = bit_count;
+    
+    // Reserved bits read as zero until the field is patched
+    BitStreamResult result = bit_stream_write_bits(stream, 0, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    
+    return create_field_result(field);
+}
+
+BitStreamResult bit_stream_patch_field(BitStream* stream, BitStreamField field, uint64_t value) {
+    if (field.bit_count == 0 || field.bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    
+    // The field must still lie inside the stream, e.g. not rolled back
+    if (field.bit_position + field.bit_count > stream->bit_length) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_FIELD);
+    }
+    
+    // Overwrite the field in place and return to the current position
+    size_t position = bit_stream_position(stream);
+    stream->byte_pos = field.bit_position / 8;
+    stream->bit_pos = field.bit_position % 8;
+    
+    BitStreamResult result = bit_stream_write_bits(stream, value, field.bit_count);
+    
+    stream->byte_pos = position / 8;
+    stream->bit_pos = position % 8;
+    
+    return result;
+}
+
+BitStreamResult bit_stream_read_signed_bits(BitStream* stream, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits(stream, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i64_result(int64_sign_extend(result.value.u64, bit_count));
+}
+
+BitStreamResult bit_stream_read_signed_bits_i128(BitStream* stream, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits_u128(stream, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i128_result(int128_sign_extend(result.value.u128, bit_count));
+}
+
+BitStreamResult bit_stream_write_signed_bits(BitStream* stream, int64_t value, uint8_t bit_count) {
+    // The low bit_count bits of the two's complement form are the field
+    return bit_stream_write_bits(stream, (uint64_t)value, bit_count);
+}
+
+BitStreamResult bit_stream_write_signed_bits_i128(BitStream* stream, Int128 value, uint8_t bit_count) {
+    return bit_stream_write_bits_u128(stream, uint128_from_parts((uint64_t)value.high, value.low), bit_count);
+}
+
+BitStreamResult bit_stream_read_bits_batch(BitStream* stream, uint64_t* values, size_t count, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    
+    // The whole batch must be available; nothing is consumed otherwise
+    size_t position = bit_stream_position(stream);
+    if (count > (stream->bit_length - position) / bit_count) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    
+    // Each value is cut out of a big-endian word loaded at its first byte,
+    // plus a ninth byte when a 58+ bit value straddles the word
+    uint8_t drop = 64 - bit_count;
+    size_t i = 0;
+    for (; i < count; i++) {
+        size_t byte_index = position / 8;
+        if (byte_index + 9 > stream->buffer_size) {
+            break;
+        }
+        
+        uint8_t offset = position % 8;
+        const uint8_t* bytes = stream->buffer + byte_index;
+        uint64_t value = (bit_stream_load_be64(bytes) << offset) >> drop;
+        if (offset + bit_count > 64) {
+            value |= bytes[8] >> (72 - offset - bit_count);
+        }
+        values[i] = value;
+        position += bit_count;
+    }
+    
+    stream->byte_pos = position / 8;
+    stream->bit_pos = position % 8;
+    
+    // The last few values near the end of the buffer take the general path
+    for (; i < count; i++) {
+        values[i] = bit_stream_read_bits(stream, bit_count).value.u64;
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_bits_batch(BitStream* stream, const uint64_t* values, size_t count, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    size_t position = bit_stream_position(stream);
+    
+    // Overwriting existing data has to merge byte by byte
+    if (position < stream->bit_length) {
+        for (size_t i = 0; i < count; i++) {
+            BitStreamResult result = bit_stream_write_bits(stream, values[i], bit_count);
+            if (!result.success) {
+                return result;
+            }
+        }
+        return create_success_result();
+    }
+    
+    // Grow the buffer once for the whole batch
+    size_t end_position = position + count * bit_count;
+    size_t required_bytes = (end_position + 7) / 8;
+    if (required_bytes > stream->buffer_capacity) {
+        size_t new_capacity = (required_bytes > stream->buffer_capacity * 2) ?
+                              required_bytes : stream->buffer_capacity * 2;
+        uint8_t* new_buffer = (uint8_t*)realloc(stream->buffer, new_capacity);
+        if (new_buffer == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO);
+        }
+        stream->buffer = new_buffer;
+        stream->buffer_capacity = new_capacity;
+    }
+    
+    // Bits are gathered MSB first in an accumulator holding fewer than 8
+    // pending bits between values; values wider than 56 bits are added in
+    // two halves so the accumulator never overflows
+    uint8_t* dst = stream->buffer + stream->byte_pos;
+    uint8_t pending_bits = stream->bit_pos;
+    uint64_t accumulator = (pending_bits > 0) ? (uint64_t)(*dst >> (8 - pending_bits)) : 0;
+    uint64_t mask = (bit_count == 64) ? UINT64_MAX : (1ULL << bit_count) - 1;
+    
+    for (size_t i = 0; i < count; i++) {
+        uint64_t value = values[i] & mask;
+        if (bit_count > 56) {
+            uint8_t high_bits = bit_count - 32;
+            accumulator = (accumulator << high_bits) | (value >> 32);
+            pending_bits += high_bits;
+            while (pending_bits >= 8) {
+                pending_bits -= 8;
+                *dst++ = (uint8_t)(accumulator >> pending_bits);
+            }
+            accumulator = (accumulator << 32) | (value & 0xFFFFFFFFULL);
+            pending_bits += 32;
+        } else {
+            accumulator = (accumulator << bit_count) | value;
+            pending_bits += bit_count;
+        }
+        while (pending_bits >= 8) {
+            pending_bits -= 8;
+            *dst++ = (uint8_t)(accumulator >> pending_bits);
+        }
+    }
+    
+    // The trailing partial byte is stored with zero padding
+    if (pending_bits > 0) {
+        *dst = (uint8_t)(accumulator << (8 - pending_bits));
+    }
+    
+    stream->buffer_size = required_bytes;
+    stream->byte_pos = end_position / 8;
+    stream->bit_pos = end_position % 8;
+    stream->bit_length = end_position;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_signed_bits_batch(BitStream* stream, int64_t* values, size_t count, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits_batch(stream, (uint64_t*)values, count, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    
+    // Branch-free sign extension over the whole column
+    uint64_t sign_bit = 1ULL << (bit_count - 1);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (int64_t)(((uint64_t)values[i] ^ sign_bit) - sign_bit);
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_signed_bits_batch(BitStream* stream, const int64_t* values, size_t count, uint8_t bit_count) {
+    // Two's complement values are written as their low bit_count bits
+    return bit_stream_write_bits_batch(stream, (const uint64_t*)values, count, bit_count);
+}
+
+BitStreamResult bit_stream_peek_bits(const BitStream* stream, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    
+    // Bits past the end of the stream read as zero
+    size_t available = (stream->byte_pos < stream->buffer_size) ? stream->buffer_size - stream->byte_pos : 0;
+    uint64_t window = bit_stream_window64(stream->buffer + stream->byte_pos, available, stream->bit_pos);
+    
+    return create_u64_result(window >> (64 - bit_count));
+}
+
+BitStreamResult bit_stream_skip_bits(BitStream* stream, size_t bit_count) {
+    size_t position = bit_stream_position(stream);
+    if (bit_count > stream->bit_length - position) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    
+    position += bit_count;
+    stream->byte_pos = position / 8;
+    stream->bit_pos = position % 8;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_bits_backward(BitStream* stream, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    
+    // The field is the bit_count bits just before the current position
+    size_t position = bit_stream_position(stream);
+    if (position < bit_count) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    uint64_t window = bit_stream_window64_before(stream->buffer, stream->buffer_size, position);
+    uint64_t value = (bit_count == 64) ? window : window & ((1ULL << bit_count) - 1);
+    
+    position -= bit_count;
+    stream->byte_pos = position / 8;
+    stream->bit_pos = position % 8;
+    
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_align(BitStream* stream) {
+    if (stream->bit_pos == 0) {
+        return create_success_result();
+    }
+    
+    // Padding bits past the end of the stream are already zero
+    stream->byte_pos++;
+    stream->bit_pos = 0;
+    if (stream->byte_pos * 8 > stream->bit_length) {
+        stream->bit_length = stream->byte_pos * 8;
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_align_read(BitStream* stream) {
+    if (stream->bit_pos == 0) {
+        return create_success_result();
+    }
+    
+    // Reading never changes the stream, so the next byte boundary must lie
+    // inside it
+    if ((stream->byte_pos + 1) * 8 > stream->bit_length) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    stream->byte_pos++;
+    stream->bit_pos = 0;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_bytes(BitStream* stream, const uint8_t* bytes, size_t length) {
+    if (stream->bit_pos != 0 || stream->byte_pos < stream->buffer_size) {
+        // Unaligned or overwriting: merge through the bit path
+        for (size_t i = 0; i < length; i++) {
+            BitStreamResult result = bit_stream_write_bits(stream, bytes[i], 8);
+            if (!result.success) {
+                return result;
+            }
+        }
+        return create_success_result();
+    }
+    
+    size_t required_bytes = stream->byte_pos + length;
+    if (required_bytes > stream->buffer_capacity) {
+        size_t new_capacity = (required_bytes > stream->buffer_capacity * 2) ?
+                              required_bytes : stream->buffer_capacity * 2;
+        uint8_t* new_buffer = (uint8_t*)realloc(stream->buffer, new_capacity);
+        if (new_buffer == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO);
+        }
+        stream->buffer = new_buffer;
+        stream->buffer_capacity = new_capacity;
+    }
+    
+    if (length > 0) {
+        memcpy(stream->buffer + stream->byte_pos, bytes, length);
+    }
+    stream->byte_pos = required_bytes;
+    stream->buffer_size = required_bytes;
+    stream->bit_length = required_bytes * 8;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_bytes(BitStream* stream, uint8_t* bytes, size_t length) {
+    size_t position = bit_stream_position(stream);
+    if (length > (stream->bit_length - position) / 8) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    
+    if (stream->bit_pos != 0) {
+        for (size_t i = 0; i < length; i++) {
+            bytes[i] = (uint8_t)bit_stream_read_bits(stream, 8).value.u64;
+        }
+        return create_success_result();
+    }
+    
+    if (length > 0) {
+        memcpy(bytes, stream->buffer + stream->byte_pos, length);
+    }
+    stream->byte_pos += length;
+    
+    return create_success_result();
+}
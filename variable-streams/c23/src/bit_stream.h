@@ -13,7 +13,10 @@ typedef enum {
     BIT_STREAM_ERROR_NONE = 0,
     BIT_STREAM_ERROR_IO,
     BIT_STREAM_ERROR_INVALID_BIT_COUNT,
-    BIT_STREAM_ERROR_END_OF_STREAM
+    BIT_STREAM_ERROR_END_OF_STREAM,
+    BIT_STREAM_ERROR_INVALID_CHECKPOINT,
+    BIT_STREAM_ERROR_INVALID_FIELD,
+    BIT_STREAM_ERROR_INVALID_VALUE
 } BitStreamErrorCode;
 
 typedef struct {
@@ -62,6 +65,12 @@ typedef struct {
     } value;
 } BitValue;
 
+// A byte of a BitStream as it was before an in-place overwrite changed it
+typedef struct {
+    size_t byte_index;
+    uint8_t value;
+} BitStreamUndo;
+
 // BitStream
 typedef struct {
     uint8_t* buffer;
@@ -70,6 +79,10 @@ typedef struct {
     size_t byte_pos;
     uint8_t bit_pos;
     size_t bit_length;
+    BitStreamUndo* undo;  // Bytes overwritten in place, oldest first, for rollback
+    size_t undo_count;
+    size_t undo_capacity;
+    size_t live_checkpoints;  // Checkpoints not yet released; overwrites are logged only while nonzero
 } BitStream;
 
 // BitStreamReader
@@ -81,8 +94,34 @@ typedef struct {
     size_t byte_pos;
     uint8_t bit_pos;
     bool eof;
+    size_t backward_offset;  // Backward mode: file offset of buffer[0]
 } BitStreamReader;
 
+// Durability policy applied when a BitStreamWriter hands data to its file
+typedef enum {
+    BIT_STREAM_DURABILITY_NONE,          // Never fdatasync; the OS decides
+    BIT_STREAM_DURABILITY_PERIODIC,      // fdatasync every sync_bytes or sync_interval_ms
+    BIT_STREAM_DURABILITY_GROUP_COMMIT   // Commits share fdatasync calls through a group
+} BitStreamDurabilityMode;
+
+// Shared committer for writers on the same file; opaque
+typedef struct BitStreamGroupCommit BitStreamGroupCommit;
+
+typedef struct {
+    BitStreamDurabilityMode mode;
+    size_t sync_bytes;           // PERIODIC: unsynced bytes that trigger a sync, 0 to ignore
+    uint32_t sync_interval_ms;   // PERIODIC: age of the last sync that triggers one, 0 to ignore;
+                                 // checked when a full buffer, flush or commit reaches the file
+    BitStreamGroupCommit* group; // GROUP_COMMIT: committer shared by the writers
+} BitStreamDurability;
+
+// Handle to bits reserved with a reserve_field call, filled in later by the
+// matching patch_field call
+typedef struct {
+    size_t bit_position;
+    uint8_t bit_count;
+} BitStreamField;
+
 // BitStreamWriter
 typedef struct {
     FILE* file;
@@ -90,8 +129,30 @@ typedef struct {
     size_t buffer_capacity;
     size_t byte_pos;
     uint8_t bit_pos;
+    size_t bytes_flushed;  // Bytes handed to the file so far
+    size_t* open_fields;   // Bit positions of reserved fields not yet patched
+    size_t open_field_count;
+    size_t open_field_capacity;
+    BitStreamField* patched_fields;  // Fields patched in place, oldest first, for rollback
+    size_t patched_count;
+    size_t patched_capacity;
+    size_t patched_dropped;  // Patches dropped from the log once their bytes were flushed
+    BitStreamDurability durability;
+    size_t unsynced_bytes;   // Bytes flushed since the last fdatasync
+    uint64_t last_sync_ms;
 } BitStreamWriter;
 
+// Saved write position of a BitStream or BitStreamWriter; rolling back to it
+// discards every bit written after it was taken and restores the bits that
+// were overwritten in place since (by a patch_field, or for a BitStream by a
+// write after set_position). A BitStream checkpoint stays live, logging
+// overwrites, until it is released; a reset invalidates it.
+typedef struct {
+    size_t bit_position;
+    size_t bit_length;
+    size_t overwrite_count;  // In-place overwrites logged before the checkpoint
+} BitStreamCheckpoint;
+
 // Result type for functions that can fail
 typedef struct {
     bool success;
@@ -99,7 +160,10 @@ typedef struct {
     union {
         uint64_t u64;
         UInt128 u128;
+        int64_t i64;
+        Int128 i128;
         BitValue bit_value;
+        BitStreamField field;
     } value;
 } BitStreamResult;
 
@@ -117,9 +181,34 @@ BitStreamResult bit_stream_read_bits_u128(BitStream* stream, uint8_t bit_count);
 BitStreamResult bit_stream_write_bits(BitStream* stream, uint64_t value, uint8_t bit_count);
 BitStreamResult bit_stream_write_bits_u128(BitStream* stream, UInt128 value, uint8_t bit_count);
 BitStreamResult bit_stream_write_bit_value(BitStream* stream, BitValue value, uint8_t bit_count);
+BitStreamResult bit_stream_read_signed_bits(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_read_signed_bits_i128(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_write_signed_bits(BitStream* stream, int64_t value, uint8_t bit_count);
+BitStreamResult bit_stream_write_signed_bits_i128(BitStream* stream, Int128 value, uint8_t bit_count);
+BitStreamResult bit_stream_peek_bits(const BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_skip_bits(BitStream* stream, size_t bit_count);
+// Reads the field that ends at the current position and moves back over it;
+// set the position to the length first to read a stream from its end
+BitStreamResult bit_stream_read_bits_backward(BitStream* stream, uint8_t bit_count);
+// Moves to the next byte boundary; align pads the stream up to it when
+// writing, while align_read only moves the position and fails with
+// END_OF_STREAM if the boundary lies past the end
+BitStreamResult bit_stream_align(BitStream* stream);
+BitStreamResult bit_stream_align_read(BitStream* stream);
+BitStreamResult bit_stream_write_bytes(BitStream* stream, const uint8_t* bytes, size_t length);
+BitStreamResult bit_stream_read_bytes(BitStream* stream, uint8_t* bytes, size_t length);
+BitStreamResult bit_stream_read_bits_batch(BitStream* stream, uint64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_write_bits_batch(BitStream* stream, const uint64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_read_signed_bits_batch(BitStream* stream, int64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_write_signed_bits_batch(BitStream* stream, const int64_t* values, size_t count, uint8_t bit_count);
 uint8_t* bit_stream_into_bytes(BitStream* stream, size_t* length);
 void bit_stream_reset(BitStream* stream);
 bool bit_stream_is_eof(const BitStream* stream);
+BitStreamCheckpoint bit_stream_checkpoint(BitStream* stream);
+BitStreamResult bit_stream_rollback(BitStream* stream, BitStreamCheckpoint checkpoint);
+BitStreamResult bit_stream_release_checkpoint(BitStream* stream, BitStreamCheckpoint checkpoint);
+BitStreamResult bit_stream_reserve_field(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_patch_field(BitStream* stream, BitStreamField field, uint64_t value);
 
 // BitStreamReader functions
 BitStreamReader* bit_stream_reader_new(FILE* file);
@@ -129,6 +218,17 @@ BitStreamResult bit_stream_reader_read_bits(BitStreamReader* reader, uint8_t bit
 BitStreamResult bit_stream_reader_read_bits_u128(BitStreamReader* reader, uint8_t bit_count);
 BitStreamResult bit_stream_reader_read_bit_value(BitStreamReader* reader, uint8_t bit_count);
 bool bit_stream_reader_is_eof(const BitStreamReader* reader);
+BitStreamResult bit_stream_reader_read_signed_bits(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_signed_bits_i128(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_bits_msb(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_peek_bits_msb(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_skip_bits(BitStreamReader* reader, size_t bit_count);
+// Switches the reader to backward mode at the end of the file, which must be
+// seekable; afterwards only the backward functions may be used
+BitStreamResult bit_stream_reader_seek_end(BitStreamReader* reader);
+BitStreamResult bit_stream_reader_read_bits_backward(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_bits_batch(BitStreamReader* reader, uint64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_signed_bits_batch(BitStreamReader* reader, int64_t* values, size_t count, uint8_t bit_count);
 
 // BitStreamWriter functions
 BitStreamWriter* bit_stream_writer_new(FILE* file);
@@ -138,6 +238,33 @@ BitStreamResult bit_stream_writer_write_bits(BitStreamWriter* writer, uint64_t v
 BitStreamResult bit_stream_writer_write_bits_u128(BitStreamWriter* writer, UInt128 value, uint8_t bit_count);
 BitStreamResult bit_stream_writer_write_bit_value(BitStreamWriter* writer, BitValue value, uint8_t bit_count);
 BitStreamResult bit_stream_writer_flush(BitStreamWriter* writer);
+BitStreamResult bit_stream_writer_write_signed_bits(BitStreamWriter* writer, int64_t value, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_signed_bits_i128(BitStreamWriter* writer, Int128 value, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_bits_msb(BitStreamWriter* writer, uint64_t value, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_bits_batch(BitStreamWriter* writer, const uint64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_signed_bits_batch(BitStreamWriter* writer, const int64_t* values, size_t count, uint8_t bit_count);
+BitStreamCheckpoint bit_stream_writer_checkpoint(const BitStreamWriter* writer);
+BitStreamResult bit_stream_writer_rollback(BitStreamWriter* writer, BitStreamCheckpoint checkpoint);
+BitStreamResult bit_stream_writer_reserve_field(BitStreamWriter* writer, uint8_t bit_count);
+BitStreamResult bit_stream_writer_patch_field(BitStreamWriter* writer, BitStreamField field, uint64_t value);
+BitStreamResult bit_stream_writer_set_durability(BitStreamWriter* writer, BitStreamDurability durability);
+// Hands every whole byte written so far, up to the earliest open field, to
+// the file and makes it durable under the writer's policy. Unlike flush it
+// does not pad: a partially filled last byte stays buffered and the next
+// write continues it.
+BitStreamResult bit_stream_writer_commit(BitStreamWriter* writer);
+
+// BitStreamGroupCommit functions
+BitStreamGroupCommit* bit_stream_group_commit_new(FILE* file);
+void bit_stream_group_commit_free(BitStreamGroupCommit* group);
+BitStreamResult bit_stream_group_commit_sync(BitStreamGroupCommit* group);
+uint64_t bit_stream_group_commit_sync_count(const BitStreamGroupCommit* group);
+// While a group is held, commits take their place and wait without starting a
+// sync; releasing it lets one sync cover every commit that gathered
+void bit_stream_group_commit_hold(BitStreamGroupCommit* group);
+void bit_stream_group_commit_release(BitStreamGroupCommit* group);
+// Commits waiting for a sync to cover them
+uint64_t bit_stream_group_commit_pending(const BitStreamGroupCommit* group);
 
 // BitValue functions
 BitStreamResult bit_value_new(uint64_t value, uint8_t bit_count);
@@ -151,6 +278,310 @@ int64_t bit_value_to_i64(const BitValue* value);
 Int128 bit_value_to_i128(const BitValue* value);
 bool bit_value_is_signed(const BitValue* value);
 
+// ZigZag functions; signed values are interleaved (0, -1, 1, -2, ...) so
+// small magnitudes of either sign need few bits
+uint64_t zigzag_encode_i64(int64_t value);
+int64_t zigzag_decode_u64(uint64_t value);
+UInt128 zigzag_encode_i128(Int128 value);
+Int128 zigzag_decode_u128(UInt128 value);
+void zigzag_encode_i64_batch(const int64_t* values, uint64_t* encoded, size_t count);
+void zigzag_decode_u64_batch(const uint64_t* encoded, int64_t* values, size_t count);
+BitStreamResult bit_stream_read_zigzag(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_read_zigzag_i128(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_write_zigzag(BitStream* stream, int64_t value, uint8_t bit_count);
+BitStreamResult bit_stream_write_zigzag_i128(BitStream* stream, Int128 value, uint8_t bit_count);
+BitStreamResult bit_stream_read_zigzag_batch(BitStream* stream, int64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_write_zigzag_batch(BitStream* stream, const int64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_zigzag(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_zigzag_i128(BitStreamReader* reader, uint8_t bit_count);
+BitStreamResult bit_stream_reader_read_zigzag_batch(BitStreamReader* reader, int64_t* values, size_t count, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_zigzag(BitStreamWriter* writer, int64_t value, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_zigzag_i128(BitStreamWriter* writer, Int128 value, uint8_t bit_count);
+BitStreamResult bit_stream_writer_write_zigzag_batch(BitStreamWriter* writer, const int64_t* values, size_t count, uint8_t bit_count);
+
+// Universal code functions; Elias gamma and delta code values >= 1, k-th
+// order Exp-Golomb codes values >= 0. Codes are laid out MSB first, and the
+// reader/writer variants produce the same bytes as the BitStream ones.
+BitStreamResult bit_stream_write_elias_gamma(BitStream* stream, uint64_t value);
+BitStreamResult bit_stream_read_elias_gamma(BitStream* stream);
+BitStreamResult bit_stream_write_elias_delta(BitStream* stream, uint64_t value);
+BitStreamResult bit_stream_read_elias_delta(BitStream* stream);
+BitStreamResult bit_stream_write_exp_golomb(BitStream* stream, uint64_t value, uint8_t k);
+BitStreamResult bit_stream_read_exp_golomb(BitStream* stream, uint8_t k);
+BitStreamResult bit_stream_write_elias_gamma_batch(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_elias_gamma_batch(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_elias_delta_batch(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_elias_delta_batch(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_exp_golomb_batch(BitStream* stream, const uint64_t* values, size_t count, uint8_t k);
+BitStreamResult bit_stream_read_exp_golomb_batch(BitStream* stream, uint64_t* values, size_t count, uint8_t k);
+BitStreamResult bit_stream_reader_read_elias_gamma(BitStreamReader* reader);
+BitStreamResult bit_stream_reader_read_elias_delta(BitStreamReader* reader);
+BitStreamResult bit_stream_reader_read_exp_golomb(BitStreamReader* reader, uint8_t k);
+BitStreamResult bit_stream_reader_read_elias_gamma_batch(BitStreamReader* reader, uint64_t* values, size_t count);
+BitStreamResult bit_stream_reader_read_elias_delta_batch(BitStreamReader* reader, uint64_t* values, size_t count);
+BitStreamResult bit_stream_reader_read_exp_golomb_batch(BitStreamReader* reader, uint64_t* values, size_t count, uint8_t k);
+BitStreamResult bit_stream_writer_write_elias_gamma(BitStreamWriter* writer, uint64_t value);
+BitStreamResult bit_stream_writer_write_elias_delta(BitStreamWriter* writer, uint64_t value);
+BitStreamResult bit_stream_writer_write_exp_golomb(BitStreamWriter* writer, uint64_t value, uint8_t k);
+BitStreamResult bit_stream_writer_write_elias_gamma_batch(BitStreamWriter* writer, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_writer_write_elias_delta_batch(BitStreamWriter* writer, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_writer_write_exp_golomb_batch(BitStreamWriter* writer, const uint64_t* values, size_t count, uint8_t k);
+
+// Rice code functions; a value is its quotient value >> k in unary (zeros
+// closed by a one) followed by its low k bits, with large quotients escaped
+// to a raw 64-bit value. Blocks store the k chosen from the block's mean.
+uint8_t rice_select_k(const uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_rice(BitStream* stream, uint64_t value, uint8_t k);
+BitStreamResult bit_stream_read_rice(BitStream* stream, uint8_t k);
+BitStreamResult bit_stream_write_rice_block(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_rice_block(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_reader_read_rice(BitStreamReader* reader, uint8_t k);
+BitStreamResult bit_stream_reader_read_rice_block(BitStreamReader* reader, uint64_t* values, size_t count);
+BitStreamResult bit_stream_writer_write_rice(BitStreamWriter* writer, uint64_t value, uint8_t k);
+BitStreamResult bit_stream_writer_write_rice_block(BitStreamWriter* writer, const uint64_t* values, size_t count);
+
+// Varint functions; LEB128 is the protobuf varint, Stream-VByte codes
+// 32-bit values as 2-bit lengths in control bytes followed by the value
+// bytes. On a BitStream both start at the next byte boundary.
+#define LEB128_MAX_BYTES 10
+size_t leb128_encode_u64(uint64_t value, uint8_t* bytes);
+size_t leb128_decode_u64(const uint8_t* bytes, size_t length, uint64_t* value);
+size_t stream_vbyte_max_encoded_length(size_t count);
+size_t stream_vbyte_encode(const uint32_t* values, size_t count, uint8_t* bytes);
+size_t stream_vbyte_decode(const uint8_t* bytes, size_t length, uint32_t* values, size_t count);
+BitStreamResult bit_stream_write_varint(BitStream* stream, uint64_t value);
+BitStreamResult bit_stream_read_varint(BitStream* stream);
+BitStreamResult bit_stream_write_varint_signed(BitStream* stream, int64_t value);
+BitStreamResult bit_stream_read_varint_signed(BitStream* stream);
+BitStreamResult bit_stream_write_varint_batch(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_varint_batch(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_stream_vbyte(BitStream* stream, const uint32_t* values, size_t count);
+BitStreamResult bit_stream_read_stream_vbyte(BitStream* stream, uint32_t* values, size_t count);
+
+// Frame-of-reference block functions; a block stores its minimum and a bit
+// width, then packs each value minus the minimum at that width. FOR blocks
+// use the width of the widest residual; PFOR blocks pick the width that
+// minimises the block and list the residuals that do not fit as
+// exceptions. The unsized forms split values into blocks of
+// BIT_STREAM_BLOCK_VALUES, and a reader must ask for the same count.
+#define BIT_STREAM_BLOCK_VALUES 128
+#define BIT_STREAM_BLOCK_MAX_VALUES 256
+void bit_stream_block_range(const uint64_t* values, size_t count, uint64_t* min, uint64_t* max);
+BitStreamResult bit_stream_write_for_block(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_for_block(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_for(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_for(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_pfor_block(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_pfor_block(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_pfor(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_pfor(BitStream* stream, uint64_t* values, size_t count);
+
+// Delta functions; columns are stored as their first value and the
+// ZigZag-mapped differences (or differences of differences) between
+// neighbours, packed as frame-of-reference blocks. Differences wrap modulo
+// 2^64, so signed columns can be passed as their two's complement bits.
+void prefix_sum_u64(uint64_t* values, size_t count, uint64_t initial);
+BitStreamResult bit_stream_write_delta(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_delta(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_delta_of_delta(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_delta_of_delta(BitStream* stream, uint64_t* values, size_t count);
+
+// Simple-8b functions; each 64-bit word holds a 4-bit selector and as many
+// equal-width values below 2^60 as fit in its other 60 bits. Unpacking a
+// word writes up to SIMPLE8B_MAX_WORD_VALUES values.
+#define SIMPLE8B_MAX_WORD_VALUES 240
+size_t simple8b_pack_word(const uint64_t* values, size_t count, uint64_t* word);
+size_t simple8b_unpack_word(uint64_t word, uint64_t* values);
+BitStreamResult bit_stream_write_simple8b(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_simple8b(BitStream* stream, uint64_t* values, size_t count);
+
+// Huffman functions; canonical codes over byte symbols with lengths limited
+// to HUFFMAN_MAX_CODE_LENGTH bits. A table header carries the code lengths,
+// and reading one allocates a code the caller frees. Decoding looks up the
+// next HUFFMAN_MAX_CODE_LENGTH bits and yields up to two symbols at once.
+// huffman_code_from_histogram returns NULL if the symbols are too many, the
+// memory runs out or the lengths do not form a code.
+#define HUFFMAN_MAX_SYMBOLS 256
+#define HUFFMAN_MAX_CODE_LENGTH 12
+typedef struct HuffmanCode HuffmanCode;
+HuffmanCode* huffman_code_from_histogram(const uint64_t* histogram, size_t symbol_count);
+void huffman_code_free(HuffmanCode* code);
+uint8_t huffman_code_length(const HuffmanCode* code, uint8_t symbol);
+BitStreamResult bit_stream_write_huffman_table(BitStream* stream, const HuffmanCode* code);
+BitStreamResult bit_stream_read_huffman_table(BitStream* stream, HuffmanCode** code);
+BitStreamResult bit_stream_write_huffman(BitStream* stream, const HuffmanCode* code, const uint8_t* symbols, size_t count);
+BitStreamResult bit_stream_read_huffman(BitStream* stream, const HuffmanCode* code, uint8_t* symbols, size_t count);
+BitStreamResult bit_stream_reader_read_huffman_table(BitStreamReader* reader, HuffmanCode** code);
+BitStreamResult bit_stream_reader_read_huffman(BitStreamReader* reader, const HuffmanCode* code, uint8_t* symbols, size_t count);
+BitStreamResult bit_stream_writer_write_huffman_table(BitStreamWriter* writer, const HuffmanCode* code);
+BitStreamResult bit_stream_writer_write_huffman(BitStreamWriter* writer, const HuffmanCode* code, const uint8_t* symbols, size_t count);
+
+// tANS functions; table-based asymmetric numeral systems over byte symbols
+// with counts normalized to 2^table_log. The payload is written forward and
+// read backward: position a BitStream at its end, or seek a reader to the
+// end of its file, before reading symbols. The table header is read forward.
+#define TANS_MAX_SYMBOLS 256
+#define TANS_MIN_TABLE_LOG 5
+#define TANS_MAX_TABLE_LOG 12
+typedef struct TansCode TansCode;
+TansCode* tans_code_from_histogram(const uint64_t* histogram, size_t symbol_count, uint8_t table_log);
+void tans_code_free(TansCode* code);
+uint16_t tans_code_normalized_count(const TansCode* code, uint8_t symbol);
+BitStreamResult bit_stream_write_tans_table(BitStream* stream, const TansCode* code);
+BitStreamResult bit_stream_read_tans_table(BitStream* stream, TansCode** code);
+BitStreamResult bit_stream_write_tans(BitStream* stream, const TansCode* code, const uint8_t* symbols, size_t count);
+BitStreamResult bit_stream_read_tans(BitStream* stream, const TansCode* code, uint8_t* symbols, size_t count);
+BitStreamResult bit_stream_reader_read_tans_table(BitStreamReader* reader, TansCode** code);
+BitStreamResult bit_stream_reader_read_tans(BitStreamReader* reader, const TansCode* code, uint8_t* symbols, size_t count);
+BitStreamResult bit_stream_writer_write_tans_table(BitStreamWriter* writer, const TansCode* code);
+BitStreamResult bit_stream_writer_write_tans(BitStreamWriter* writer, const TansCode* code, const uint8_t* symbols, size_t count);
+
+// Arithmetic coder functions; adaptive binary arithmetic coding of flags
+// with a probability state per context index. Coded bytes go to a BitStream
+// or file writer. Finishing ends the payload on its last byte, so after the
+// decoder is finished too, fields written after it read back normally.
+typedef struct ArithmeticEncoder ArithmeticEncoder;
+typedef struct ArithmeticDecoder ArithmeticDecoder;
+ArithmeticEncoder* arithmetic_encoder_new(BitStream* stream, size_t context_count);
+ArithmeticEncoder* arithmetic_encoder_new_writer(BitStreamWriter* writer, size_t context_count);
+void arithmetic_encoder_free(ArithmeticEncoder* encoder);
+BitStreamResult arithmetic_encoder_encode_flag(ArithmeticEncoder* encoder, size_t context, bool flag);
+BitStreamResult arithmetic_encoder_finish(ArithmeticEncoder* encoder);
+ArithmeticDecoder* arithmetic_decoder_new(BitStream* stream, size_t context_count);
+ArithmeticDecoder* arithmetic_decoder_new_reader(BitStreamReader* reader, size_t context_count);
+void arithmetic_decoder_free(ArithmeticDecoder* decoder);
+BitStreamResult arithmetic_decoder_decode_flag(ArithmeticDecoder* decoder, size_t context);
+BitStreamResult arithmetic_decoder_finish(ArithmeticDecoder* decoder);
+
+// RLE/bit-packing hybrid functions; Parquet's encoding for definition and
+// repetition levels and dictionary indices, for values of up to 32 bits.
+// rle_hybrid_decode returns the bytes consumed, or 0 if they are malformed
+// or too short.
+size_t rle_hybrid_max_encoded_length(size_t count, uint8_t bit_width);
+size_t rle_hybrid_encode(const uint32_t* values, size_t count, uint8_t bit_width, uint8_t* bytes);
+size_t rle_hybrid_decode(const uint8_t* bytes, size_t length, uint8_t bit_width, uint32_t* values, size_t count);
+BitStreamResult bit_stream_write_rle_hybrid(BitStream* stream, const uint32_t* values, size_t count, uint8_t bit_width);
+BitStreamResult bit_stream_read_rle_hybrid(BitStream* stream, uint32_t* values, size_t count, uint8_t bit_width);
+
+// Dictionary functions; a batch is written as a dictionary page of its
+// distinct values followed by bit-packed indices into it. The build
+// functions fill entries in order of first occurrence and indices for every
+// value, and return the entry count, or 0 when they run out of memory.
+size_t dictionary_build_u64(const uint64_t* values, size_t count, uint64_t* entries, uint64_t* indices);
+size_t dictionary_build_u128(const UInt128* values, size_t count, UInt128* entries, uint64_t* indices);
+BitStreamResult bit_stream_write_dictionary(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_dictionary(BitStream* stream, uint64_t* values, size_t count);
+BitStreamResult bit_stream_write_dictionary_u128(BitStream* stream, const UInt128* values, size_t count);
+BitStreamResult bit_stream_read_dictionary_u128(BitStream* stream, UInt128* values, size_t count);
+
+// XOR float functions; Gorilla-style compression of float and double
+// columns, where each value after the first is stored as the meaningful
+// bits of its XOR with the previous value.
+BitStreamResult bit_stream_write_xor_double(BitStream* stream, const double* values, size_t count);
+BitStreamResult bit_stream_read_xor_double(BitStream* stream, double* values, size_t count);
+BitStreamResult bit_stream_write_xor_float(BitStream* stream, const float* values, size_t count);
+BitStreamResult bit_stream_read_xor_float(BitStream* stream, float* values, size_t count);
+BitStreamResult bit_stream_reader_read_xor_double(BitStreamReader* reader, double* values, size_t count);
+BitStreamResult bit_stream_reader_read_xor_float(BitStreamReader* reader, float* values, size_t count);
+BitStreamResult bit_stream_writer_write_xor_double(BitStreamWriter* writer, const double* values, size_t count);
+BitStreamResult bit_stream_writer_write_xor_float(BitStreamWriter* writer, const float* values, size_t count);
+
+// Quantization functions; lossy fixed-point storage of float and double
+// values. quantizer_init picks the smallest bit width whose step across
+// [minimum, maximum] is at most precision; values are stored as their
+// nearest code, clamped to the range. The quantizer itself is not part of
+// the quantized data and is written separately when the reader needs it.
+#define QUANTIZE_MAX_BIT_WIDTH 32
+typedef struct {
+    double minimum;     // Value of code 0
+    double maximum;     // Value of the largest code
+    double step;        // Difference between neighbouring codes
+    double inverse;     // Codes per unit
+    uint8_t bit_width;  // Bits per code; 0 when the range is a single value
+} Quantizer;
+BitStreamResult quantizer_init(Quantizer* quantizer, double minimum, double maximum, double precision);
+void quantize_double(const Quantizer* quantizer, const double* values, uint64_t* codes, size_t count);
+void quantize_float(const Quantizer* quantizer, const float* values, uint64_t* codes, size_t count);
+void dequantize_double(const Quantizer* quantizer, const uint64_t* codes, double* values, size_t count);
+void dequantize_float(const Quantizer* quantizer, const uint64_t* codes, float* values, size_t count);
+BitStreamResult bit_stream_write_quantizer(BitStream* stream, const Quantizer* quantizer);
+BitStreamResult bit_stream_read_quantizer(BitStream* stream, Quantizer* quantizer);
+BitStreamResult bit_stream_write_quantized_double(BitStream* stream, const Quantizer* quantizer, const double* values, size_t count);
+BitStreamResult bit_stream_read_quantized_double(BitStream* stream, const Quantizer* quantizer, double* values, size_t count);
+BitStreamResult bit_stream_write_quantized_float(BitStream* stream, const Quantizer* quantizer, const float* values, size_t count);
+BitStreamResult bit_stream_read_quantized_float(BitStream* stream, const Quantizer* quantizer, float* values, size_t count);
+
+// Bit width functions; the smallest bit count that holds every value of a
+// column, as unsigned fields or as two's complement signed fields, for
+// passing to the batch read/write functions. The result is at least 1.
+uint8_t bit_width_required_u64(const uint64_t* values, size_t count);
+uint8_t bit_width_required_u32(const uint32_t* values, size_t count);
+uint8_t bit_width_required_u128(const UInt128* values, size_t count);
+uint8_t bit_width_required_i64(const int64_t* values, size_t count);
+uint8_t bit_width_required_i32(const int32_t* values, size_t count);
+uint8_t bit_width_required_i128(const Int128* values, size_t count);
+
+// Boolean array functions; booleans are written as 1-bit fields in array
+// order, packed and unpacked 64 at a time. bit_stream_popcount_range counts
+// the set bits in [start, end) of a stream, clamped to its length.
+BitStreamResult bit_stream_write_bool_array(BitStream* stream, const bool* values, size_t count);
+BitStreamResult bit_stream_read_bool_array(BitStream* stream, bool* values, size_t count);
+uint64_t bit_stream_popcount_range(const BitStream* stream, size_t start, size_t end);
+
+// Rank/select functions; an index over the bits of a stream, such as a
+// presence bitmap, that answers rank1 (the set bits before a position,
+// clamped to the length) and select1 (the position of the set bit of rank
+// k, counting from 0, or SIZE_MAX when there are not that many) without
+// scanning; select0 does the same for clear bits. Rank takes constant time,
+// as does select unless the set bits are very sparse. The index reads the
+// stream's buffer and must be rebuilt after the stream changes; it adds
+// about a quarter of the bitmap's size.
+typedef struct RankSelectIndex RankSelectIndex;
+RankSelectIndex* rank_select_index_new(const BitStream* stream);
+void rank_select_index_free(RankSelectIndex* index);
+uint64_t rank_select_index_ones(const RankSelectIndex* index);
+uint64_t rank_select_index_rank1(const RankSelectIndex* index, size_t position);
+size_t rank_select_index_select1(const RankSelectIndex* index, uint64_t k);
+size_t rank_select_index_select0(const RankSelectIndex* index, uint64_t k);
+
+// Elias-Fano functions; non-decreasing sequences such as sorted offsets or
+// IDs in close to the minimum space, about 2 + log2(last / count) bits per
+// value. The stream functions write and decode whole sequences; writing
+// fails with BIT_STREAM_ERROR_INVALID_VALUE when a value is smaller than
+// the one before it. An EliasFano sequence built from values or read from
+// a stream gives random access: elias_fano_access returns value i, which
+// must be less than the count, and elias_fano_next_geq returns the index
+// of the first value at or above a value, or the count if there is none.
+typedef struct EliasFano EliasFano;
+BitStreamResult bit_stream_write_elias_fano(BitStream* stream, const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_elias_fano(BitStream* stream, uint64_t* values, size_t count);
+EliasFano* elias_fano_from_values(const uint64_t* values, size_t count);
+BitStreamResult bit_stream_read_elias_fano_sequence(BitStream* stream, EliasFano** sequence);
+void elias_fano_free(EliasFano* sequence);
+size_t elias_fano_count(const EliasFano* sequence);
+uint64_t elias_fano_access(const EliasFano* sequence, size_t i);
+size_t elias_fano_next_geq(const EliasFano* sequence, uint64_t value);
+
+// Key functions; order-preserving fields for composite keys that sort and
+// binary-search as byte strings. Fields written in tuple order, unsigned
+// ones with bit_stream_write_bits and the rest with these functions, give
+// streams whose bytes compare with memcmp in the same order as the tuples,
+// for keys with the same field layout. bit_stream_key_compare does that
+// comparison, ordering a stream before its extensions. Signed fields have
+// their sign bit flipped; varint fields take 7 bits plus one less than the
+// value's bit width; byte strings escape 0x00 and end with a terminator.
+// bit_stream_read_key_bytes returns the length in value.u64 and fails with
+// BIT_STREAM_ERROR_INVALID_VALUE when the string exceeds capacity.
+BitStreamResult bit_stream_write_key_signed(BitStream* stream, int64_t value, uint8_t bit_count);
+BitStreamResult bit_stream_read_key_signed(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_write_key_signed_i128(BitStream* stream, Int128 value, uint8_t bit_count);
+BitStreamResult bit_stream_read_key_signed_i128(BitStream* stream, uint8_t bit_count);
+BitStreamResult bit_stream_write_key_varint(BitStream* stream, uint64_t value);
+BitStreamResult bit_stream_read_key_varint(BitStream* stream);
+BitStreamResult bit_stream_write_key_bytes(BitStream* stream, const uint8_t* bytes, size_t length);
+BitStreamResult bit_stream_read_key_bytes(BitStream* stream, uint8_t* bytes, size_t capacity);
+int bit_stream_key_compare(const BitStream* a, const BitStream* b);
+
 // UInt128/Int128 utility functions
 UInt128 uint128_from_u64(uint64_t value);
 UInt128 uint128_from_parts(uint64_t high, uint64_t low);
@@ -166,5 +597,7 @@ UInt128 uint128_xor(UInt128 a, UInt128 b);
 UInt128 uint128_not(UInt128 value);
 bool uint128_equal(UInt128 a, UInt128 b);
 int uint128_compare(UInt128 a, UInt128 b);
+int64_t int64_sign_extend(uint64_t value, uint8_t bit_count);
+Int128 int128_sign_extend(UInt128 value, uint8_t bit_count);
 
 #endif /* BIT_STREAM_H */
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "bit_stream.h"
+
+// Adaptive binary arithmetic coder. Each context holds the probability that
+// its next flag is 1 as a 16-bit fraction, moved 1/32 of the way towards
+// every coded flag, so skewed flags cost a small fraction of a bit once the
+// context has adapted. The coder keeps a 32-bit interval [low, high] and
+// emits a byte whenever the top bytes of both ends agree, which keeps it
+// free of carries. finish emits all four bytes of low, so the decoder, which
+// reads four bytes ahead, stops exactly at the end of the payload.
+
+#define ARITHMETIC_PROBABILITY_BITS 16
+#define ARITHMETIC_ADAPT_SHIFT 5
+#define ARITHMETIC_INITIAL_PROBABILITY (1U << (ARITHMETIC_PROBABILITY_BITS - 1))
+#define ARITHMETIC_TOP_MASK 0xFF000000U
+
+struct ArithmeticEncoder {
+    BitStream* stream;        // Output when coding into a BitStream
+    BitStreamWriter* writer;  // Output when coding into a file writer
+    uint16_t* probabilities;
+    size_t context_count;
+    uint32_t low;
+    uint32_t high;
+};
+
+struct ArithmeticDecoder {
+    BitStream* stream;        // Input when decoding from a BitStream
+    BitStreamReader* reader;  // Input when decoding from a file reader
+    uint16_t* probabilities;
+    size_t context_count;
+    uint32_t low;
+    uint32_t high;
+    uint32_t code;
+    bool started;             // The first four bytes are loaded on first use
+};
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with a u64 value
+static BitStreamResult create_u64_result(uint64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.u64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+static uint16_t* new_probabilities(size_t context_count) {
+    uint16_t* probabilities = (uint16_t*)malloc((context_count > 0 ? context_count : 1) * sizeof(uint16_t));
+    if (probabilities != NULL) {
+        for (size_t i = 0; i < context_count; i++) {
+            probabilities[i] = ARITHMETIC_INITIAL_PROBABILITY;
+        }
+    }
+    return probabilities;
+}
+
+// Point in [low, high) splitting the interval by the probability of a 1;
+// flags of 1 take the lower part
+static inline uint32_t split_interval(uint32_t low, uint32_t high, uint16_t probability) {
+    return low + (uint32_t)(((uint64_t)(high - low) * probability) >> ARITHMETIC_PROBABILITY_BITS);
+}
+
+// The probability stays within [31, 65505], so neither part ever empties
+static inline void adapt(uint16_t* probability, bool flag) {
+    if (flag) {
+        *probability += ((1U << ARITHMETIC_PROBABILITY_BITS) - *probability) >> ARITHMETIC_ADAPT_SHIFT;
+    } else {
+        *probability -= *probability >> ARITHMETIC_ADAPT_SHIFT;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Encoder
+// ---------------------------------------------------------------------------
+
+static ArithmeticEncoder* encoder_new(BitStream* stream, BitStreamWriter* writer, size_t context_count) {
+    ArithmeticEncoder* encoder = (ArithmeticEncoder*)malloc(sizeof(ArithmeticEncoder));
+    if (encoder == NULL) {
+        return NULL;
+    }
+    
+    encoder->probabilities = new_probabilities(context_count);
+    if (encoder->probabilities == NULL) {
+        free(encoder);
+        return NULL;
+    }
+    encoder->stream = stream;
+    encoder->writer = writer;
+    encoder->context_count = context_count;
+    encoder->low = 0;
+    encoder->high = 0xFFFFFFFFU;
+    
+    return encoder;
+}
+
+ArithmeticEncoder* arithmetic_encoder_new(BitStream* stream, size_t context_count) {
+    return encoder_new(stream, NULL, context_count);
+}
+
+ArithmeticEncoder* arithmetic_encoder_new_writer(BitStreamWriter* writer, size_t context_count) {
+    return encoder_new(NULL, writer, context_count);
+}
+
+void arithmetic_encoder_free(ArithmeticEncoder* encoder) {
+    if (encoder != NULL) {
+        free(encoder->probabilities);
+        free(encoder);
+    }
+}
+
+static BitStreamResult emit_byte(ArithmeticEncoder* encoder, uint32_t byte) {
+    if (encoder->stream != NULL) {
+        return bit_stream_write_bits(encoder->stream, byte, 8);
+    }
+    return bit_stream_writer_write_bits_msb(encoder->writer, byte, 8);
+}
+
+BitStreamResult arithmetic_encoder_encode_flag(ArithmeticEncoder* encoder, size_t context, bool flag) {
+    if (context >= encoder->context_count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint16_t* probability = &encoder->probabilities[context];
+    uint32_t middle = split_interval(encoder->low, encoder->high, *probability);
+    if (flag) {
+        encoder->high = middle;
+    } else {
+        encoder->low = middle + 1;
+    }
+    adapt(probability, flag);
+    
+    // Settled top bytes are emitted
+    while (((encoder->low ^ encoder->high) & ARITHMETIC_TOP_MASK) == 0) {
+        BitStreamResult result = emit_byte(encoder, encoder->high >> 24);
+        if (!result.success) {
+            return result;
+        }
+        encoder->low <<= 8;
+        encoder->high = (encoder->high << 8) | 0xFF;
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult arithmetic_encoder_finish(ArithmeticEncoder* encoder) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        BitStreamResult result = emit_byte(encoder, (encoder->low >> shift) & 0xFF);
+        if (!result.success) {
+            return result;
+        }
+    }
+    
+    // The encoder can carry on with a fresh interval and the adapted contexts
+    encoder->low = 0;
+    encoder->high = 0xFFFFFFFFU;
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// Decoder
+// ---------------------------------------------------------------------------
+
+static ArithmeticDecoder* decoder_new(BitStream* stream, BitStreamReader* reader, size_t context_count) {
+    ArithmeticDecoder* decoder = (ArithmeticDecoder*)malloc(sizeof(ArithmeticDecoder));
+    if (decoder == NULL) {
+        return NULL;
+    }
+    
+    decoder->probabilities = new_probabilities(context_count);
+    if (decoder->probabilities == NULL) {
+        free(decoder);
+        return NULL;
+    }
+    decoder->stream = stream;
+    decoder->reader = reader;
+    decoder->context_count = context_count;
+    decoder->low = 0;
+    decoder->high = 0xFFFFFFFFU;
+    decoder->code = 0;
+    decoder->started = false;
+    
+    return decoder;
+}
+
+ArithmeticDecoder* arithmetic_decoder_new(BitStream* stream, size_t context_count) {
+    return decoder_new(stream, NULL, context_count);
+}
+
+ArithmeticDecoder* arithmetic_decoder_new_reader(BitStreamReader* reader, size_t context_count) {
+    return decoder_new(NULL, reader, context_count);
+}
+
+void arithmetic_decoder_free(ArithmeticDecoder* decoder) {
+    if (decoder != NULL) {
+        free(decoder->probabilities);
+        free(decoder);
+    }
+}
+
+static BitStreamResult next_byte(ArithmeticDecoder* decoder) {
+    if (decoder->stream != NULL) {
+        return bit_stream_read_bits(decoder->stream, 8);
+    }
+    return bit_stream_reader_read_bits_msb(decoder->reader, 8);
+}
+
+BitStreamResult arithmetic_decoder_decode_flag(ArithmeticDecoder* decoder, size_t context) {
+    if (context >= decoder->context_count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    if (!decoder->started) {
+        for (int i = 0; i < 4; i++) {
+            BitStreamResult result = next_byte(decoder);
+            if (!result.success) {
+                return result;
+            }
+            decoder->code = (decoder->code << 8) | (uint32_t)result.value.u64;
+        }
+        decoder->started = true;
+    }
+    
+    uint16_t* probability = &decoder->probabilities[context];
+    uint32_t middle = split_interval(decoder->low, decoder->high, *probability);
+    bool flag = decoder->code <= middle;
+    if (flag) {
+        decoder->high = middle;
+    } else {
+        decoder->low = middle + 1;
+    }
+    adapt(probability, flag);
+    
+    while (((decoder->low ^ decoder->high) & ARITHMETIC_TOP_MASK) == 0) {
+        BitStreamResult result = next_byte(decoder);
+        if (!result.success) {
+            return result;
+        }
+        decoder->low <<= 8;
+        decoder->high = (decoder->high << 8) | 0xFF;
+        decoder->code = (decoder->code << 8) | (uint32_t)result.value.u64;
+    }
+    
+    return create_u64_result(flag);
+}
+
+BitStreamResult arithmetic_decoder_finish(ArithmeticDecoder* decoder) {
+    // Mirrors the encoder: the payload has been read to its last byte, unless
+    // no flag was decoded and the four bytes of an empty group are still
+    // unread
+    if (!decoder->started) {
+        for (int i = 0; i < 4; i++) {
+            BitStreamResult result = next_byte(decoder);
+            if (!result.success) {
+                return result;
+            }
+        }
+    }
+    
+    decoder->low = 0;
+    decoder->high = 0xFFFFFFFFU;
+    decoder->code = 0;
+    decoder->started = false;
+    return create_success_result();
+}
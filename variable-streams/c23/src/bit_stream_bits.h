@@ -0,0 +1,109 @@
+#ifndef BIT_STREAM_BITS_H
+#define BIT_STREAM_BITS_H
+
+// Internal bit manipulation helpers shared by the codecs. These map onto
+// single instructions (lzcnt/bsr, tzcnt/bsf, popcnt, bswap) where the
+// compiler provides builtins and fall back to portable loops otherwise.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Count of leading zero bits; value must be non-zero
+static inline unsigned bit_stream_clz64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clzll(value);
+#else
+    unsigned count = 0;
+    while ((value & 0x8000000000000000ULL) == 0) {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Count of trailing zero bits; value must be non-zero
+static inline unsigned bit_stream_ctz64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(value);
+#else
+    unsigned count = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Number of set bits
+static inline unsigned bit_stream_popcount64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcountll(value);
+#else
+    unsigned count = 0;
+    while (value != 0) {
+        value &= value - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Number of bits needed to represent value; 0 for 0
+static inline unsigned bit_stream_bit_width64(uint64_t value) {
+    return (value == 0) ? 0 : 64 - bit_stream_clz64(value);
+}
+
+// Loads 8 bytes as a big-endian word; compilers fold this into one load
+static inline uint64_t bit_stream_load_be64(const uint8_t* bytes) {
+    return ((uint64_t)bytes[0] << 56) | ((uint64_t)bytes[1] << 48) |
+           ((uint64_t)bytes[2] << 40) | ((uint64_t)bytes[3] << 32) |
+           ((uint64_t)bytes[4] << 24) | ((uint64_t)bytes[5] << 16) |
+           ((uint64_t)bytes[6] << 8) | (uint64_t)bytes[7];
+}
+
+// Loads 8 bytes as a little-endian word; compilers fold this into one load
+static inline uint64_t bit_stream_load_le64(const uint8_t* bytes) {
+    return (uint64_t)bytes[0] | ((uint64_t)bytes[1] << 8) |
+           ((uint64_t)bytes[2] << 16) | ((uint64_t)bytes[3] << 24) |
+           ((uint64_t)bytes[4] << 32) | ((uint64_t)bytes[5] << 40) |
+           ((uint64_t)bytes[6] << 48) | ((uint64_t)bytes[7] << 56);
+}
+
+// Next 64 bits in MSB-first stream order starting bit_offset (0-7) bits into
+// bytes, where length bytes are readable; bytes past the end read as zero
+static inline uint64_t bit_stream_window64(const uint8_t* bytes, size_t length, uint8_t bit_offset) {
+    uint64_t window;
+    uint8_t next;
+    if (length >= 9) {
+        window = bit_stream_load_be64(bytes);
+        next = bytes[8];
+    } else {
+        uint8_t padded[9] = {0};
+        for (size_t i = 0; i < length; i++) {
+            padded[i] = bytes[i];
+        }
+        window = bit_stream_load_be64(padded);
+        next = padded[8];
+    }
+    if (bit_offset > 0) {
+        window = (window << bit_offset) | (next >> (8 - bit_offset));
+    }
+    return window;
+}
+
+// The 64 bits that end bit_end bits into bytes, in MSB-first stream order,
+// for reading backward; bits before the start of bytes read as zero
+static inline uint64_t bit_stream_window64_before(const uint8_t* bytes, size_t length, size_t bit_end) {
+    if (bit_end >= 64) {
+        size_t start = bit_end - 64;
+        return bit_stream_window64(bytes + start / 8, length - start / 8, (uint8_t)(start % 8));
+    }
+    if (bit_end == 0) {
+        return 0;
+    }
+    return bit_stream_window64(bytes, length, 0) >> (64 - bit_end);
+}
+
+#endif /* BIT_STREAM_BITS_H */
@@ -0,0 +1,329 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+
+// Frame-of-reference blocks. Each block stores its minimum and a bit width,
+// followed by every value minus the minimum packed at that width:
+//
+//   width (7 bits) | minimum (64 bits) | count x width bits of residuals
+//
+// A plain FOR block uses the width of its largest residual; a block whose
+// values are all equal has width 0 and no residual bits. Columns whose
+// local range is much smaller than their global range get a narrow width
+// per block where a single fixed width could not.
+//
+// A patched (PFOR) block uses the same container with a width chosen to
+// minimise its size, so a few outliers no longer widen every value. The
+// bits of each residual above that width follow as an exception list:
+//
+//   exception count (9 bits) | high width (7 bits, if any exceptions) |
+//   exception positions (8 bits each) | exception high bits (high width each)
+
+#define BLOCK_WIDTH_BITS 7
+#define BLOCK_EXCEPTION_COUNT_BITS 9
+#define BLOCK_POSITION_BITS 8
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+// AVX2 only compares signed 64-bit lanes, so values are biased by the sign
+// bit to order them as unsigned
+BIT_STREAM_TARGET_AVX2
+static size_t block_range_avx2(const uint64_t* values, size_t count, uint64_t* min, uint64_t* max) {
+    if (count < 8) {
+        return 0;
+    }
+    
+    const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i lowest = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)values), bias);
+    __m256i highest = lowest;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        __m256i value = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(values + i)), bias);
+        lowest = _mm256_blendv_epi8(lowest, value, _mm256_cmpgt_epi64(lowest, value));
+        highest = _mm256_blendv_epi8(highest, value, _mm256_cmpgt_epi64(value, highest));
+    }
+    
+    uint64_t lanes_low[4];
+    uint64_t lanes_high[4];
+    _mm256_storeu_si256((__m256i*)lanes_low, _mm256_xor_si256(lowest, bias));
+    _mm256_storeu_si256((__m256i*)lanes_high, _mm256_xor_si256(highest, bias));
+    *min = lanes_low[0];
+    *max = lanes_high[0];
+    for (int lane = 1; lane < 4; lane++) {
+        *min = (lanes_low[lane] < *min) ? lanes_low[lane] : *min;
+        *max = (lanes_high[lane] > *max) ? lanes_high[lane] : *max;
+    }
+    return i;
+}
+#endif
+
+void bit_stream_block_range(const uint64_t* values, size_t count, uint64_t* min, uint64_t* max) {
+    *min = (count > 0) ? values[0] : 0;
+    *max = *min;
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = block_range_avx2(values, count, min, max);
+    }
+#endif
+    for (; i < count; i++) {
+        *min = (values[i] < *min) ? values[i] : *min;
+        *max = (values[i] > *max) ? values[i] : *max;
+    }
+}
+
+// Writes the container header and the low width bits of each residual
+static BitStreamResult write_block(BitStream* stream, const uint64_t* values, size_t count, uint64_t min, uint8_t width) {
+    BitStreamResult result = bit_stream_write_bits(stream, width, BLOCK_WIDTH_BITS);
+    if (!result.success) {
+        return result;
+    }
+    result = bit_stream_write_bits(stream, min, 64);
+    if (!result.success || width == 0 || count == 0) {
+        return result;
+    }
+    
+    uint64_t residuals[BIT_STREAM_BLOCK_MAX_VALUES];
+    for (size_t i = 0; i < count; i++) {
+        residuals[i] = values[i] - min;
+    }
+    return bit_stream_write_bits_batch(stream, residuals, count, width);
+}
+
+// Reads the container header and unpacks the residuals into values; the
+// minimum is left for the caller to add once any exceptions are patched
+static BitStreamResult read_block(BitStream* stream, uint64_t* values, size_t count, uint64_t* min, uint8_t* width) {
+    if (count > BIT_STREAM_BLOCK_MAX_VALUES) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    BitStreamResult result = bit_stream_read_bits(stream, BLOCK_WIDTH_BITS);
+    if (!result.success) {
+        return result;
+    }
+    *width = (uint8_t)result.value.u64;
+    if (*width > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    result = bit_stream_read_bits(stream, 64);
+    if (!result.success) {
+        return result;
+    }
+    *min = result.value.u64;
+    
+    if (*width == 0) {
+        memset(values, 0, count * sizeof(uint64_t));
+        return create_success_result();
+    }
+    return bit_stream_read_bits_batch(stream, values, count, *width);
+}
+
+static void add_min(uint64_t* values, size_t count, uint64_t min) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] += min;
+    }
+}
+
+BitStreamResult bit_stream_write_for_block(BitStream* stream, const uint64_t* values, size_t count) {
+    if (count > BIT_STREAM_BLOCK_MAX_VALUES) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint64_t min;
+    uint64_t max;
+    bit_stream_block_range(values, count, &min, &max);
+    return write_block(stream, values, count, min, (uint8_t)bit_stream_bit_width64(max - min));
+}
+
+BitStreamResult bit_stream_read_for_block(BitStream* stream, uint64_t* values, size_t count) {
+    uint64_t min;
+    uint8_t width;
+    BitStreamResult result = read_block(stream, values, count, &min, &width);
+    if (!result.success) {
+        return result;
+    }
+    add_min(values, count, min);
+    return create_success_result();
+}
+
+// Picks the packed width that minimises the block size, counting each
+// residual wider than it as an exception
+static uint8_t pfor_select_width(const uint64_t* values, size_t count, uint64_t min, uint8_t* high_width) {
+    size_t width_counts[65] = {0};
+    for (size_t i = 0; i < count; i++) {
+        width_counts[bit_stream_bit_width64(values[i] - min)]++;
+    }
+    
+    unsigned max_width = 64;
+    while (max_width > 0 && width_counts[max_width] == 0) {
+        max_width--;
+    }
+    
+    // Walk widths downwards, growing the set of residuals that no longer fit
+    size_t exceptions = 0;
+    size_t best_size = count * max_width;
+    unsigned best_width = max_width;
+    for (unsigned width = max_width; width-- > 0;) {
+        exceptions += width_counts[width + 1];
+        size_t size = count * width + BLOCK_WIDTH_BITS + exceptions * (BLOCK_POSITION_BITS + max_width - width);
+        if (size < best_size) {
+            best_size = size;
+            best_width = width;
+        }
+    }
+    
+    *high_width = (uint8_t)(max_width - best_width);
+    return (uint8_t)best_width;
+}
+
+BitStreamResult bit_stream_write_pfor_block(BitStream* stream, const uint64_t* values, size_t count) {
+    if (count > BIT_STREAM_BLOCK_MAX_VALUES) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint64_t min;
+    uint64_t max;
+    bit_stream_block_range(values, count, &min, &max);
+    uint8_t high_width;
+    uint8_t width = pfor_select_width(values, count, min, &high_width);
+    
+    BitStreamResult result = write_block(stream, values, count, min, width);
+    if (!result.success) {
+        return result;
+    }
+    
+    uint64_t highs[BIT_STREAM_BLOCK_MAX_VALUES];
+    uint64_t positions[BIT_STREAM_BLOCK_MAX_VALUES];
+    size_t exceptions = 0;
+    if (high_width > 0) {
+        for (size_t i = 0; i < count; i++) {
+            uint64_t high = (values[i] - min) >> width;
+            if (high != 0) {
+                positions[exceptions] = i;
+                highs[exceptions++] = high;
+            }
+        }
+    }
+    
+    result = bit_stream_write_bits(stream, exceptions, BLOCK_EXCEPTION_COUNT_BITS);
+    if (!result.success || exceptions == 0) {
+        return result;
+    }
+    result = bit_stream_write_bits(stream, high_width, BLOCK_WIDTH_BITS);
+    if (!result.success) {
+        return result;
+    }
+    result = bit_stream_write_bits_batch(stream, positions, exceptions, BLOCK_POSITION_BITS);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_write_bits_batch(stream, highs, exceptions, high_width);
+}
+
+BitStreamResult bit_stream_read_pfor_block(BitStream* stream, uint64_t* values, size_t count) {
+    uint64_t min;
+    uint8_t width;
+    BitStreamResult result = read_block(stream, values, count, &min, &width);
+    if (!result.success) {
+        return result;
+    }
+    
+    result = bit_stream_read_bits(stream, BLOCK_EXCEPTION_COUNT_BITS);
+    if (!result.success) {
+        return result;
+    }
+    size_t exceptions = result.value.u64;
+    if (exceptions > 0) {
+        result = bit_stream_read_bits(stream, BLOCK_WIDTH_BITS);
+        if (!result.success) {
+            return result;
+        }
+        uint8_t high_width = (uint8_t)result.value.u64;
+        if (exceptions > count || high_width == 0 || width + high_width > 64) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        
+        uint64_t positions[BIT_STREAM_BLOCK_MAX_VALUES];
+        uint64_t highs[BIT_STREAM_BLOCK_MAX_VALUES];
+        result = bit_stream_read_bits_batch(stream, positions, exceptions, BLOCK_POSITION_BITS);
+        if (!result.success) {
+            return result;
+        }
+        result = bit_stream_read_bits_batch(stream, highs, exceptions, high_width);
+        if (!result.success) {
+            return result;
+        }
+        
+        // Patch the high bits in over the unpacked low bits
+        for (size_t i = 0; i < exceptions; i++) {
+            if (positions[i] >= count) {
+                return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+            }
+            values[positions[i]] |= highs[i] << width;
+        }
+    }
+    
+    add_min(values, count, min);
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_for(BitStream* stream, const uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        BitStreamResult result = bit_stream_write_for_block(stream, values + i, block);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_for(BitStream* stream, uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        BitStreamResult result = bit_stream_read_for_block(stream, values + i, block);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_pfor(BitStream* stream, const uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        BitStreamResult result = bit_stream_write_pfor_block(stream, values + i, block);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_pfor(BitStream* stream, uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        BitStreamResult result = bit_stream_read_pfor_block(stream, values + i, block);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
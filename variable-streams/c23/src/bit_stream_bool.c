@@ -0,0 +1,209 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+
+// Boolean arrays as 1-bit fields. Each run of 64 booleans is gathered into
+// one word, first element in the most significant bit, and the words are
+// written with the 64-bit batch kernel; a shorter tail goes out as a single
+// field. With AVX2, 32 booleans become a mask in one compare and movemask
+// after their bytes are reversed, and a mask is spread back to 32 bytes
+// with a shuffle and compare.
+
+// Words gathered per batch call
+#define BOOL_CHUNK_WORDS 64
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+// Reverses the 32 bytes of a register, so movemask puts element 0 on top
+BIT_STREAM_TARGET_AVX2
+static inline __m256i reverse_bytes_avx2(__m256i bytes) {
+    const __m256i reverse = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(bytes, reverse), 0x4E);
+}
+
+// Packs 32 booleans, element 0 in bit 31
+BIT_STREAM_TARGET_AVX2
+static inline uint32_t pack32_avx2(const bool* values) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i*)values);
+    __m256i is_false = _mm256_cmpeq_epi8(reverse_bytes_avx2(bytes), _mm256_setzero_si256());
+    return ~(uint32_t)_mm256_movemask_epi8(is_false);
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t pack_words_avx2(const bool* values, size_t word_count, uint64_t* words) {
+    for (size_t w = 0; w < word_count; w++) {
+        words[w] = ((uint64_t)pack32_avx2(values + 64 * w) << 32) | pack32_avx2(values + 64 * w + 32);
+    }
+    return word_count;
+}
+
+// Spreads 32 mask bits, element 0 in bit 31, to bytes of 0 or 1. Byte j
+// takes the mask byte holding bit 31 - j and tests its own bit of it.
+BIT_STREAM_TARGET_AVX2
+static inline void unpack32_avx2(uint32_t mask, bool* values) {
+    const __m256i spread = _mm256_setr_epi8(
+        3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2,
+        1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i select = _mm256_set1_epi64x((long long)0x0102040810204080ULL);
+    __m256i bytes = _mm256_shuffle_epi8(_mm256_set1_epi32((int)mask), spread);
+    __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, select), select);
+    _mm256_storeu_si256((__m256i*)values, _mm256_and_si256(set, _mm256_set1_epi8(1)));
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t unpack_words_avx2(const uint64_t* words, size_t word_count, bool* values) {
+    for (size_t w = 0; w < word_count; w++) {
+        unpack32_avx2((uint32_t)(words[w] >> 32), values + 64 * w);
+        unpack32_avx2((uint32_t)words[w], values + 64 * w + 32);
+    }
+    return word_count;
+}
+
+// Counts the bits of length bytes 32 at a time with a nibble lookup and sums
+// the byte counts with sad; returns the number of bytes done
+BIT_STREAM_TARGET_AVX2
+static size_t popcount_bytes_avx2(const uint8_t* bytes, size_t length, uint64_t* count) {
+    const __m256i table = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(bytes + i));
+        __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(chunk, low_nibble));
+        __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), low_nibble));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    *count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    return i;
+}
+#endif
+
+static void pack_words(const bool* values, size_t word_count, uint64_t* words) {
+    size_t w = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        w = pack_words_avx2(values, word_count, words);
+    }
+#endif
+    for (; w < word_count; w++) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j++) {
+            word = (word << 1) | (values[64 * w + j] ? 1 : 0);
+        }
+        words[w] = word;
+    }
+}
+
+static void unpack_words(const uint64_t* words, size_t word_count, bool* values) {
+    size_t w = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        w = unpack_words_avx2(words, word_count, values);
+    }
+#endif
+    for (; w < word_count; w++) {
+        for (size_t j = 0; j < 64; j++) {
+            values[64 * w + j] = (words[w] >> (63 - j)) & 1;
+        }
+    }
+}
+
+BitStreamResult bit_stream_write_bool_array(BitStream* stream, const bool* values, size_t count) {
+    uint64_t words[BOOL_CHUNK_WORDS];
+    size_t whole_words = count / 64;
+    for (size_t w = 0; w < whole_words; w += BOOL_CHUNK_WORDS) {
+        size_t chunk = (whole_words - w < BOOL_CHUNK_WORDS) ? whole_words - w : BOOL_CHUNK_WORDS;
+        pack_words(values + 64 * w, chunk, words);
+        BitStreamResult result = bit_stream_write_bits_batch(stream, words, chunk, 64);
+        if (!result.success) {
+            return result;
+        }
+    }
+    
+    size_t tail = count % 64;
+    if (tail == 0) {
+        return create_success_result();
+    }
+    uint64_t word = 0;
+    for (size_t i = count - tail; i < count; i++) {
+        word = (word << 1) | (values[i] ? 1 : 0);
+    }
+    return bit_stream_write_bits(stream, word, (uint8_t)tail);
+}
+
+BitStreamResult bit_stream_read_bool_array(BitStream* stream, bool* values, size_t count) {
+    uint64_t words[BOOL_CHUNK_WORDS];
+    size_t whole_words = count / 64;
+    for (size_t w = 0; w < whole_words; w += BOOL_CHUNK_WORDS) {
+        size_t chunk = (whole_words - w < BOOL_CHUNK_WORDS) ? whole_words - w : BOOL_CHUNK_WORDS;
+        BitStreamResult result = bit_stream_read_bits_batch(stream, words, chunk, 64);
+        if (!result.success) {
+            return result;
+        }
+        unpack_words(words, chunk, values + 64 * w);
+    }
+    
+    size_t tail = count % 64;
+    if (tail == 0) {
+        return create_success_result();
+    }
+    BitStreamResult result = bit_stream_read_bits(stream, (uint8_t)tail);
+    if (!result.success) {
+        return result;
+    }
+    for (size_t j = 0; j < tail; j++) {
+        values[count - tail + j] = (result.value.u64 >> (tail - 1 - j)) & 1;
+    }
+    return create_success_result();
+}
+
+static uint64_t popcount_bytes(const uint8_t* bytes, size_t length) {
+    uint64_t count = 0;
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = popcount_bytes_avx2(bytes, length, &count);
+    }
+#endif
+    for (; i + 8 <= length; i += 8) {
+        count += bit_stream_popcount64(bit_stream_load_le64(bytes + i));
+    }
+    for (; i < length; i++) {
+        count += bit_stream_popcount64(bytes[i]);
+    }
+    return count;
+}
+
+uint64_t bit_stream_popcount_range(const BitStream* stream, size_t start, size_t end) {
+    end = (end < stream->bit_length) ? end : stream->bit_length;
+    if (start >= end) {
+        return 0;
+    }
+    
+    // Partial bytes at either end are masked, whole bytes counted in bulk
+    size_t first = start / 8;
+    size_t last = (end - 1) / 8;
+    uint8_t head_mask = (uint8_t)(0xFF >> (start % 8));
+    uint8_t tail_mask = (uint8_t)(0xFF << (7 - (end - 1) % 8));
+    if (first == last) {
+        return bit_stream_popcount64(stream->buffer[first] & head_mask & tail_mask);
+    }
+    return bit_stream_popcount64(stream->buffer[first] & head_mask) +
+           popcount_bytes(stream->buffer + first + 1, last - first - 1) +
+           bit_stream_popcount64(stream->buffer[last] & tail_mask);
+}
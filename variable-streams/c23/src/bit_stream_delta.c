@@ -0,0 +1,188 @@
+#include "bit_stream.h"
+#include "bit_stream_simd.h"
+
+// Delta and delta-of-delta columns. Differences are taken modulo 2^64 and
+// ZigZag-mapped so that small changes of either sign stay small, then
+// packed as frame-of-reference blocks:
+//
+//   delta:           first value (64 bits) | FOR blocks of zigzag(v[i] - v[i-1])
+//   delta-of-delta:  first value (64 bits) | zigzag(first delta) (64 bits) |
+//                    FOR blocks of zigzag(d[i] - d[i-1])
+//
+// Each block of BIT_STREAM_BLOCK_VALUES differences is decoded in place
+// and turned back into values with a running prefix sum.
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+// Scans four lanes in register with two shifted adds, then adds the running
+// total carried in from the previous four
+BIT_STREAM_TARGET_AVX2
+static size_t prefix_sum_avx2(uint64_t* values, size_t count, uint64_t* total) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = _mm256_set1_epi64x((long long)*total);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        // [0, x0, x1, x2]
+        __m256i shifted = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), zero, 0x03);
+        x = _mm256_add_epi64(x, shifted);
+        // [0, 0, x0, x1]
+        shifted = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x40), zero, 0x0F);
+        x = _mm256_add_epi64(x, _mm256_add_epi64(shifted, carry));
+        _mm256_storeu_si256((__m256i*)(values + i), x);
+        carry = _mm256_permute4x64_epi64(x, 0xFF);
+    }
+    if (i > 0) {
+        *total = values[i - 1];
+    }
+    return i;
+}
+#endif
+
+void prefix_sum_u64(uint64_t* values, size_t count, uint64_t initial) {
+    uint64_t total = initial;
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = prefix_sum_avx2(values, count, &total);
+    }
+#endif
+    for (; i < count; i++) {
+        total += values[i];
+        values[i] = total;
+    }
+}
+
+// Decodes count zigzag-mapped differences in blocks and sums them onto
+// initial in place
+static BitStreamResult read_differences(BitStream* stream, uint64_t* values, size_t count, uint64_t initial) {
+    uint64_t total = initial;
+    for (size_t i = 0; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        BitStreamResult result = bit_stream_read_for_block(stream, values + i, block);
+        if (!result.success) {
+            return result;
+        }
+        zigzag_decode_u64_batch(values + i, (int64_t*)(values + i), block);
+        prefix_sum_u64(values + i, block, total);
+        total = values[i + block - 1];
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_delta(BitStream* stream, const uint64_t* values, size_t count) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    BitStreamResult result = bit_stream_write_bits(stream, values[0], 64);
+    if (!result.success) {
+        return result;
+    }
+    
+    uint64_t deltas[BIT_STREAM_BLOCK_VALUES];
+    for (size_t i = 1; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        for (size_t j = 0; j < block; j++) {
+            deltas[j] = zigzag_encode_i64((int64_t)(values[i + j] - values[i + j - 1]));
+        }
+        result = bit_stream_write_for_block(stream, deltas, block);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_delta(BitStream* stream, uint64_t* values, size_t count) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    BitStreamResult result = bit_stream_read_bits(stream, 64);
+    if (!result.success) {
+        return result;
+    }
+    values[0] = result.value.u64;
+    return read_differences(stream, values + 1, count - 1, values[0]);
+}
+
+BitStreamResult bit_stream_write_delta_of_delta(BitStream* stream, const uint64_t* values, size_t count) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    BitStreamResult result = bit_stream_write_bits(stream, values[0], 64);
+    if (!result.success || count == 1) {
+        return result;
+    }
+    
+    // The first delta is stored whole so its size does not widen the
+    // first block of second differences
+    uint64_t previous_delta = values[1] - values[0];
+    result = bit_stream_write_bits(stream, zigzag_encode_i64((int64_t)previous_delta), 64);
+    if (!result.success) {
+        return result;
+    }
+    
+    uint64_t second_deltas[BIT_STREAM_BLOCK_VALUES];
+    for (size_t i = 2; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        for (size_t j = 0; j < block; j++) {
+            uint64_t delta = values[i + j] - values[i + j - 1];
+            second_deltas[j] = zigzag_encode_i64((int64_t)(delta - previous_delta));
+            previous_delta = delta;
+        }
+        result = bit_stream_write_for_block(stream, second_deltas, block);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_delta_of_delta(BitStream* stream, uint64_t* values, size_t count) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    BitStreamResult result = bit_stream_read_bits(stream, 64);
+    if (!result.success) {
+        return result;
+    }
+    values[0] = result.value.u64;
+    if (count == 1) {
+        return create_success_result();
+    }
+    
+    result = bit_stream_read_bits(stream, 64);
+    if (!result.success) {
+        return result;
+    }
+    uint64_t first_delta = (uint64_t)zigzag_decode_u64(result.value.u64);
+    
+    // Sum second differences into deltas, then deltas into values, one block
+    // at a time while it is still in cache
+    uint64_t previous_delta = first_delta;
+    uint64_t previous_value = values[0] + first_delta;
+    values[1] = previous_value;
+    for (size_t i = 2; i < count; i += BIT_STREAM_BLOCK_VALUES) {
+        size_t block = (count - i < BIT_STREAM_BLOCK_VALUES) ? count - i : BIT_STREAM_BLOCK_VALUES;
+        result = read_differences(stream, values + i, block, previous_delta);
+        if (!result.success) {
+            return result;
+        }
+        previous_delta = values[i + block - 1];
+        prefix_sum_u64(values + i, block, previous_value);
+        previous_value = values[i + block - 1];
+    }
+    return create_success_result();
+}
@@ -0,0 +1,273 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Dictionary encoding. The distinct values of a batch are collected with an
+// open-addressing hash table, in order of first occurrence, and each value
+// is replaced by its index. A batch is written as a dictionary page
+// followed by the indices:
+//
+//   entry count + 1 (Elias gamma) | entries (64 or 128 bits each) |
+//   indices (bit_width(entry count - 1) bits each)
+//
+// A single-entry dictionary needs no index bits at all.
+
+// Marks an empty hash slot
+#define DICTIONARY_EMPTY_SLOT SIZE_MAX
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+static inline uint64_t hash_u64(uint64_t value) {
+    return value * 0x9E3779B97F4A7C15ULL;
+}
+
+static inline uint64_t hash_u128(UInt128 value) {
+    return hash_u64(value.low ^ hash_u64(value.high ^ 0xD1B54A32D192ED03ULL));
+}
+
+// Allocates an empty table with at least twice as many slots as values
+static size_t* new_slots(size_t count, unsigned* shift) {
+    unsigned bits = bit_stream_bit_width64(count) + 1;
+    size_t slot_count = (size_t)1 << bits;
+    size_t* slots = (size_t*)malloc(slot_count * sizeof(size_t));
+    if (slots != NULL) {
+        for (size_t i = 0; i < slot_count; i++) {
+            slots[i] = DICTIONARY_EMPTY_SLOT;
+        }
+    }
+    *shift = 64 - bits;
+    return slots;
+}
+
+size_t dictionary_build_u64(const uint64_t* values, size_t count, uint64_t* entries, uint64_t* indices) {
+    if (count == 0) {
+        return 0;
+    }
+    unsigned shift;
+    size_t* slots = new_slots(count, &shift);
+    if (slots == NULL) {
+        return 0;
+    }
+    size_t mask = ((size_t)1 << (64 - shift)) - 1;
+    
+    size_t entry_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = (size_t)(hash_u64(values[i]) >> shift);
+        while (slots[slot] != DICTIONARY_EMPTY_SLOT && entries[slots[slot]] != values[i]) {
+            slot = (slot + 1) & mask;
+        }
+        if (slots[slot] == DICTIONARY_EMPTY_SLOT) {
+            slots[slot] = entry_count;
+            entries[entry_count++] = values[i];
+        }
+        indices[i] = slots[slot];
+    }
+    
+    free(slots);
+    return entry_count;
+}
+
+size_t dictionary_build_u128(const UInt128* values, size_t count, UInt128* entries, uint64_t* indices) {
+    if (count == 0) {
+        return 0;
+    }
+    unsigned shift;
+    size_t* slots = new_slots(count, &shift);
+    if (slots == NULL) {
+        return 0;
+    }
+    size_t mask = ((size_t)1 << (64 - shift)) - 1;
+    
+    size_t entry_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = (size_t)(hash_u128(values[i]) >> shift);
+        while (slots[slot] != DICTIONARY_EMPTY_SLOT && !uint128_equal(entries[slots[slot]], values[i])) {
+            slot = (slot + 1) & mask;
+        }
+        if (slots[slot] == DICTIONARY_EMPTY_SLOT) {
+            slots[slot] = entry_count;
+            entries[entry_count++] = values[i];
+        }
+        indices[i] = slots[slot];
+    }
+    
+    free(slots);
+    return entry_count;
+}
+
+static inline uint8_t index_width(size_t entry_count) {
+    return (uint8_t)bit_stream_bit_width64(entry_count - 1);
+}
+
+// Writes the indices with the batch kernel; nothing for a single entry
+static BitStreamResult write_indices(BitStream* stream, const uint64_t* indices, size_t count, size_t entry_count) {
+    uint8_t width = index_width(entry_count);
+    if (width == 0 || count == 0) {
+        return create_success_result();
+    }
+    return bit_stream_write_bits_batch(stream, indices, count, width);
+}
+
+// Reads the indices, checking each against the dictionary size
+static BitStreamResult read_indices(BitStream* stream, uint64_t* indices, size_t count, size_t entry_count) {
+    uint8_t width = index_width(entry_count);
+    if (width == 0) {
+        memset(indices, 0, count * sizeof(uint64_t));
+        return create_success_result();
+    }
+    BitStreamResult result = bit_stream_read_bits_batch(stream, indices, count, width);
+    if (!result.success) {
+        return result;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (indices[i] >= entry_count) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+    }
+    return create_success_result();
+}
+
+// Reads the entry count of a dictionary page, which may not exceed the
+// number of values it serves
+static BitStreamResult read_entry_count(BitStream* stream, size_t count, size_t* entry_count) {
+    BitStreamResult result = bit_stream_read_elias_gamma(stream);
+    if (!result.success) {
+        return result;
+    }
+    uint64_t entries = result.value.u64 - 1;
+    if (entries > count || (entries == 0) != (count == 0)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    *entry_count = (size_t)entries;
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_dictionary(BitStream* stream, const uint64_t* values, size_t count) {
+    uint64_t* entries = (uint64_t*)malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    uint64_t* indices = (uint64_t*)malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    if (entries == NULL || indices == NULL) {
+        free(entries);
+        free(indices);
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    
+    size_t entry_count = dictionary_build_u64(values, count, entries, indices);
+    BitStreamResult result = create_error_result(BIT_STREAM_ERROR_IO);
+    if (entry_count > 0 || count == 0) {
+        result = bit_stream_write_elias_gamma(stream, (uint64_t)entry_count + 1);
+    }
+    for (size_t i = 0; i < entry_count && result.success; i++) {
+        result = bit_stream_write_bits(stream, entries[i], 64);
+    }
+    if (result.success) {
+        result = write_indices(stream, indices, count, entry_count);
+    }
+    
+    free(entries);
+    free(indices);
+    return result;
+}
+
+BitStreamResult bit_stream_read_dictionary(BitStream* stream, uint64_t* values, size_t count) {
+    size_t entry_count;
+    BitStreamResult result = read_entry_count(stream, count, &entry_count);
+    if (!result.success || count == 0) {
+        return result;
+    }
+    
+    uint64_t* entries = (uint64_t*)malloc(entry_count * sizeof(uint64_t));
+    if (entries == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    for (size_t i = 0; i < entry_count && result.success; i++) {
+        result = bit_stream_read_bits(stream, 64);
+        entries[i] = result.value.u64;
+    }
+    
+    // The indices are looked up in place
+    if (result.success) {
+        result = read_indices(stream, values, count, entry_count);
+    }
+    if (result.success) {
+        for (size_t i = 0; i < count; i++) {
+            values[i] = entries[values[i]];
+        }
+    }
+    
+    free(entries);
+    return result;
+}
+
+BitStreamResult bit_stream_write_dictionary_u128(BitStream* stream, const UInt128* values, size_t count) {
+    UInt128* entries = (UInt128*)malloc((count > 0 ? count : 1) * sizeof(UInt128));
+    uint64_t* indices = (uint64_t*)malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    if (entries == NULL || indices == NULL) {
+        free(entries);
+        free(indices);
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    
+    size_t entry_count = dictionary_build_u128(values, count, entries, indices);
+    BitStreamResult result = create_error_result(BIT_STREAM_ERROR_IO);
+    if (entry_count > 0 || count == 0) {
+        result = bit_stream_write_elias_gamma(stream, (uint64_t)entry_count + 1);
+    }
+    for (size_t i = 0; i < entry_count && result.success; i++) {
+        result = bit_stream_write_bits_u128(stream, entries[i], 128);
+    }
+    if (result.success) {
+        result = write_indices(stream, indices, count, entry_count);
+    }
+    
+    free(entries);
+    free(indices);
+    return result;
+}
+
+BitStreamResult bit_stream_read_dictionary_u128(BitStream* stream, UInt128* values, size_t count) {
+    size_t entry_count;
+    BitStreamResult result = read_entry_count(stream, count, &entry_count);
+    if (!result.success || count == 0) {
+        return result;
+    }
+    
+    UInt128* entries = (UInt128*)malloc(entry_count * sizeof(UInt128));
+    uint64_t* indices = (uint64_t*)malloc(count * sizeof(uint64_t));
+    if (entries == NULL || indices == NULL) {
+        free(entries);
+        free(indices);
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    for (size_t i = 0; i < entry_count && result.success; i++) {
+        result = bit_stream_read_bits_u128(stream, 128);
+        entries[i] = result.value.u128;
+    }
+    
+    if (result.success) {
+        result = read_indices(stream, indices, count, entry_count);
+    }
+    if (result.success) {
+        for (size_t i = 0; i < count; i++) {
+            values[i] = entries[indices[i]];
+        }
+    }
+    
+    free(entries);
+    free(indices);
+    return result;
+}
@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bit_stream.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// Group commit: every caller of bit_stream_group_commit_sync takes a ticket
+// after its data has been handed to the kernel. The first caller that finds
+// no sync in progress becomes the leader and runs one fdatasync covering
+// every ticket issued so far; the others wait and are woken once a sync
+// covering their ticket has completed. While the group is held nobody leads,
+// so commits gather until it is released.
+struct BitStreamGroupCommit {
+    int fd;
+    pthread_mutex_t mutex;
+    pthread_cond_t durable_changed;
+    uint64_t requested;    // Last ticket handed out
+    uint64_t durable;      // Every ticket up to this one is durable
+    bool syncing;
+    bool held;
+    int sync_errno;        // Sticky: once fdatasync fails the file is suspect
+    uint64_t sync_count;
+};
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code, int io_errno) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = io_errno;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+BitStreamGroupCommit* bit_stream_group_commit_new(FILE* file) {
+    BitStreamGroupCommit* group = (BitStreamGroupCommit*)malloc(sizeof(BitStreamGroupCommit));
+    if (group == NULL) {
+        return NULL;
+    }
+    
+    if (pthread_mutex_init(&group->mutex, NULL) != 0) {
+        free(group);
+        return NULL;
+    }
+    if (pthread_cond_init(&group->durable_changed, NULL) != 0) {
+        pthread_mutex_destroy(&group->mutex);
+        free(group);
+        return NULL;
+    }
+    
+    group->fd = fileno(file);
+    group->requested = 0;
+    group->durable = 0;
+    group->syncing = false;
+    group->held = false;
+    group->sync_errno = 0;
+    group->sync_count = 0;
+    
+    return group;
+}
+
+void bit_stream_group_commit_free(BitStreamGroupCommit* group) {
+    if (group != NULL) {
+        pthread_cond_destroy(&group->durable_changed);
+        pthread_mutex_destroy(&group->mutex);
+        free(group);
+    }
+}
+
+BitStreamResult bit_stream_group_commit_sync(BitStreamGroupCommit* group) {
+    pthread_mutex_lock(&group->mutex);
+    
+    uint64_t ticket = ++group->requested;
+    
+    while (group->durable < ticket && group->sync_errno == 0) {
+        if (group->syncing || group->held) {
+            // Another caller is leading a sync, or the group is held; wait
+            pthread_cond_wait(&group->durable_changed, &group->mutex);
+            continue;
+        }
+        
+        // Lead a sync covering every ticket handed out so far
+        uint64_t target = group->requested;
+        group->syncing = true;
+        pthread_mutex_unlock(&group->mutex);
+        
+        int rc = fdatasync(group->fd);
+        int sync_errno = (rc != 0) ? errno : 0;
+        
+        pthread_mutex_lock(&group->mutex);
+        group->syncing = false;
+        group->sync_count++;
+        if (sync_errno != 0) {
+            group->sync_errno = sync_errno;
+        } else {
+            group->durable = target;
+        }
+        pthread_cond_broadcast(&group->durable_changed);
+    }
+    
+    int sync_errno = group->sync_errno;
+    pthread_mutex_unlock(&group->mutex);
+    
+    if (sync_errno != 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, sync_errno);
+    }
+    return create_success_result();
+}
+
+uint64_t bit_stream_group_commit_sync_count(const BitStreamGroupCommit* group) {
+    pthread_mutex_lock((pthread_mutex_t*)&group->mutex);
+    uint64_t sync_count = group->sync_count;
+    pthread_mutex_unlock((pthread_mutex_t*)&group->mutex);
+    return sync_count;
+}
+
+void bit_stream_group_commit_hold(BitStreamGroupCommit* group) {
+    pthread_mutex_lock(&group->mutex);
+    group->held = true;
+    pthread_mutex_unlock(&group->mutex);
+}
+
+void bit_stream_group_commit_release(BitStreamGroupCommit* group) {
+    pthread_mutex_lock(&group->mutex);
+    group->held = false;
+    pthread_cond_broadcast(&group->durable_changed);
+    pthread_mutex_unlock(&group->mutex);
+}
+
+uint64_t bit_stream_group_commit_pending(const BitStreamGroupCommit* group) {
+    pthread_mutex_lock((pthread_mutex_t*)&group->mutex);
+    uint64_t pending = group->requested - group->durable;
+    pthread_mutex_unlock((pthread_mutex_t*)&group->mutex);
+    return pending;
+}
@@ -0,0 +1,399 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Elias-Fano coding of non-decreasing sequences. Each value is split into
+// its low low_width bits, packed at that width, and its high part, coded in
+// a bitmap where value i sets bit high_i + i; the bitmap is then a run of
+// zeros for each step up in the high parts, a one for each value. With
+// low_width = floor(log2(last / count)) a sequence takes at most
+// 2 + ceil(log2(last / count)) bits per value. A sequence is written as:
+//
+//   count + 1 (Elias gamma) | low_width (6 bits) | high part of the last
+//   value + 1 (Elias gamma) | low bits | high bitmap
+//
+// The bitmap has count + the high part of the last value bits and ends on
+// the one of the last value. For random access the two parts are loaded
+// into their own streams with a rank/select index over the bitmap: value i
+// is select1(i) - i above its low bits, and the first value at or above x
+// lies after the zero that closes high part (x >> low_width) - 1, found
+// with select0.
+
+#define ELIAS_FANO_LOW_WIDTH_BITS 6
+
+// Values masked or copied per batch call
+#define ELIAS_FANO_CHUNK_VALUES 256
+
+struct EliasFano {
+    size_t count;
+    uint8_t low_width;
+    BitStream* low;           // count * low_width bits
+    BitStream* high;          // High part bitmap
+    RankSelectIndex* index;   // Over high
+};
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+static bool is_non_decreasing(const uint64_t* values, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (values[i] < values[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// floor(log2(last / count)), or 0 when the values are denser than one per
+// integer
+static uint8_t choose_low_width(uint64_t last, size_t count) {
+    uint64_t spacing = last / count;
+    return (uint8_t)((spacing > 1) ? bit_stream_bit_width64(spacing) - 1 : 0);
+}
+
+static BitStreamResult write_header(BitStream* stream, size_t count, uint8_t low_width, uint64_t upper) {
+    BitStreamResult result = bit_stream_write_elias_gamma(stream, (uint64_t)count + 1);
+    if (result.success) {
+        result = bit_stream_write_bits(stream, low_width, ELIAS_FANO_LOW_WIDTH_BITS);
+    }
+    if (result.success) {
+        result = bit_stream_write_elias_gamma(stream, upper + 1);
+    }
+    return result;
+}
+
+static BitStreamResult read_header(BitStream* stream, size_t* count, uint8_t* low_width, uint64_t* upper) {
+    BitStreamResult result = bit_stream_read_elias_gamma(stream);
+    if (!result.success) {
+        return result;
+    }
+    *count = (size_t)(result.value.u64 - 1);
+    result = bit_stream_read_bits(stream, ELIAS_FANO_LOW_WIDTH_BITS);
+    if (!result.success) {
+        return result;
+    }
+    *low_width = (uint8_t)result.value.u64;
+    result = bit_stream_read_elias_gamma(stream);
+    if (!result.success) {
+        return result;
+    }
+    *upper = result.value.u64 - 1;
+    
+    // The high part of the last value cannot need more than the bits left
+    // above low_width, and an empty sequence has none
+    if ((*low_width > 0 && (*upper >> (64 - *low_width)) != 0) || (*count == 0 && *upper != 0)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return create_success_result();
+}
+
+static BitStreamResult write_low_bits(BitStream* stream, const uint64_t* values, size_t count, uint8_t low_width) {
+    if (low_width == 0) {
+        return create_success_result();
+    }
+    uint64_t chunk[ELIAS_FANO_CHUNK_VALUES];
+    uint64_t mask = UINT64_MAX >> (64 - low_width);
+    for (size_t i = 0; i < count; i += ELIAS_FANO_CHUNK_VALUES) {
+        size_t length = (count - i < ELIAS_FANO_CHUNK_VALUES) ? count - i : ELIAS_FANO_CHUNK_VALUES;
+        for (size_t j = 0; j < length; j++) {
+            chunk[j] = values[i + j] & mask;
+        }
+        BitStreamResult result = bit_stream_write_bits_batch(stream, chunk, length, low_width);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+// Writes the high part bitmap a word at a time
+static BitStreamResult write_high_bits(BitStream* stream, const uint64_t* values, size_t count, uint8_t low_width) {
+    uint64_t words[ELIAS_FANO_CHUNK_VALUES];
+    size_t word_count = 0;
+    size_t word_index = 0;
+    uint64_t word = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t position = (values[i] >> low_width) + i;
+        while (position / 64 > word_index) {
+            words[word_count++] = word;
+            word = 0;
+            word_index++;
+            if (word_count == ELIAS_FANO_CHUNK_VALUES) {
+                BitStreamResult result = bit_stream_write_bits_batch(stream, words, word_count, 64);
+                if (!result.success) {
+                    return result;
+                }
+                word_count = 0;
+            }
+        }
+        word |= 0x8000000000000000ULL >> (position % 64);
+    }
+    
+    if (word_count > 0) {
+        BitStreamResult result = bit_stream_write_bits_batch(stream, words, word_count, 64);
+        if (!result.success) {
+            return result;
+        }
+    }
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    // The bitmap ends on the one of the last value
+    uint8_t tail = (uint8_t)(((values[count - 1] >> low_width) + count - 1) % 64 + 1);
+    return bit_stream_write_bits(stream, word >> (64 - tail), tail);
+}
+
+// Moves bit_count bits from one stream to the end of another
+static BitStreamResult copy_bits(BitStream* from, BitStream* to, size_t bit_count) {
+    uint64_t words[ELIAS_FANO_CHUNK_VALUES];
+    size_t word_count = bit_count / 64;
+    for (size_t i = 0; i < word_count; i += ELIAS_FANO_CHUNK_VALUES) {
+        size_t length = (word_count - i < ELIAS_FANO_CHUNK_VALUES) ? word_count - i : ELIAS_FANO_CHUNK_VALUES;
+        BitStreamResult result = bit_stream_read_bits_batch(from, words, length, 64);
+        if (result.success) {
+            result = bit_stream_write_bits_batch(to, words, length, 64);
+        }
+        if (!result.success) {
+            return result;
+        }
+    }
+    
+    uint8_t tail = (uint8_t)(bit_count % 64);
+    if (tail == 0) {
+        return create_success_result();
+    }
+    BitStreamResult result = bit_stream_read_bits(from, tail);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_write_bits(to, result.value.u64, tail);
+}
+
+BitStreamResult bit_stream_write_elias_fano(BitStream* stream, const uint64_t* values, size_t count) {
+    if (!is_non_decreasing(values, count)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    uint8_t low_width = (count > 0) ? choose_low_width(values[count - 1], count) : 0;
+    uint64_t upper = (count > 0) ? values[count - 1] >> low_width : 0;
+    
+    BitStreamResult result = write_header(stream, count, low_width, upper);
+    if (result.success) {
+        result = write_low_bits(stream, values, count, low_width);
+    }
+    if (result.success) {
+        result = write_high_bits(stream, values, count, low_width);
+    }
+    return result;
+}
+
+BitStreamResult bit_stream_read_elias_fano(BitStream* stream, uint64_t* values, size_t count) {
+    size_t written_count;
+    uint8_t low_width;
+    uint64_t upper;
+    BitStreamResult result = read_header(stream, &written_count, &low_width, &upper);
+    if (!result.success) {
+        return result;
+    }
+    if (written_count != count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    if (low_width > 0) {
+        result = bit_stream_read_bits_batch(stream, values, count, low_width);
+        if (!result.success) {
+            return result;
+        }
+    } else {
+        memset(values, 0, count * sizeof(uint64_t));
+    }
+    
+    // The high parts are decoded straight from the buffer, a word at a time
+    size_t position = bit_stream_position(stream);
+    size_t high_length = count + (size_t)upper;
+    if (high_length < count || high_length > stream->bit_length - position) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    size_t i = 0;
+    for (size_t offset = 0; offset < high_length; offset += 64) {
+        size_t start = position + offset;
+        uint64_t word = bit_stream_window64(stream->buffer + start / 8, stream->buffer_size - start / 8, (uint8_t)(start % 8));
+        if (high_length - offset < 64) {
+            word &= ~(UINT64_MAX >> (high_length - offset));
+        }
+        for (; word != 0 && i < count; i++) {
+            unsigned zeros = bit_stream_clz64(word);
+            values[i] |= (uint64_t)(offset + zeros - i) << low_width;
+            word ^= 0x8000000000000000ULL >> zeros;
+        }
+        if (word != 0) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+    }
+    if (i != count || (values[count - 1] >> low_width) != upper) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return bit_stream_skip_bits(stream, high_length);
+}
+
+// Allocates a sequence with empty parts; NULL when out of memory
+static EliasFano* new_sequence(size_t count, uint8_t low_width) {
+    EliasFano* sequence = (EliasFano*)malloc(sizeof(EliasFano));
+    if (sequence == NULL) {
+        return NULL;
+    }
+    sequence->count = count;
+    sequence->low_width = low_width;
+    sequence->low = bit_stream_new();
+    sequence->high = bit_stream_new();
+    sequence->index = NULL;
+    if (sequence->low == NULL || sequence->high == NULL) {
+        elias_fano_free(sequence);
+        return NULL;
+    }
+    return sequence;
+}
+
+EliasFano* elias_fano_from_values(const uint64_t* values, size_t count) {
+    if (!is_non_decreasing(values, count)) {
+        return NULL;
+    }
+    uint8_t low_width = (count > 0) ? choose_low_width(values[count - 1], count) : 0;
+    EliasFano* sequence = new_sequence(count, low_width);
+    if (sequence == NULL) {
+        return NULL;
+    }
+    if (!write_low_bits(sequence->low, values, count, low_width).success ||
+        !write_high_bits(sequence->high, values, count, low_width).success) {
+        elias_fano_free(sequence);
+        return NULL;
+    }
+    sequence->index = rank_select_index_new(sequence->high);
+    if (sequence->index == NULL) {
+        elias_fano_free(sequence);
+        return NULL;
+    }
+    return sequence;
+}
+
+BitStreamResult bit_stream_read_elias_fano_sequence(BitStream* stream, EliasFano** sequence) {
+    size_t count;
+    uint8_t low_width;
+    uint64_t upper;
+    BitStreamResult result = read_header(stream, &count, &low_width, &upper);
+    if (!result.success) {
+        return result;
+    }
+    size_t high_length = count + (size_t)upper;
+    if (high_length < count || (low_width > 0 && count > SIZE_MAX / low_width)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    EliasFano* loaded = new_sequence(count, low_width);
+    if (loaded == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    result = copy_bits(stream, loaded->low, count * low_width);
+    if (result.success) {
+        result = copy_bits(stream, loaded->high, high_length);
+    }
+    if (result.success) {
+        loaded->index = rank_select_index_new(loaded->high);
+        if (loaded->index == NULL) {
+            result = create_error_result(BIT_STREAM_ERROR_IO);
+        }
+    }
+    
+    // The bitmap must hold one bit per value and end on the last of them
+    if (result.success && (rank_select_index_ones(loaded->index) != count ||
+                           (count > 0 && rank_select_index_select1(loaded->index, count - 1) != high_length - 1))) {
+        result = create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    if (!result.success) {
+        elias_fano_free(loaded);
+        return result;
+    }
+    *sequence = loaded;
+    return create_success_result();
+}
+
+void elias_fano_free(EliasFano* sequence) {
+    if (sequence != NULL) {
+        rank_select_index_free(sequence->index);
+        bit_stream_free(sequence->low);
+        bit_stream_free(sequence->high);
+        free(sequence);
+    }
+}
+
+size_t elias_fano_count(const EliasFano* sequence) {
+    return sequence->count;
+}
+
+static inline uint64_t low_bits_at(const EliasFano* sequence, size_t i) {
+    if (sequence->low_width == 0) {
+        return 0;
+    }
+    const BitStream* low = sequence->low;
+    size_t start = i * sequence->low_width;
+    uint64_t window = bit_stream_window64(low->buffer + start / 8, low->buffer_size - start / 8, (uint8_t)(start % 8));
+    return window >> (64 - sequence->low_width);
+}
+
+uint64_t elias_fano_access(const EliasFano* sequence, size_t i) {
+    uint64_t high = rank_select_index_select1(sequence->index, i) - i;
+    return (high << sequence->low_width) | low_bits_at(sequence, i);
+}
+
+size_t elias_fano_next_geq(const EliasFano* sequence, uint64_t value) {
+    uint64_t high = value >> sequence->low_width;
+    
+    // Values before the zero closing high part high - 1 are all smaller;
+    // without that zero every value is
+    size_t i = 0;
+    size_t position = 0;
+    if (high > 0) {
+        size_t zero = rank_select_index_select0(sequence->index, high - 1);
+        if (zero == SIZE_MAX) {
+            return sequence->count;
+        }
+        i = zero - (size_t)(high - 1);
+        position = zero + 1;
+    }
+    
+    // The bitmap is walked on from there, each one the next value and each
+    // zero a step up in the high part, rather than selecting every value
+    const BitStream* bitmap = sequence->high;
+    while (i < sequence->count) {
+        uint64_t word = bit_stream_window64(bitmap->buffer + position / 8, bitmap->buffer_size - position / 8, (uint8_t)(position % 8));
+        if (word == 0) {
+            position += 64;
+            continue;
+        }
+        position += bit_stream_clz64(word);
+        uint64_t candidate = ((uint64_t)(position - i) << sequence->low_width) | low_bits_at(sequence, i);
+        if (candidate >= value) {
+            return i;
+        }
+        i++;
+        position++;
+    }
+    return sequence->count;
+}
@@ -0,0 +1,442 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Canonical Huffman codes over byte symbols. Code lengths are built from a
+// histogram and limited to HUFFMAN_MAX_CODE_LENGTH bits, and codes are
+// assigned canonically (shorter codes first, then by symbol), so a table
+// is fully described by its code lengths:
+//
+//   symbol count (9 bits) | code length of each symbol (4 bits each)
+//
+// where 0 marks an unused symbol. Decoding indexes a table with the next
+// HUFFMAN_MAX_CODE_LENGTH bits of the stream. Each entry holds the first
+// symbol of that window and, when the two codes together fit in the
+// window, the second one as well, so short codes decode two per lookup.
+
+#define HUFFMAN_TABLE_BITS HUFFMAN_MAX_CODE_LENGTH
+#define HUFFMAN_TABLE_SIZE (1U << HUFFMAN_TABLE_BITS)
+#define HUFFMAN_COUNT_BITS 9
+#define HUFFMAN_LENGTH_BITS 4
+
+typedef struct {
+    uint8_t symbols[2];
+    uint8_t symbol_count;  // 0 for windows that start no valid code
+    uint8_t bit_count;     // Bits taken by all symbols of the entry
+} HuffmanEntry;
+
+struct HuffmanCode {
+    size_t symbol_count;
+    uint8_t lengths[HUFFMAN_MAX_SYMBOLS];
+    uint16_t codes[HUFFMAN_MAX_SYMBOLS];
+    HuffmanEntry table[HUFFMAN_TABLE_SIZE];
+};
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Builds optimal code lengths with the two-queue method over leaves sorted
+// by weight, then caps them at the maximum length and repairs the Kraft
+// sum by lengthening the longest codes that are still below the cap
+static void build_lengths(const uint64_t* histogram, size_t symbol_count, uint8_t* lengths) {
+    uint16_t leaves[HUFFMAN_MAX_SYMBOLS];
+    size_t used = 0;
+    memset(lengths, 0, symbol_count);
+    for (size_t s = 0; s < symbol_count; s++) {
+        if (histogram[s] > 0) {
+            // Insertion sort by weight, ties by symbol
+            size_t i = used++;
+            while (i > 0 && histogram[leaves[i - 1]] > histogram[s]) {
+                leaves[i] = leaves[i - 1];
+                i--;
+            }
+            leaves[i] = (uint16_t)s;
+        }
+    }
+    if (used == 0) {
+        return;
+    }
+    if (used == 1) {
+        lengths[leaves[0]] = 1;
+        return;
+    }
+    
+    // Nodes 0..used-1 are the leaves; internal nodes follow in the order
+    // they are made, which is also increasing weight
+    uint64_t weights[2 * HUFFMAN_MAX_SYMBOLS];
+    uint16_t parents[2 * HUFFMAN_MAX_SYMBOLS];
+    uint8_t depths[2 * HUFFMAN_MAX_SYMBOLS];
+    for (size_t i = 0; i < used; i++) {
+        weights[i] = histogram[leaves[i]];
+    }
+    size_t next_leaf = 0;
+    size_t next_internal = used;
+    for (size_t node = used; node < 2 * used - 1; node++) {
+        weights[node] = 0;
+        for (int child = 0; child < 2; child++) {
+            size_t pick;
+            if (next_leaf < used && (next_internal >= node || weights[next_leaf] <= weights[next_internal])) {
+                pick = next_leaf++;
+            } else {
+                pick = next_internal++;
+            }
+            weights[node] += weights[pick];
+            parents[pick] = (uint16_t)node;
+        }
+    }
+    depths[2 * used - 2] = 0;
+    for (size_t node = 2 * used - 2; node-- > 0;) {
+        uint8_t depth = depths[parents[node]] + 1;
+        depths[node] = (depth > HUFFMAN_MAX_CODE_LENGTH + 1) ? HUFFMAN_MAX_CODE_LENGTH + 1 : depth;
+    }
+    
+    // Kraft sum in units of 2^-HUFFMAN_MAX_CODE_LENGTH
+    const uint32_t capacity = 1U << HUFFMAN_MAX_CODE_LENGTH;
+    uint32_t kraft = 0;
+    for (size_t i = 0; i < used; i++) {
+        uint8_t length = (depths[i] > HUFFMAN_MAX_CODE_LENGTH) ? HUFFMAN_MAX_CODE_LENGTH : depths[i];
+        lengths[leaves[i]] = length;
+        kraft += capacity >> length;
+    }
+    while (kraft > capacity) {
+        // Lengthen the longest code below the cap, the lightest one on ties
+        size_t pick = 0;
+        uint8_t pick_length = 0;
+        for (size_t i = 0; i < used; i++) {
+            uint8_t length = lengths[leaves[i]];
+            if (length < HUFFMAN_MAX_CODE_LENGTH && length > pick_length) {
+                pick = i;
+                pick_length = length;
+            }
+        }
+        lengths[leaves[pick]]++;
+        kraft -= capacity >> (pick_length + 1);
+    }
+    
+    // Hand any slack back to the heaviest symbols
+    for (size_t i = used; i-- > 0;) {
+        uint8_t* length = &lengths[leaves[i]];
+        while (*length > 1 && kraft + (capacity >> *length) <= capacity) {
+            kraft += capacity >> *length;
+            (*length)--;
+        }
+    }
+}
+
+// Assigns canonical codes and builds the decode table; fails when the
+// lengths over-subscribe the code space
+static bool build_code(HuffmanCode* code) {
+    uint32_t length_counts[HUFFMAN_MAX_CODE_LENGTH + 1] = {0};
+    for (size_t s = 0; s < code->symbol_count; s++) {
+        length_counts[code->lengths[s]]++;
+    }
+    length_counts[0] = 0;
+    
+    uint32_t next_code[HUFFMAN_MAX_CODE_LENGTH + 1];
+    uint32_t value = 0;
+    for (unsigned length = 1; length <= HUFFMAN_MAX_CODE_LENGTH; length++) {
+        value = (value + length_counts[length - 1]) << 1;
+        next_code[length] = value;
+        if (value + length_counts[length] > (1U << length)) {
+            return false;
+        }
+    }
+    
+    memset(code->table, 0, sizeof(code->table));
+    for (size_t s = 0; s < code->symbol_count; s++) {
+        uint8_t length = code->lengths[s];
+        if (length == 0) {
+            continue;
+        }
+        code->codes[s] = (uint16_t)next_code[length]++;
+        
+        // Every window that starts with this code decodes to the symbol
+        uint32_t first = (uint32_t)code->codes[s] << (HUFFMAN_TABLE_BITS - length);
+        uint32_t span = 1U << (HUFFMAN_TABLE_BITS - length);
+        for (uint32_t i = first; i < first + span; i++) {
+            code->table[i].symbols[0] = (uint8_t)s;
+            code->table[i].symbol_count = 1;
+            code->table[i].bit_count = length;
+        }
+    }
+    
+    // Add a second symbol wherever its whole code lies inside the window
+    for (uint32_t i = 0; i < HUFFMAN_TABLE_SIZE; i++) {
+        HuffmanEntry* entry = &code->table[i];
+        if (entry->symbol_count == 0) {
+            continue;
+        }
+        uint32_t rest = (i << entry->bit_count) & (HUFFMAN_TABLE_SIZE - 1);
+        // The entry at rest may already hold a pair; only its first code counts
+        const HuffmanEntry* second = &code->table[rest];
+        if (second->symbol_count == 0) {
+            continue;
+        }
+        uint8_t second_length = code->lengths[second->symbols[0]];
+        if (entry->bit_count + second_length <= HUFFMAN_TABLE_BITS) {
+            entry->symbols[1] = second->symbols[0];
+            entry->symbol_count = 2;
+            entry->bit_count += second_length;
+        }
+    }
+    return true;
+}
+
+HuffmanCode* huffman_code_from_histogram(const uint64_t* histogram, size_t symbol_count) {
+    if (symbol_count > HUFFMAN_MAX_SYMBOLS) {
+        return NULL;
+    }
+    HuffmanCode* code = (HuffmanCode*)malloc(sizeof(HuffmanCode));
+    if (code == NULL) {
+        return NULL;
+    }
+    
+    code->symbol_count = symbol_count;
+    build_lengths(histogram, symbol_count, code->lengths);
+    if (!build_code(code)) {
+        free(code);
+        return NULL;
+    }
+    return code;
+}
+
+void huffman_code_free(HuffmanCode* code) {
+    free(code);
+}
+
+uint8_t huffman_code_length(const HuffmanCode* code, uint8_t symbol) {
+    return (symbol < code->symbol_count) ? code->lengths[symbol] : 0;
+}
+
+// Rebuilds a code from header lengths
+static BitStreamErrorCode code_from_lengths(const uint8_t* lengths, size_t symbol_count, HuffmanCode** out) {
+    HuffmanCode* code = (HuffmanCode*)malloc(sizeof(HuffmanCode));
+    if (code == NULL) {
+        return BIT_STREAM_ERROR_IO;
+    }
+    code->symbol_count = symbol_count;
+    memcpy(code->lengths, lengths, symbol_count);
+    if (!build_code(code)) {
+        free(code);
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    *out = code;
+    return BIT_STREAM_ERROR_NONE;
+}
+
+// ---------------------------------------------------------------------------
+// BitStream
+// ---------------------------------------------------------------------------
+
+BitStreamResult bit_stream_write_huffman_table(BitStream* stream, const HuffmanCode* code) {
+    BitStreamResult result = bit_stream_write_bits(stream, code->symbol_count, HUFFMAN_COUNT_BITS);
+    for (size_t s = 0; s < code->symbol_count && result.success; s++) {
+        result = bit_stream_write_bits(stream, code->lengths[s], HUFFMAN_LENGTH_BITS);
+    }
+    return result;
+}
+
+BitStreamResult bit_stream_read_huffman_table(BitStream* stream, HuffmanCode** code) {
+    BitStreamResult result = bit_stream_read_bits(stream, HUFFMAN_COUNT_BITS);
+    if (!result.success) {
+        return result;
+    }
+    size_t symbol_count = result.value.u64;
+    if (symbol_count > HUFFMAN_MAX_SYMBOLS) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint8_t lengths[HUFFMAN_MAX_SYMBOLS];
+    for (size_t s = 0; s < symbol_count; s++) {
+        result = bit_stream_read_bits(stream, HUFFMAN_LENGTH_BITS);
+        if (!result.success) {
+            return result;
+        }
+        if (result.value.u64 > HUFFMAN_MAX_CODE_LENGTH) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        lengths[s] = (uint8_t)result.value.u64;
+    }
+    
+    BitStreamErrorCode error = code_from_lengths(lengths, symbol_count, code);
+    if (error != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(error);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_huffman(BitStream* stream, const HuffmanCode* code, const uint8_t* symbols, size_t count) {
+    // Codes are gathered into 64-bit fields before they are written
+    uint64_t pending = 0;
+    unsigned pending_bits = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t length = huffman_code_length(code, symbols[i]);
+        if (length == 0) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        if (pending_bits + length > 64) {
+            BitStreamResult result = bit_stream_write_bits(stream, pending, (uint8_t)pending_bits);
+            if (!result.success) {
+                return result;
+            }
+            pending = 0;
+            pending_bits = 0;
+        }
+        pending = (pending << length) | code->codes[symbols[i]];
+        pending_bits += length;
+    }
+    if (pending_bits > 0) {
+        return bit_stream_write_bits(stream, pending, (uint8_t)pending_bits);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_huffman(BitStream* stream, const HuffmanCode* code, uint8_t* symbols, size_t count) {
+    size_t position = bit_stream_position(stream);
+    size_t i = 0;
+    
+    // Several lookups are served from each 64-bit window
+    while (i < count) {
+        size_t byte = position / 8;
+        size_t available = (byte < stream->buffer_size) ? stream->buffer_size - byte : 0;
+        uint64_t window = bit_stream_window64(stream->buffer + byte, available, position % 8);
+        unsigned consumed = 0;
+        while (i < count && consumed + HUFFMAN_TABLE_BITS <= 64) {
+            const HuffmanEntry* entry = &code->table[(window << consumed) >> (64 - HUFFMAN_TABLE_BITS)];
+            if (entry->symbol_count == 0) {
+                stream->byte_pos = position / 8;
+                stream->bit_pos = position % 8;
+                return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+            }
+            symbols[i++] = entry->symbols[0];
+            if (entry->symbol_count == 2 && i < count) {
+                symbols[i++] = entry->symbols[1];
+                consumed += entry->bit_count;
+            } else {
+                consumed += code->lengths[entry->symbols[0]];
+            }
+        }
+        
+        // Bits past the end read as zero; catch codes decoded from them
+        if (consumed > stream->bit_length - position) {
+            return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+        }
+        position += consumed;
+        stream->byte_pos = position / 8;
+        stream->bit_pos = position % 8;
+    }
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// BitStreamReader / BitStreamWriter
+// ---------------------------------------------------------------------------
+
+BitStreamResult bit_stream_writer_write_huffman_table(BitStreamWriter* writer, const HuffmanCode* code) {
+    BitStreamResult result = bit_stream_writer_write_bits_msb(writer, code->symbol_count, HUFFMAN_COUNT_BITS);
+    for (size_t s = 0; s < code->symbol_count && result.success; s++) {
+        result = bit_stream_writer_write_bits_msb(writer, code->lengths[s], HUFFMAN_LENGTH_BITS);
+    }
+    return result;
+}
+
+BitStreamResult bit_stream_reader_read_huffman_table(BitStreamReader* reader, HuffmanCode** code) {
+    BitStreamResult result = bit_stream_reader_read_bits_msb(reader, HUFFMAN_COUNT_BITS);
+    if (!result.success) {
+        return result;
+    }
+    size_t symbol_count = result.value.u64;
+    if (symbol_count > HUFFMAN_MAX_SYMBOLS) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint8_t lengths[HUFFMAN_MAX_SYMBOLS];
+    for (size_t s = 0; s < symbol_count; s++) {
+        result = bit_stream_reader_read_bits_msb(reader, HUFFMAN_LENGTH_BITS);
+        if (!result.success) {
+            return result;
+        }
+        if (result.value.u64 > HUFFMAN_MAX_CODE_LENGTH) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        lengths[s] = (uint8_t)result.value.u64;
+    }
+    
+    BitStreamErrorCode error = code_from_lengths(lengths, symbol_count, code);
+    if (error != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(error);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_huffman(BitStreamWriter* writer, const HuffmanCode* code, const uint8_t* symbols, size_t count) {
+    uint64_t pending = 0;
+    unsigned pending_bits = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t length = huffman_code_length(code, symbols[i]);
+        if (length == 0) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        if (pending_bits + length > 64) {
+            BitStreamResult result = bit_stream_writer_write_bits_msb(writer, pending, (uint8_t)pending_bits);
+            if (!result.success) {
+                return result;
+            }
+            pending = 0;
+            pending_bits = 0;
+        }
+        pending = (pending << length) | code->codes[symbols[i]];
+        pending_bits += length;
+    }
+    if (pending_bits > 0) {
+        return bit_stream_writer_write_bits_msb(writer, pending, (uint8_t)pending_bits);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_huffman(BitStreamReader* reader, const HuffmanCode* code, uint8_t* symbols, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        BitStreamResult result = bit_stream_reader_peek_bits_msb(reader, 64);
+        if (!result.success) {
+            return result;
+        }
+        uint64_t window = result.value.u64;
+        unsigned consumed = 0;
+        while (i < count && consumed + HUFFMAN_TABLE_BITS <= 64) {
+            const HuffmanEntry* entry = &code->table[(window << consumed) >> (64 - HUFFMAN_TABLE_BITS)];
+            if (entry->symbol_count == 0) {
+                bit_stream_reader_skip_bits(reader, consumed);
+                return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+            }
+            symbols[i++] = entry->symbols[0];
+            if (entry->symbol_count == 2 && i < count) {
+                symbols[i++] = entry->symbols[1];
+                consumed += entry->bit_count;
+            } else {
+                consumed += code->lengths[entry->symbols[0]];
+            }
+        }
+        
+        // Fails when codes were decoded from the zero padding past the end
+        result = bit_stream_reader_skip_bits(reader, consumed);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
@@ -0,0 +1,214 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Order-preserving key fields. A key is a tuple of fields written MSB first,
+// so comparing the stream bytes of two keys with memcmp compares their
+// fields in order, provided each field's bits order like its values and no
+// field's encoding is a prefix of another's (then the first differing bit
+// always falls inside a field both keys have). Unsigned fields already
+// qualify. The others are mapped:
+//
+//   signed   the sign bit is flipped, which moves negatives below zero
+//   varint   bit width (7 bits), then the value below its top bit; wider
+//            values are larger, and equal widths compare by their bits
+//   bytes    0x00 is escaped as 0x00 0xFF and the field closed with
+//            0x00 0x01, which sorts below any continuation, so a string
+//            sorts before its extensions
+
+#define KEY_VARINT_WIDTH_BITS 7
+#define KEY_BYTES_ESCAPE 0xFF
+#define KEY_BYTES_TERMINATOR 0x01
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+static BitStreamResult create_u64_result(uint64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.u64 = value;
+    return result;
+}
+
+static BitStreamResult create_i64_result(int64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i64 = value;
+    return result;
+}
+
+static BitStreamResult create_i128_result(Int128 value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i128 = value;
+    return result;
+}
+
+// Whether any byte of word is zero
+static inline bool has_zero_byte(uint64_t word) {
+    return ((word - 0x0101010101010101ULL) & ~word & 0x8080808080808080ULL) != 0;
+}
+
+BitStreamResult bit_stream_write_key_signed(BitStream* stream, int64_t value, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    // A value that does not fit would be truncated and sort out of order
+    if (int64_sign_extend((uint64_t)value, bit_count) != value) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return bit_stream_write_bits(stream, (uint64_t)value ^ (1ULL << (bit_count - 1)), bit_count);
+}
+
+BitStreamResult bit_stream_read_key_signed(BitStream* stream, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits(stream, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i64_result(int64_sign_extend(result.value.u64 ^ (1ULL << (bit_count - 1)), bit_count));
+}
+
+// The sign bit of a bit_count-bit field held in a UInt128
+static inline UInt128 sign_bit_u128(uint8_t bit_count) {
+    return (bit_count > 64) ? uint128_from_parts(1ULL << (bit_count - 65), 0) : uint128_from_u64(1ULL << (bit_count - 1));
+}
+
+BitStreamResult bit_stream_write_key_signed_i128(BitStream* stream, Int128 value, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 128) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    Int128 fitted = int128_sign_extend(uint128_from_parts((uint64_t)value.high, value.low), bit_count);
+    if (fitted.high != value.high || fitted.low != value.low) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    UInt128 sign = sign_bit_u128(bit_count);
+    UInt128 bits = uint128_from_parts((uint64_t)value.high ^ sign.high, value.low ^ sign.low);
+    return bit_stream_write_bits_u128(stream, bits, bit_count);
+}
+
+BitStreamResult bit_stream_read_key_signed_i128(BitStream* stream, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits_u128(stream, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    UInt128 sign = sign_bit_u128(bit_count);
+    UInt128 bits = uint128_from_parts(result.value.u128.high ^ sign.high, result.value.u128.low ^ sign.low);
+    return create_i128_result(int128_sign_extend(bits, bit_count));
+}
+
+BitStreamResult bit_stream_write_key_varint(BitStream* stream, uint64_t value) {
+    uint8_t width = (uint8_t)bit_stream_bit_width64(value);
+    BitStreamResult result = bit_stream_write_bits(stream, width, KEY_VARINT_WIDTH_BITS);
+    if (!result.success || width <= 1) {
+        return result;
+    }
+    return bit_stream_write_bits(stream, value, width - 1);
+}
+
+BitStreamResult bit_stream_read_key_varint(BitStream* stream) {
+    BitStreamResult result = bit_stream_read_bits(stream, KEY_VARINT_WIDTH_BITS);
+    if (!result.success) {
+        return result;
+    }
+    uint8_t width = (uint8_t)result.value.u64;
+    if (width > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    if (width <= 1) {
+        return create_u64_result(width);
+    }
+    result = bit_stream_read_bits(stream, width - 1);
+    if (!result.success) {
+        return result;
+    }
+    return create_u64_result((1ULL << (width - 1)) | result.value.u64);
+}
+
+BitStreamResult bit_stream_write_key_bytes(BitStream* stream, const uint8_t* bytes, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        // Eight bytes at a time while none of them needs escaping
+        if (length - i >= 8) {
+            uint64_t word = bit_stream_load_be64(bytes + i);
+            if (!has_zero_byte(word)) {
+                BitStreamResult result = bit_stream_write_bits(stream, word, 64);
+                if (!result.success) {
+                    return result;
+                }
+                i += 8;
+                continue;
+            }
+        }
+        
+        BitStreamResult result = (bytes[i] == 0) ? bit_stream_write_bits(stream, KEY_BYTES_ESCAPE, 16)
+                                                 : bit_stream_write_bits(stream, bytes[i], 8);
+        if (!result.success) {
+            return result;
+        }
+        i++;
+    }
+    return bit_stream_write_bits(stream, KEY_BYTES_TERMINATOR, 16);
+}
+
+BitStreamResult bit_stream_read_key_bytes(BitStream* stream, uint8_t* bytes, size_t capacity) {
+    size_t length = 0;
+    for (;;) {
+        // Eight bytes at a time while none of them is zero
+        size_t position = bit_stream_position(stream);
+        if (stream->bit_length - position >= 64 && capacity - length >= 8) {
+            uint64_t word = bit_stream_window64(stream->buffer + position / 8, stream->buffer_size - position / 8, (uint8_t)(position % 8));
+            if (!has_zero_byte(word)) {
+                for (size_t j = 0; j < 8; j++) {
+                    bytes[length + j] = (uint8_t)(word >> (56 - 8 * j));
+                }
+                length += 8;
+                bit_stream_skip_bits(stream, 64);
+                continue;
+            }
+        }
+        
+        BitStreamResult result = bit_stream_read_bits(stream, 8);
+        if (!result.success) {
+            return result;
+        }
+        uint8_t byte = (uint8_t)result.value.u64;
+        if (byte == 0) {
+            result = bit_stream_read_bits(stream, 8);
+            if (!result.success) {
+                return result;
+            }
+            if (result.value.u64 == KEY_BYTES_TERMINATOR) {
+                return create_u64_result(length);
+            }
+            if (result.value.u64 != KEY_BYTES_ESCAPE) {
+                return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+            }
+        }
+        if (length == capacity) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        bytes[length++] = byte;
+    }
+}
+
+int bit_stream_key_compare(const BitStream* a, const BitStream* b) {
+    size_t a_bytes = (a->bit_length + 7) / 8;
+    size_t b_bytes = (b->bit_length + 7) / 8;
+    size_t common = (a_bytes < b_bytes) ? a_bytes : b_bytes;
+    int order = (common > 0) ? memcmp(a->buffer, b->buffer, common) : 0;
+    if (order != 0) {
+        return order;
+    }
+    return (a_bytes > b_bytes) - (a_bytes < b_bytes);
+}
@@ -0,0 +1,329 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+#include <math.h>
+
+// Lossy fixed-point quantization of float and double columns. A quantizer
+// maps [minimum, maximum] onto the codes 0 .. 2^bit_width - 1, choosing the
+// smallest width whose step between neighbouring codes is at most the
+// requested precision; each value is then stored as its nearest code,
+// within half a step of the original. Values outside the range are clamped
+// to it and NaN maps to the minimum.
+//
+// Codes are computed in double precision for both widths and rounded half
+// up, so the scalar and vector paths produce the same codes.
+
+// Bits a serialized quantizer spends on its bit width
+#define QUANTIZE_WIDTH_BITS 6
+
+// Values handled per batch call between quantizing and packing
+#define QUANTIZE_CHUNK_SIZE 256
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+static inline uint64_t max_code(uint8_t bit_width) {
+    return (bit_width == 0) ? 0 : (UINT64_MAX >> (64 - bit_width));
+}
+
+// Fills in a quantizer for a known width; the step and its inverse only
+// depend on the range and width, so a deserialized quantizer matches
+static void quantizer_with_width(Quantizer* quantizer, double minimum, double maximum, uint8_t bit_width) {
+    quantizer->minimum = minimum;
+    quantizer->maximum = maximum;
+    quantizer->bit_width = bit_width;
+    if (bit_width == 0 || maximum == minimum) {
+        quantizer->step = 0.0;
+        quantizer->inverse = 0.0;
+        return;
+    }
+    quantizer->step = (maximum - minimum) / (double)max_code(bit_width);
+    quantizer->inverse = (double)max_code(bit_width) / (maximum - minimum);
+}
+
+static bool valid_range(double minimum, double maximum) {
+    return isfinite(minimum) && isfinite(maximum) && minimum <= maximum && isfinite(maximum - minimum);
+}
+
+BitStreamResult quantizer_init(Quantizer* quantizer, double minimum, double maximum, double precision) {
+    if (!valid_range(minimum, maximum) || !(precision > 0.0)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    // Steps needed across the range, rounded up
+    double steps = (maximum - minimum) / precision;
+    if (!(steps <= (double)max_code(QUANTIZE_MAX_BIT_WIDTH))) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    uint64_t needed = (uint64_t)steps;
+    if ((double)needed < steps) {
+        needed++;
+    }
+    
+    quantizer_with_width(quantizer, minimum, maximum, (uint8_t)bit_stream_bit_width64(needed));
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// Quantize / dequantize
+// ---------------------------------------------------------------------------
+
+// Code of one value; the comparison order sends NaN to code 0
+static inline uint64_t quantize_value(const Quantizer* quantizer, double value, double top) {
+    double scaled = (value - quantizer->minimum) * quantizer->inverse;
+    if (!(scaled > 0.0)) {
+        return 0;
+    }
+    if (scaled > top) {
+        scaled = top;
+    }
+    return (uint64_t)(scaled + 0.5);
+}
+
+static inline double dequantize_value(const Quantizer* quantizer, uint64_t code) {
+    return quantizer->minimum + (double)code * quantizer->step;
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+// Quantizes four scaled lanes: max_pd returns its second operand for NaN,
+// and codes up to 2^32 - 1 are converted through signed int32 by offsetting
+// them by 2^31 and flipping the sign bit back
+BIT_STREAM_TARGET_AVX2
+static inline __m256i quantize_lanes_avx2(__m256d x, __m256d minimum, __m256d inverse, __m256d top) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d offset = _mm256_set1_pd(2147483648.0);
+    __m256d scaled = _mm256_mul_pd(_mm256_sub_pd(x, minimum), inverse);
+    scaled = _mm256_min_pd(_mm256_max_pd(scaled, _mm256_setzero_pd()), top);
+    scaled = _mm256_floor_pd(_mm256_add_pd(scaled, half));
+    __m128i codes = _mm256_cvttpd_epi32(_mm256_sub_pd(scaled, offset));
+    codes = _mm_xor_si128(codes, _mm_set1_epi32((int)0x80000000U));
+    return _mm256_cvtepu32_epi64(codes);
+}
+
+// Codes below 2^52 become doubles by placing them in the mantissa of 2^52
+BIT_STREAM_TARGET_AVX2
+static inline __m256d dequantize_lanes_avx2(__m256i codes, __m256d minimum, __m256d step) {
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+    __m256d value = _mm256_sub_pd(_mm256_or_pd(_mm256_castsi256_pd(codes), magic), magic);
+    return _mm256_add_pd(minimum, _mm256_mul_pd(value, step));
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t quantize_double_avx2(const Quantizer* quantizer, const double* values, uint64_t* codes, size_t count) {
+    const __m256d minimum = _mm256_set1_pd(quantizer->minimum);
+    const __m256d inverse = _mm256_set1_pd(quantizer->inverse);
+    const __m256d top = _mm256_set1_pd((double)max_code(quantizer->bit_width));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i lanes = quantize_lanes_avx2(_mm256_loadu_pd(values + i), minimum, inverse, top);
+        _mm256_storeu_si256((__m256i*)(codes + i), lanes);
+    }
+    return i;
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t quantize_float_avx2(const Quantizer* quantizer, const float* values, uint64_t* codes, size_t count) {
+    const __m256d minimum = _mm256_set1_pd(quantizer->minimum);
+    const __m256d inverse = _mm256_set1_pd(quantizer->inverse);
+    const __m256d top = _mm256_set1_pd((double)max_code(quantizer->bit_width));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(values + i));
+        _mm256_storeu_si256((__m256i*)(codes + i), quantize_lanes_avx2(x, minimum, inverse, top));
+    }
+    return i;
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t dequantize_double_avx2(const Quantizer* quantizer, const uint64_t* codes, double* values, size_t count) {
+    const __m256d minimum = _mm256_set1_pd(quantizer->minimum);
+    const __m256d step = _mm256_set1_pd(quantizer->step);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i lanes = _mm256_loadu_si256((const __m256i*)(codes + i));
+        _mm256_storeu_pd(values + i, dequantize_lanes_avx2(lanes, minimum, step));
+    }
+    return i;
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t dequantize_float_avx2(const Quantizer* quantizer, const uint64_t* codes, float* values, size_t count) {
+    const __m256d minimum = _mm256_set1_pd(quantizer->minimum);
+    const __m256d step = _mm256_set1_pd(quantizer->step);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i lanes = _mm256_loadu_si256((const __m256i*)(codes + i));
+        _mm_storeu_ps(values + i, _mm256_cvtpd_ps(dequantize_lanes_avx2(lanes, minimum, step)));
+    }
+    return i;
+}
+#endif
+
+void quantize_double(const Quantizer* quantizer, const double* values, uint64_t* codes, size_t count) {
+    double top = (double)max_code(quantizer->bit_width);
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = quantize_double_avx2(quantizer, values, codes, count);
+    }
+#endif
+    for (; i < count; i++) {
+        codes[i] = quantize_value(quantizer, values[i], top);
+    }
+}
+
+void quantize_float(const Quantizer* quantizer, const float* values, uint64_t* codes, size_t count) {
+    double top = (double)max_code(quantizer->bit_width);
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = quantize_float_avx2(quantizer, values, codes, count);
+    }
+#endif
+    for (; i < count; i++) {
+        codes[i] = quantize_value(quantizer, values[i], top);
+    }
+}
+
+void dequantize_double(const Quantizer* quantizer, const uint64_t* codes, double* values, size_t count) {
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = dequantize_double_avx2(quantizer, codes, values, count);
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] = dequantize_value(quantizer, codes[i]);
+    }
+}
+
+void dequantize_float(const Quantizer* quantizer, const uint64_t* codes, float* values, size_t count) {
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = dequantize_float_avx2(quantizer, codes, values, count);
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] = (float)dequantize_value(quantizer, codes[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// BitStream
+// ---------------------------------------------------------------------------
+
+BitStreamResult bit_stream_write_quantizer(BitStream* stream, const Quantizer* quantizer) {
+    uint64_t minimum;
+    uint64_t maximum;
+    memcpy(&minimum, &quantizer->minimum, sizeof(minimum));
+    memcpy(&maximum, &quantizer->maximum, sizeof(maximum));
+    BitStreamResult result = bit_stream_write_bits(stream, minimum, 64);
+    if (result.success) {
+        result = bit_stream_write_bits(stream, maximum, 64);
+    }
+    if (result.success) {
+        result = bit_stream_write_bits(stream, quantizer->bit_width, QUANTIZE_WIDTH_BITS);
+    }
+    return result;
+}
+
+BitStreamResult bit_stream_read_quantizer(BitStream* stream, Quantizer* quantizer) {
+    double bounds[2];
+    for (int i = 0; i < 2; i++) {
+        BitStreamResult result = bit_stream_read_bits(stream, 64);
+        if (!result.success) {
+            return result;
+        }
+        memcpy(&bounds[i], &result.value.u64, sizeof(bounds[i]));
+    }
+    BitStreamResult result = bit_stream_read_bits(stream, QUANTIZE_WIDTH_BITS);
+    if (!result.success) {
+        return result;
+    }
+    if (!valid_range(bounds[0], bounds[1]) || result.value.u64 > QUANTIZE_MAX_BIT_WIDTH) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    quantizer_with_width(quantizer, bounds[0], bounds[1], (uint8_t)result.value.u64);
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_quantized_double(BitStream* stream, const Quantizer* quantizer, const double* values, size_t count) {
+    if (quantizer->bit_width == 0) {
+        return create_success_result();
+    }
+    
+    uint64_t codes[QUANTIZE_CHUNK_SIZE];
+    for (size_t i = 0; i < count; i += QUANTIZE_CHUNK_SIZE) {
+        size_t chunk = (count - i < QUANTIZE_CHUNK_SIZE) ? count - i : QUANTIZE_CHUNK_SIZE;
+        quantize_double(quantizer, values + i, codes, chunk);
+        BitStreamResult result = bit_stream_write_bits_batch(stream, codes, chunk, quantizer->bit_width);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_quantized_double(BitStream* stream, const Quantizer* quantizer, double* values, size_t count) {
+    uint64_t codes[QUANTIZE_CHUNK_SIZE] = {0};
+    for (size_t i = 0; i < count; i += QUANTIZE_CHUNK_SIZE) {
+        size_t chunk = (count - i < QUANTIZE_CHUNK_SIZE) ? count - i : QUANTIZE_CHUNK_SIZE;
+        if (quantizer->bit_width > 0) {
+            BitStreamResult result = bit_stream_read_bits_batch(stream, codes, chunk, quantizer->bit_width);
+            if (!result.success) {
+                return result;
+            }
+        }
+        dequantize_double(quantizer, codes, values + i, chunk);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_quantized_float(BitStream* stream, const Quantizer* quantizer, const float* values, size_t count) {
+    if (quantizer->bit_width == 0) {
+        return create_success_result();
+    }
+    
+    uint64_t codes[QUANTIZE_CHUNK_SIZE];
+    for (size_t i = 0; i < count; i += QUANTIZE_CHUNK_SIZE) {
+        size_t chunk = (count - i < QUANTIZE_CHUNK_SIZE) ? count - i : QUANTIZE_CHUNK_SIZE;
+        quantize_float(quantizer, values + i, codes, chunk);
+        BitStreamResult result = bit_stream_write_bits_batch(stream, codes, chunk, quantizer->bit_width);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_quantized_float(BitStream* stream, const Quantizer* quantizer, float* values, size_t count) {
+    uint64_t codes[QUANTIZE_CHUNK_SIZE] = {0};
+    for (size_t i = 0; i < count; i += QUANTIZE_CHUNK_SIZE) {
+        size_t chunk = (count - i < QUANTIZE_CHUNK_SIZE) ? count - i : QUANTIZE_CHUNK_SIZE;
+        if (quantizer->bit_width > 0) {
+            BitStreamResult result = bit_stream_read_bits_batch(stream, codes, chunk, quantizer->bit_width);
+            if (!result.success) {
+                return result;
+            }
+        }
+        dequantize_float(quantizer, codes, values + i, chunk);
+    }
+    return create_success_result();
+}
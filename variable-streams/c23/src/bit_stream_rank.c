@@ -0,0 +1,268 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+
+// Rank/select index over the bits of a stream. The bits are split into
+// blocks of eight 64-bit words, and each block keeps two counts: the ones
+// before the block, and the ones before each of its words 1-7 relative to
+// the block, packed as 9-bit fields. A rank is then one lookup and one
+// popcount of a partial word. For select, the block holding every
+// SELECT_SAMPLE_ONES-th one is sampled, which narrows the search for the
+// block of any one to the blocks between two samples; within the block the
+// word is found from the packed counts and the bit with pdep and tzcnt.
+// Zeros are sampled the same way, and their counts are the bits before a
+// block or word less its ones.
+//
+// Words are numbered in stream order, so bit 63 of a word is its first bit.
+
+// Words per block; the relative counts of a block fit one word
+#define RANK_BLOCK_WORDS 8
+#define RANK_FIELD_BITS 9
+#define RANK_FIELD_MASK 0x1FFULL
+
+// Ones (or zeros) between select samples
+#define SELECT_SAMPLE_ONES 512
+
+struct RankSelectIndex {
+    const BitStream* stream;
+    size_t bit_length;
+    size_t full_words;   // Words lying wholly inside the stream
+    uint64_t tail_word;  // Bits of the last partial word, zero padded
+    size_t block_count;
+    uint64_t* counts;    // Per block: ones before it, then relative counts; a final block holds the total
+    size_t* samples;     // Block holding the one of each rank k * SELECT_SAMPLE_ONES, then the last block
+    size_t* zero_samples;  // The same for zeros
+    uint64_t ones;
+};
+
+static inline uint64_t word_at(const RankSelectIndex* index, size_t word) {
+    if (word < index->full_words) {
+        return bit_stream_load_be64(index->stream->buffer + 8 * word);
+    }
+    return index->tail_word;
+}
+
+// Ones before word j of a block, from its packed relative counts. For j = 0
+// the field index wraps around to 7, which reads only the unused top bit.
+static inline uint64_t relative_count(uint64_t relative, size_t j) {
+    uint64_t field = (uint64_t)j - 1;
+    field += (field >> 60) & 8;
+    return (relative >> (RANK_FIELD_BITS * field)) & RANK_FIELD_MASK;
+}
+
+static inline void count_blocks(RankSelectIndex* index, size_t word_count) {
+    uint64_t total = 0;
+    for (size_t block = 0; block < index->block_count; block++) {
+        uint64_t relative = 0;
+        uint64_t in_block = 0;
+        for (size_t j = 0; j < RANK_BLOCK_WORDS; j++) {
+            if (j > 0) {
+                relative |= in_block << (RANK_FIELD_BITS * (j - 1));
+            }
+            size_t word = block * RANK_BLOCK_WORDS + j;
+            if (word < word_count) {
+                in_block += bit_stream_popcount64(word_at(index, word));
+            }
+        }
+        index->counts[2 * block] = total;
+        index->counts[2 * block + 1] = relative;
+        total += in_block;
+    }
+    index->counts[2 * index->block_count] = total;
+    index->counts[2 * index->block_count + 1] = 0;
+}
+
+static inline uint64_t rank1_at(const RankSelectIndex* index, size_t position) {
+    size_t word = position / 64;
+    const uint64_t* counts = index->counts + 2 * (word / RANK_BLOCK_WORDS);
+    uint64_t before = word_at(index, word) & ~(UINT64_MAX >> (position % 64));
+    return counts[0] + relative_count(counts[1], word % RANK_BLOCK_WORDS) + bit_stream_popcount64(before);
+}
+
+// Ones (or zeros) before a block
+static inline uint64_t block_count_of(const RankSelectIndex* index, size_t block, bool zeros) {
+    uint64_t ones = index->counts[2 * block];
+    return zeros ? (uint64_t)block * RANK_BLOCK_WORDS * 64 - ones : ones;
+}
+
+// Ones (or zeros) before word j of a block, relative to the block
+static inline uint64_t relative_count_of(uint64_t relative, size_t j, bool zeros) {
+    uint64_t ones = relative_count(relative, j);
+    return zeros ? (uint64_t)j * 64 - ones : ones;
+}
+
+// Finds the word holding the one (or zero) of rank k, which must exist;
+// *rank becomes its rank among the ones (or zeros) of the word
+static inline size_t find_word(const RankSelectIndex* index, uint64_t k, bool zeros, unsigned* rank) {
+    // The last block between the samples that starts at or before rank k
+    const size_t* sample = (zeros ? index->zero_samples : index->samples) + k / SELECT_SAMPLE_ONES;
+    size_t low = sample[0];
+    size_t blocks = sample[1] - sample[0] + 1;
+    while (blocks > 1) {
+        size_t half = blocks / 2;
+        low = (block_count_of(index, low + half, zeros) <= k) ? low + half : low;
+        blocks -= half;
+    }
+    
+    uint64_t relative = index->counts[2 * low + 1];
+    uint64_t remaining = k - block_count_of(index, low, zeros);
+    size_t word = 0;
+    for (size_t j = 1; j < RANK_BLOCK_WORDS; j++) {
+        word += relative_count_of(relative, j, zeros) <= remaining;
+    }
+    *rank = (unsigned)(remaining - relative_count_of(relative, word, zeros));
+    return low * RANK_BLOCK_WORDS + word;
+}
+
+// Builds the select samples of ones (or zeros); returns NULL when out of memory
+static size_t* build_samples(const RankSelectIndex* index, bool zeros) {
+    uint64_t total = zeros ? index->bit_length - index->ones : index->ones;
+    size_t sample_count = (size_t)((total + SELECT_SAMPLE_ONES - 1) / SELECT_SAMPLE_ONES);
+    size_t* samples = (size_t*)malloc((sample_count + 1) * sizeof(size_t));
+    if (samples == NULL) {
+        return NULL;
+    }
+    size_t next = 0;
+    for (size_t block = 0; block < index->block_count; block++) {
+        uint64_t through = (block + 1 < index->block_count) ? block_count_of(index, block + 1, zeros) : total;
+        while (next < sample_count && (uint64_t)next * SELECT_SAMPLE_ONES < through) {
+            samples[next++] = block;
+        }
+    }
+    samples[sample_count] = (index->block_count > 0) ? index->block_count - 1 : 0;
+    return samples;
+}
+
+// Offset from the top of word of its set bit of the given rank
+static inline unsigned select_in_word(uint64_t word, unsigned rank) {
+    for (unsigned i = 0; i < rank; i++) {
+        word &= ~(0x8000000000000000ULL >> bit_stream_clz64(word));
+    }
+    return bit_stream_clz64(word);
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+BIT_STREAM_TARGET_POPCNT
+static void count_blocks_popcnt(RankSelectIndex* index, size_t word_count) {
+    count_blocks(index, word_count);
+}
+
+BIT_STREAM_TARGET_POPCNT
+static uint64_t rank1_popcnt(const RankSelectIndex* index, size_t position) {
+    return rank1_at(index, position);
+}
+
+// pdep deposits from the bottom, so the rank is counted from there
+BIT_STREAM_TARGET_BMI2
+static inline size_t select_bmi2(const RankSelectIndex* index, uint64_t k, bool zeros) {
+    unsigned rank;
+    size_t word = find_word(index, k, zeros, &rank);
+    uint64_t bits = zeros ? ~word_at(index, word) : word_at(index, word);
+    uint64_t bit = _pdep_u64((uint64_t)1 << (bit_stream_popcount64(bits) - 1 - rank), bits);
+    return 64 * word + 63 - bit_stream_ctz64(bit);
+}
+
+BIT_STREAM_TARGET_BMI2
+static size_t select1_bmi2(const RankSelectIndex* index, uint64_t k) {
+    return select_bmi2(index, k, false);
+}
+
+BIT_STREAM_TARGET_BMI2
+static size_t select0_bmi2(const RankSelectIndex* index, uint64_t k) {
+    return select_bmi2(index, k, true);
+}
+#endif
+
+RankSelectIndex* rank_select_index_new(const BitStream* stream) {
+    RankSelectIndex* index = (RankSelectIndex*)malloc(sizeof(RankSelectIndex));
+    if (index == NULL) {
+        return NULL;
+    }
+    index->stream = stream;
+    index->bit_length = stream->bit_length;
+    index->full_words = stream->bit_length / 64;
+    index->tail_word = 0;
+    size_t tail_bits = stream->bit_length % 64;
+    if (tail_bits > 0) {
+        size_t offset = 8 * index->full_words;
+        uint64_t window = bit_stream_window64(stream->buffer + offset, (stream->bit_length + 7) / 8 - offset, 0);
+        index->tail_word = window & ~(UINT64_MAX >> tail_bits);
+    }
+    
+    size_t word_count = (stream->bit_length + 63) / 64;
+    index->block_count = (word_count + RANK_BLOCK_WORDS - 1) / RANK_BLOCK_WORDS;
+    index->counts = (uint64_t*)malloc(2 * (index->block_count + 1) * sizeof(uint64_t));
+    if (index->counts == NULL) {
+        free(index);
+        return NULL;
+    }
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_popcnt()) {
+        count_blocks_popcnt(index, word_count);
+    } else {
+        count_blocks(index, word_count);
+    }
+#else
+    count_blocks(index, word_count);
+#endif
+    index->ones = index->counts[2 * index->block_count];
+    
+    index->samples = build_samples(index, false);
+    index->zero_samples = build_samples(index, true);
+    if (index->samples == NULL || index->zero_samples == NULL) {
+        rank_select_index_free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void rank_select_index_free(RankSelectIndex* index) {
+    if (index != NULL) {
+        free(index->counts);
+        free(index->samples);
+        free(index->zero_samples);
+        free(index);
+    }
+}
+
+uint64_t rank_select_index_ones(const RankSelectIndex* index) {
+    return index->ones;
+}
+
+uint64_t rank_select_index_rank1(const RankSelectIndex* index, size_t position) {
+    position = (position < index->bit_length) ? position : index->bit_length;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_popcnt()) {
+        return rank1_popcnt(index, position);
+    }
+#endif
+    return rank1_at(index, position);
+}
+
+size_t rank_select_index_select1(const RankSelectIndex* index, uint64_t k) {
+    if (k >= index->ones) {
+        return SIZE_MAX;
+    }
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_bmi2()) {
+        return select1_bmi2(index, k);
+    }
+#endif
+    unsigned rank;
+    size_t word = find_word(index, k, false, &rank);
+    return 64 * word + select_in_word(word_at(index, word), rank);
+}
+
+size_t rank_select_index_select0(const RankSelectIndex* index, uint64_t k) {
+    if (k >= index->bit_length - index->ones) {
+        return SIZE_MAX;
+    }
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_bmi2()) {
+        return select0_bmi2(index, k);
+    }
+#endif
+    unsigned rank;
+    size_t word = find_word(index, k, true, &rank);
+    return 64 * word + select_in_word(~word_at(index, word), rank);
+}
@@ -1,4 +1,5 @@
 #include "bit_stream.h"
+#include "bit_stream_bits.h"
 
 // Helper function to create a BitStreamResult with an error
 static BitStreamResult create_error_result(BitStreamErrorCode code, int io_errno) {
@@ -19,6 +20,26 @@ static BitStreamResult create_u64_result(uint64_t value) {
     return result;
 }
 
+// Helper function to create a BitStreamResult with an i64 value
+static BitStreamResult create_i64_result(int64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with an i128 value
+static BitStreamResult create_i128_result(Int128 value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i128 = value;
+    return result;
+}
+
 // Helper function to create a BitStreamResult with a u128 value
 static BitStreamResult create_u128_result(UInt128 value) {
     BitStreamResult result;
@@ -60,6 +81,7 @@ BitStreamReader* bit_stream_reader_with_capacity(FILE* file, size_t capacity) {
     reader->byte_pos = 0;
     reader->bit_pos = 0;
     reader->eof = false;
+    reader->backward_offset = 0;
     
     return reader;
 }
@@ -89,8 +111,58 @@ static BitStreamResult fill_buffer(BitStreamReader* reader) {
         reader->buffer_size = 0;
         reader->eof = true;
     } else {
-        // Successfully read bytes
+        // Successfully read bytes; a short read that hit the end of the file
+        // already tells us no more data follows
         reader->buffer_size = bytes_read;
+        if (bytes_read < reader->buffer_capacity && feof(reader->file)) {
+            reader->eof = true;
+        }
+    }
+    
+    return create_success_result();
+}
+
+// Called after a forward read: once the buffer is drained, load the next
+// chunk right away so the end of the file is known without another read.
+// A failed fill leaves eof unset and is reported by the next read.
+static void read_ahead(BitStreamReader* reader) {
+    if (reader->byte_pos >= reader->buffer_size && !reader->eof) {
+        fill_buffer(reader);
+    }
+}
+
+// Minimum buffer size that lets a 64-bit window be peeked at any bit offset
+#define PEEK_WINDOW_BYTES 9
+
+// Moves the unread bytes to the front of the buffer and tops it up from the
+// file, keeping the current bit position
+static BitStreamResult refill_buffer(BitStreamReader* reader) {
+    size_t unread = (reader->byte_pos < reader->buffer_size) ? reader->buffer_size - reader->byte_pos : 0;
+    if (unread > 0 && reader->byte_pos > 0) {
+        memmove(reader->buffer, reader->buffer + reader->byte_pos, unread);
+    }
+    reader->buffer_size = unread;
+    reader->byte_pos = 0;
+    
+    // Peeking needs room for a whole window
+    if (reader->buffer_capacity < PEEK_WINDOW_BYTES * 2) {
+        uint8_t* new_buffer = (uint8_t*)realloc(reader->buffer, PEEK_WINDOW_BYTES * 2);
+        if (new_buffer == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO, ENOMEM);
+        }
+        reader->buffer = new_buffer;
+        reader->buffer_capacity = PEEK_WINDOW_BYTES * 2;
+    }
+    
+    if (!reader->eof) {
+        size_t bytes_read = fread(reader->buffer + unread, 1, reader->buffer_capacity - unread, reader->file);
+        if (bytes_read == 0) {
+            if (ferror(reader->file)) {
+                return create_error_result(BIT_STREAM_ERROR_IO, errno);
+            }
+            reader->eof = true;
+        }
+        reader->buffer_size += bytes_read;
     }
     
     return create_success_result();
@@ -101,6 +173,39 @@ BitStreamResult bit_stream_reader_read_bits(BitStreamReader* reader, uint8_t bit
         return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
     }
     
+    // Fast path: every byte the value spans is already buffered, so it is
+    // gathered as a head, whole body bytes and a tail
+    size_t span = (reader->bit_pos + bit_count + 7) / 8;
+    if (reader->byte_pos + span <= reader->buffer_size) {
+        const uint8_t* src = reader->buffer + reader->byte_pos;
+        uint8_t bits_left_in_byte = 8 - reader->bit_pos;
+        uint8_t head_bits = (bit_count < bits_left_in_byte) ? bit_count : bits_left_in_byte;
+        
+        // Head: the least significant bits come from the current byte
+        uint64_t value = (src[0] >> (bits_left_in_byte - head_bits)) & ((1U << head_bits) - 1);
+        uint8_t shift = head_bits;
+        uint8_t remaining = bit_count - head_bits;
+        
+        // Body: whole bytes, least significant first
+        while (remaining >= 8) {
+            value |= (uint64_t)*++src << shift;
+            shift += 8;
+            remaining -= 8;
+        }
+        
+        // Tail: the most significant bits sit at the top of the next byte
+        if (remaining > 0) {
+            value |= (uint64_t)(*++src >> (8 - remaining)) << shift;
+        }
+        
+        size_t bit_offset = reader->bit_pos + bit_count;
+        reader->byte_pos += bit_offset / 8;
+        reader->bit_pos = bit_offset % 8;
+        read_ahead(reader);
+        
+        return create_u64_result(value);
+    }
+    
     uint64_t result = 0;
     uint8_t bits_read = 0;
     
@@ -135,11 +240,12 @@ BitStreamResult bit_stream_reader_read_bits(BitStreamReader* reader, uint8_t bit
         uint8_t bits_to_read = (bit_count - bits_read < bits_left_in_byte) ? 
                                (bit_count - bits_read) : bits_left_in_byte;
         
-        // Extract bits from the current byte (LSB first)
+        // Extract bits from the current byte; the writer fills each byte from
+        // its most significant bit down, least significant chunk first
         uint8_t mask = ((1U << bits_to_read) - 1);
-        uint8_t shift = reader->bit_pos;
+        uint8_t shift = bits_left_in_byte - bits_to_read;
         uint8_t extracted_bits = (current_byte >> shift) & mask;
-
+        
         // Add the extracted bits to the result (LSB first)
         result |= ((uint64_t)extracted_bits) << bits_read;
         bits_read += bits_to_read;
@@ -151,6 +257,7 @@ BitStreamResult bit_stream_reader_read_bits(BitStreamReader* reader, uint8_t bit
             reader->bit_pos = 0;
         }
     }
+    read_ahead(reader);
     
     return create_u64_result(result);
 }
@@ -198,5 +305,207 @@ BitStreamResult bit_stream_reader_read_bit_value(BitStreamReader* reader, uint8_
 }
 
 bool bit_stream_reader_is_eof(const BitStreamReader* reader) {
-    return reader->eof && reader->byte_pos >= reader->buffer_size;
-}
\ No newline at end of file
+    if (!reader->eof) {
+        return false;
+    }
+    
+    // The writer pads its final byte on flush, so once reading has started on
+    // the last byte of the file the bits left in it are padding
+    return reader->byte_pos >= reader->buffer_size ||
+           (reader->byte_pos + 1 == reader->buffer_size && reader->bit_pos > 0);
+}
+
+BitStreamResult bit_stream_reader_read_signed_bits(BitStreamReader* reader, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_read_bits(reader, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i64_result(int64_sign_extend(result.value.u64, bit_count));
+}
+
+BitStreamResult bit_stream_reader_read_signed_bits_i128(BitStreamReader* reader, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_read_bits_u128(reader, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i128_result(int128_sign_extend(result.value.u128, bit_count));
+}
+
+BitStreamResult bit_stream_reader_read_bits_batch(BitStreamReader* reader, uint64_t* values, size_t count, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_reader_read_bits(reader, bit_count);
+        if (!result.success) {
+            return result;
+        }
+        values[i] = result.value.u64;
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_signed_bits_batch(BitStreamReader* reader, int64_t* values, size_t count, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_read_bits_batch(reader, (uint64_t*)values, count, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    
+    // Branch-free sign extension over the whole column
+    uint64_t sign_bit = 1ULL << (bit_count - 1);
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (int64_t)(((uint64_t)values[i] ^ sign_bit) - sign_bit);
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_peek_bits_msb(BitStreamReader* reader, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    // Make sure a whole window is buffered unless the file ends first
+    if (reader->byte_pos + PEEK_WINDOW_BYTES > reader->buffer_size && !reader->eof) {
+        BitStreamResult fill_result = refill_buffer(reader);
+        if (!fill_result.success) {
+            return fill_result;
+        }
+    }
+    
+    // Bits past the end of the file read as zero
+    size_t available = (reader->byte_pos < reader->buffer_size) ? reader->buffer_size - reader->byte_pos : 0;
+    uint64_t window = bit_stream_window64(reader->buffer + reader->byte_pos, available, reader->bit_pos);
+    
+    return create_u64_result(window >> (64 - bit_count));
+}
+
+BitStreamResult bit_stream_reader_skip_bits(BitStreamReader* reader, size_t bit_count) {
+    size_t bit_offset = reader->bit_pos + bit_count;
+    
+    // Skip within the buffered bytes, refilling as they run out
+    while (reader->byte_pos + bit_offset / 8 >= reader->buffer_size) {
+        size_t buffered_bits = (reader->buffer_size - reader->byte_pos) * 8;
+        if (reader->byte_pos + bit_offset / 8 == reader->buffer_size && bit_offset % 8 == 0) {
+            break;
+        }
+        if (reader->eof) {
+            return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM, 0);
+        }
+        
+        bit_offset -= buffered_bits;
+        reader->byte_pos = reader->buffer_size;
+        reader->bit_pos = 0;
+        
+        BitStreamResult fill_result = fill_buffer(reader);
+        if (!fill_result.success) {
+            return fill_result;
+        }
+    }
+    
+    reader->byte_pos += bit_offset / 8;
+    reader->bit_pos = bit_offset % 8;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_bits_msb(BitStreamReader* reader, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_peek_bits_msb(reader, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    
+    // After a peek the value is either fully buffered or the file has ended
+    size_t available_bits = (reader->byte_pos < reader->buffer_size) ?
+                            (reader->buffer_size - reader->byte_pos) * 8 - reader->bit_pos : 0;
+    if (available_bits < bit_count) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM, 0);
+    }
+    
+    size_t bit_offset = reader->bit_pos + bit_count;
+    reader->byte_pos += bit_offset / 8;
+    reader->bit_pos = bit_offset % 8;
+    
+    return result;
+}
+
+// Moves the unread bytes to the back of the buffer and reads the bytes that
+// come before them in the file, keeping the current bit position
+static BitStreamResult refill_buffer_backward(BitStreamReader* reader) {
+    if (reader->buffer_capacity < PEEK_WINDOW_BYTES * 2) {
+        uint8_t* new_buffer = (uint8_t*)realloc(reader->buffer, PEEK_WINDOW_BYTES * 2);
+        if (new_buffer == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO, ENOMEM);
+        }
+        reader->buffer = new_buffer;
+        reader->buffer_capacity = PEEK_WINDOW_BYTES * 2;
+    }
+    
+    // The byte under a partial position still has unread bits before it
+    size_t unread = reader->byte_pos + (reader->bit_pos > 0 ? 1 : 0);
+    size_t room = reader->buffer_capacity - unread;
+    size_t bytes = (room < reader->backward_offset) ? room : reader->backward_offset;
+    if (bytes == 0) {
+        return create_success_result();
+    }
+    memmove(reader->buffer + bytes, reader->buffer, unread);
+    
+    reader->backward_offset -= bytes;
+    if (fseek(reader->file, (long)reader->backward_offset, SEEK_SET) != 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, errno);
+    }
+    if (fread(reader->buffer, 1, bytes, reader->file) != bytes) {
+        return create_error_result(BIT_STREAM_ERROR_IO, ferror(reader->file) ? errno : 0);
+    }
+    reader->byte_pos += bytes;
+    reader->buffer_size = bytes + unread;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_seek_end(BitStreamReader* reader) {
+    if (fseek(reader->file, 0, SEEK_END) != 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, errno);
+    }
+    long end = ftell(reader->file);
+    if (end < 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, errno);
+    }
+    
+    reader->backward_offset = (size_t)end;
+    reader->buffer_size = 0;
+    reader->byte_pos = 0;
+    reader->bit_pos = 0;
+    reader->eof = false;
+    
+    return refill_buffer_backward(reader);
+}
+
+BitStreamResult bit_stream_reader_read_bits_backward(BitStreamReader* reader, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    size_t position = reader->byte_pos * 8 + reader->bit_pos;
+    if (position < 64 && reader->backward_offset > 0) {
+        BitStreamResult fill_result = refill_buffer_backward(reader);
+        if (!fill_result.success) {
+            return fill_result;
+        }
+        position = reader->byte_pos * 8 + reader->bit_pos;
+    }
+    if (position < bit_count) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM, 0);
+    }
+    
+    uint64_t window = bit_stream_window64_before(reader->buffer, reader->buffer_size, position);
+    uint64_t value = (bit_count == 64) ? window : window & ((1ULL << bit_count) - 1);
+    
+    position -= bit_count;
+    reader->byte_pos = position / 8;
+    reader->bit_pos = position % 8;
+    
+    return create_u64_result(value);
+}
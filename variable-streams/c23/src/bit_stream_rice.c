@@ -0,0 +1,356 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// A Rice code with parameter k writes the quotient q = value >> k in unary
+// as q zero bits and a one bit, followed by the low k bits of the value.
+// Quotients of RICE_ESCAPE_QUOTIENT or more are escaped: that many zero bits
+// followed by the raw 64-bit value, so a single outlier cannot blow up a
+// block. A block is a 6-bit k followed by the codes of its values.
+//
+// Decoding takes q from a leading-zero count over a 64-bit window, so with
+// k <= 32 every non-escaped code is cut out of one window without a loop.
+
+#define RICE_ESCAPE_QUOTIENT 32
+#define RICE_K_BITS 6
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with a u64 value
+static BitStreamResult create_u64_result(uint64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.u64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+uint8_t rice_select_k(const uint64_t* values, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Smallest k with count * 2^k >= sum, i.e. 2^k >= the rounded-up mean
+    uint64_t sum_low = 0;
+    uint64_t sum_high = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum_low += values[i];
+        sum_high += (sum_low < values[i]);
+    }
+    if (sum_high != 0) {
+        return 63;
+    }
+    
+    uint64_t mean = sum_low / count + (sum_low % count != 0);
+    if (mean <= 1) {
+        return 0;
+    }
+    return (uint8_t)bit_stream_bit_width64(mean - 1);
+}
+
+// Decodes one code from the top of a window. Returns the code length, or 0
+// when the code is escaped or does not fit in the window.
+static inline unsigned rice_from_window(uint64_t window, uint8_t k, uint64_t* value) {
+    unsigned quotient = bit_stream_clz64(window | 1);
+    unsigned length = quotient + 1 + k;
+    if (quotient >= RICE_ESCAPE_QUOTIENT || length > 64) {
+        return 0;
+    }
+    uint64_t remainder = (k == 0) ? 0 : (window >> (64 - length)) & ((1ULL << k) - 1);
+    *value = ((uint64_t)quotient << k) | remainder;
+    return length;
+}
+
+// ---------------------------------------------------------------------------
+// BitStream
+// ---------------------------------------------------------------------------
+
+BitStreamResult bit_stream_write_rice(BitStream* stream, uint64_t value, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    
+    uint64_t quotient = value >> k;
+    if (quotient >= RICE_ESCAPE_QUOTIENT) {
+        BitStreamResult result = bit_stream_write_bits(stream, 0, RICE_ESCAPE_QUOTIENT);
+        if (!result.success) {
+            return result;
+        }
+        return bit_stream_write_bits(stream, value, 64);
+    }
+    
+    // The unary zeros are the leading bits of one field when it fits
+    uint64_t code = (1ULL << k) | (value & ((1ULL << k) - 1));
+    unsigned length = (unsigned)quotient + 1 + k;
+    if (length <= 64) {
+        return bit_stream_write_bits(stream, code, (uint8_t)length);
+    }
+    BitStreamResult result = bit_stream_write_bits(stream, 0, (uint8_t)quotient);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_write_bits(stream, code, (uint8_t)(k + 1));
+}
+
+static BitStreamErrorCode stream_decode_rice(BitStream* stream, uint8_t k, uint64_t* value) {
+    size_t position = bit_stream_position(stream);
+    size_t available = (stream->byte_pos < stream->buffer_size) ? stream->buffer_size - stream->byte_pos : 0;
+    uint64_t window = bit_stream_window64(stream->buffer + stream->byte_pos, available, stream->bit_pos);
+    
+    unsigned length = rice_from_window(window, k, value);
+    if (length > 0) {
+        if (length > stream->bit_length - position) {
+            return BIT_STREAM_ERROR_END_OF_STREAM;
+        }
+        position += length;
+        stream->byte_pos = position / 8;
+        stream->bit_pos = position % 8;
+        return BIT_STREAM_ERROR_NONE;
+    }
+    
+    unsigned quotient = bit_stream_clz64(window | 1);
+    if (quotient >= RICE_ESCAPE_QUOTIENT) {
+        if (!bit_stream_skip_bits(stream, RICE_ESCAPE_QUOTIENT).success) {
+            return BIT_STREAM_ERROR_END_OF_STREAM;
+        }
+        BitStreamResult result = bit_stream_read_bits(stream, 64);
+        if (!result.success) {
+            return result.error.code;
+        }
+        *value = result.value.u64;
+        return BIT_STREAM_ERROR_NONE;
+    }
+    
+    // Wide remainder: skip the prefix and read the k + 1 bits after it
+    if (!bit_stream_skip_bits(stream, quotient).success) {
+        return BIT_STREAM_ERROR_END_OF_STREAM;
+    }
+    BitStreamResult result = bit_stream_read_bits(stream, (uint8_t)(k + 1));
+    if (!result.success) {
+        return result.error.code;
+    }
+    *value = ((uint64_t)quotient << k) | (result.value.u64 & ((1ULL << k) - 1));
+    return BIT_STREAM_ERROR_NONE;
+}
+
+BitStreamResult bit_stream_read_rice(BitStream* stream, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    uint64_t value;
+    BitStreamErrorCode code = stream_decode_rice(stream, k, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_write_rice_block(BitStream* stream, const uint64_t* values, size_t count) {
+    uint8_t k = rice_select_k(values, count);
+    BitStreamResult result = bit_stream_write_bits(stream, k, RICE_K_BITS);
+    if (!result.success) {
+        return result;
+    }
+    for (size_t i = 0; i < count; i++) {
+        result = bit_stream_write_rice(stream, values[i], k);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+// Decodes count codes. While a full window remains in the stream, codes are
+// cut from one loaded window until the next one runs past its end, so the
+// loop carries only a shift and a leading-zero count between values. For
+// k <= 32 its only other branch is the rarely taken escape.
+static BitStreamErrorCode stream_decode_rice_run(BitStream* stream, uint8_t k, uint64_t* values, size_t count) {
+    const uint8_t* buffer = stream->buffer;
+    uint64_t mask = (1ULL << k) - 1;
+    size_t i = 0;
+    
+    while (i < count) {
+        if (k <= 32) {
+            size_t position = bit_stream_position(stream);
+            size_t bit_length = stream->bit_length;
+            size_t buffer_size = stream->buffer_size;
+            bool escaped = false;
+            while (i < count && !escaped && bit_length - position >= 64 && position / 8 + 9 <= buffer_size) {
+                size_t byte = position >> 3;
+                unsigned offset = position & 7;
+                uint64_t window = (bit_stream_load_be64(buffer + byte) << offset) | (uint64_t)(buffer[byte + 8] >> (8 - offset));
+                unsigned consumed = 0;
+                while (i < count) {
+                    uint64_t bits = window << consumed;
+                    unsigned quotient = bit_stream_clz64(bits | 1);
+                    unsigned length = quotient + 1 + k;
+                    if (quotient >= RICE_ESCAPE_QUOTIENT) {
+                        escaped = true;
+                        break;
+                    }
+                    if (consumed + length > 64) {
+                        break;
+                    }
+                    values[i++] = ((uint64_t)quotient << k) | ((bits >> (63 - quotient - k)) & mask);
+                    consumed += length;
+                    if (consumed == 64) {
+                        break;
+                    }
+                }
+                position += consumed;
+            }
+            stream->byte_pos = position / 8;
+            stream->bit_pos = position % 8;
+            if (i == count) {
+                break;
+            }
+        }
+        
+        // Escapes, wide remainders and the end of the stream
+        BitStreamErrorCode code = stream_decode_rice(stream, k, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return code;
+        }
+        i++;
+    }
+    return BIT_STREAM_ERROR_NONE;
+}
+
+BitStreamResult bit_stream_read_rice_block(BitStream* stream, uint64_t* values, size_t count) {
+    BitStreamResult result = bit_stream_read_bits(stream, RICE_K_BITS);
+    if (!result.success) {
+        return result;
+    }
+    BitStreamErrorCode code = stream_decode_rice_run(stream, (uint8_t)result.value.u64, values, count);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// BitStreamReader / BitStreamWriter
+// ---------------------------------------------------------------------------
+
+BitStreamResult bit_stream_writer_write_rice(BitStreamWriter* writer, uint64_t value, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    
+    uint64_t quotient = value >> k;
+    if (quotient >= RICE_ESCAPE_QUOTIENT) {
+        BitStreamResult result = bit_stream_writer_write_bits_msb(writer, 0, RICE_ESCAPE_QUOTIENT);
+        if (!result.success) {
+            return result;
+        }
+        return bit_stream_writer_write_bits_msb(writer, value, 64);
+    }
+    
+    uint64_t code = (1ULL << k) | (value & ((1ULL << k) - 1));
+    unsigned length = (unsigned)quotient + 1 + k;
+    if (length <= 64) {
+        return bit_stream_writer_write_bits_msb(writer, code, (uint8_t)length);
+    }
+    BitStreamResult result = bit_stream_writer_write_bits_msb(writer, 0, (uint8_t)quotient);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_writer_write_bits_msb(writer, code, (uint8_t)(k + 1));
+}
+
+BitStreamResult bit_stream_writer_write_rice_block(BitStreamWriter* writer, const uint64_t* values, size_t count) {
+    uint8_t k = rice_select_k(values, count);
+    BitStreamResult result = bit_stream_writer_write_bits_msb(writer, k, RICE_K_BITS);
+    if (!result.success) {
+        return result;
+    }
+    for (size_t i = 0; i < count; i++) {
+        result = bit_stream_writer_write_rice(writer, values[i], k);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+static BitStreamErrorCode reader_decode_rice(BitStreamReader* reader, uint8_t k, uint64_t* value) {
+    BitStreamResult result = bit_stream_reader_peek_bits_msb(reader, 64);
+    if (!result.success) {
+        return result.error.code;
+    }
+    uint64_t window = result.value.u64;
+    
+    unsigned length = rice_from_window(window, k, value);
+    if (length > 0) {
+        result = bit_stream_reader_skip_bits(reader, length);
+        return result.success ? BIT_STREAM_ERROR_NONE : result.error.code;
+    }
+    
+    unsigned quotient = bit_stream_clz64(window | 1);
+    if (quotient >= RICE_ESCAPE_QUOTIENT) {
+        result = bit_stream_reader_skip_bits(reader, RICE_ESCAPE_QUOTIENT);
+        if (!result.success) {
+            return result.error.code;
+        }
+        result = bit_stream_reader_read_bits_msb(reader, 64);
+        if (!result.success) {
+            return result.error.code;
+        }
+        *value = result.value.u64;
+        return BIT_STREAM_ERROR_NONE;
+    }
+    
+    result = bit_stream_reader_skip_bits(reader, quotient);
+    if (!result.success) {
+        return result.error.code;
+    }
+    result = bit_stream_reader_read_bits_msb(reader, (uint8_t)(k + 1));
+    if (!result.success) {
+        return result.error.code;
+    }
+    *value = ((uint64_t)quotient << k) | (result.value.u64 & ((1ULL << k) - 1));
+    return BIT_STREAM_ERROR_NONE;
+}
+
+BitStreamResult bit_stream_reader_read_rice(BitStreamReader* reader, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    uint64_t value;
+    BitStreamErrorCode code = reader_decode_rice(reader, k, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_reader_read_rice_block(BitStreamReader* reader, uint64_t* values, size_t count) {
+    BitStreamResult result = bit_stream_reader_read_bits_msb(reader, RICE_K_BITS);
+    if (!result.success) {
+        return result;
+    }
+    uint8_t k = (uint8_t)result.value.u64;
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = reader_decode_rice(reader, k, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+    }
+    return create_success_result();
+}
@@ -0,0 +1,260 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+
+// Parquet's RLE/bit-packing hybrid for values of up to 32 bits. The data is
+// a sequence of runs, each starting with a ULEB128 header:
+//
+//   RLE run:         header = count << 1, then the repeated value in
+//                    ceil(bit_width / 8) little-endian bytes
+//   bit-packed run:  header = groups << 1 | 1, then groups * 8 values packed
+//                    LSB first, bit_width bytes per group of 8
+//
+// Only the last bit-packed run may hold padding values past the end. The
+// encoder takes repeats of at least 8 values as RLE runs after topping the
+// preceding bit-packed run up to whole groups.
+//
+// On a BitStream the data starts at the next byte boundary.
+
+#define RLE_GROUP_SIZE 8
+#define RLE_MAX_BIT_WIDTH 32
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+static inline size_t value_bytes(uint8_t bit_width) {
+    return (bit_width + 7U) / 8;
+}
+
+size_t rle_hybrid_max_encoded_length(size_t count, uint8_t bit_width) {
+    // RLE runs cover at least 8 values, each bit-packed run sits between two
+    // of them and is padded by at most one group
+    size_t runs = 2 * (count / RLE_GROUP_SIZE) + 2;
+    return runs * (LEB128_MAX_BYTES + value_bytes(bit_width)) + (count / RLE_GROUP_SIZE + runs + 1) * bit_width;
+}
+
+// Packs values[0..count) LSB first as whole groups of 8, zero padded
+static size_t pack_groups(const uint32_t* values, size_t count, uint8_t bit_width, uint8_t* bytes) {
+    size_t groups = (count + RLE_GROUP_SIZE - 1) / RLE_GROUP_SIZE;
+    size_t length = groups * bit_width;
+    uint64_t buffer = 0;
+    unsigned buffered = 0;
+    size_t out = 0;
+    for (size_t i = 0; i < groups * RLE_GROUP_SIZE; i++) {
+        uint64_t value = (i < count) ? values[i] : 0;
+        buffer |= value << buffered;
+        buffered += bit_width;
+        while (buffered >= 8) {
+            bytes[out++] = (uint8_t)buffer;
+            buffer >>= 8;
+            buffered -= 8;
+        }
+    }
+    return length;
+}
+
+static size_t write_bit_packed_run(const uint32_t* values, size_t count, uint8_t bit_width, uint8_t* bytes) {
+    size_t groups = (count + RLE_GROUP_SIZE - 1) / RLE_GROUP_SIZE;
+    size_t length = leb128_encode_u64(((uint64_t)groups << 1) | 1, bytes);
+    return length + pack_groups(values, count, bit_width, bytes + length);
+}
+
+static size_t write_rle_run(uint32_t value, size_t count, uint8_t bit_width, uint8_t* bytes) {
+    size_t length = leb128_encode_u64((uint64_t)count << 1, bytes);
+    for (size_t b = 0; b < value_bytes(bit_width); b++) {
+        bytes[length++] = (uint8_t)(value >> (8 * b));
+    }
+    return length;
+}
+
+size_t rle_hybrid_encode(const uint32_t* values, size_t count, uint8_t bit_width, uint8_t* bytes) {
+    size_t length = 0;
+    size_t literal_start = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && values[i + run] == values[i]) {
+            run++;
+        }
+        
+        // Literals before a repeat are topped up to whole groups from it
+        size_t literals = i - literal_start;
+        size_t pad = (RLE_GROUP_SIZE - literals % RLE_GROUP_SIZE) % RLE_GROUP_SIZE;
+        if (run < pad + RLE_GROUP_SIZE) {
+            i += run;
+            continue;
+        }
+        if (literals > 0) {
+            length += write_bit_packed_run(values + literal_start, literals + pad, bit_width, bytes + length);
+            i += pad;
+            run -= pad;
+        }
+        length += write_rle_run(values[i], run, bit_width, bytes + length);
+        i += run;
+        literal_start = i;
+    }
+    if (literal_start < count) {
+        length += write_bit_packed_run(values + literal_start, count - literal_start, bit_width, bytes + length);
+    }
+    return length;
+}
+
+// Unpacks one group of 8 values from bit_width bytes
+static inline void unpack_group(const uint8_t* bytes, uint8_t bit_width, uint32_t* values) {
+    uint32_t mask = (bit_width == 32) ? 0xFFFFFFFFU : (1U << bit_width) - 1;
+    for (unsigned i = 0; i < RLE_GROUP_SIZE; i++) {
+        size_t bit = (size_t)i * bit_width;
+        size_t first = bit / 8;
+        size_t last = (bit + bit_width + 7) / 8;
+        uint64_t word = 0;
+        for (size_t b = first; b < last; b++) {
+            word |= (uint64_t)bytes[b] << (8 * (b - first));
+        }
+        values[i] = (uint32_t)(word >> (bit % 8)) & mask;
+    }
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+// Unpacks whole groups of up to 25-bit values, where every value lies in a
+// 4-byte load from its first byte, with one gather per group; returns the
+// number of groups done. The last load of a group may reach 3 bytes past
+// it, so groups stop where that would leave the readable bytes.
+BIT_STREAM_TARGET_AVX2
+static size_t unpack_groups_avx2(const uint8_t* bytes, size_t readable, size_t groups, uint8_t bit_width, uint32_t* values) {
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i bits = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(bit_width));
+    const __m256i offsets = _mm256_srli_epi32(bits, 3);
+    const __m256i shifts = _mm256_and_si256(bits, _mm256_set1_epi32(7));
+    const __m256i mask = _mm256_set1_epi32((int)((1U << bit_width) - 1));
+    size_t g = 0;
+    for (; g < groups && (g + 1) * bit_width + 3 <= readable; g++) {
+        __m256i words = _mm256_i32gather_epi32((const int*)(bytes + g * bit_width), offsets, 1);
+        __m256i result = _mm256_and_si256(_mm256_srlv_epi32(words, shifts), mask);
+        _mm256_storeu_si256((__m256i*)(values + g * RLE_GROUP_SIZE), result);
+    }
+    return g;
+}
+#endif
+
+size_t rle_hybrid_decode(const uint8_t* bytes, size_t length, uint8_t bit_width, uint32_t* values, size_t count) {
+    if (bit_width > RLE_MAX_BIT_WIDTH) {
+        return 0;
+    }
+    
+    size_t in = 0;
+    size_t i = 0;
+    while (i < count) {
+        uint64_t header;
+        size_t header_length = leb128_decode_u64(bytes + in, length - in, &header);
+        if (header_length == 0) {
+            return 0;
+        }
+        in += header_length;
+        
+        if ((header & 1) == 0) {
+            // RLE run; it may not reach past the values asked for
+            uint64_t run = header >> 1;
+            size_t run_bytes = value_bytes(bit_width);
+            if (run > count - i || run_bytes > length - in) {
+                return 0;
+            }
+            uint32_t value = 0;
+            for (size_t b = 0; b < run_bytes; b++) {
+                value |= (uint32_t)bytes[in + b] << (8 * b);
+            }
+            in += run_bytes;
+            for (uint64_t k = 0; k < run; k++) {
+                values[i++] = value;
+            }
+            continue;
+        }
+        
+        // Bit-packed run; padding in a last group past count is skipped
+        uint64_t groups = header >> 1;
+        if (bit_width > 0 && groups > (length - in) / bit_width) {
+            return 0;
+        }
+        size_t run_bytes = (size_t)groups * bit_width;
+        size_t whole_groups = (count - i) / RLE_GROUP_SIZE;
+        whole_groups = (whole_groups < groups) ? whole_groups : (size_t)groups;
+        size_t g = 0;
+#ifdef BIT_STREAM_X86_SIMD
+        if (bit_width > 0 && bit_width <= 25 && bit_stream_cpu_has_avx2()) {
+            g = unpack_groups_avx2(bytes + in, length - in, whole_groups, bit_width, values + i);
+        }
+#endif
+        for (; g < groups && i + g * RLE_GROUP_SIZE < count; g++) {
+            uint32_t group[RLE_GROUP_SIZE];
+            unpack_group(bytes + in + g * bit_width, bit_width, group);
+            size_t take = count - i - g * RLE_GROUP_SIZE;
+            take = (take < RLE_GROUP_SIZE) ? take : RLE_GROUP_SIZE;
+            memcpy(values + i + g * RLE_GROUP_SIZE, group, take * sizeof(uint32_t));
+        }
+        i = (groups < (count - i + RLE_GROUP_SIZE - 1) / RLE_GROUP_SIZE) ? i + (size_t)groups * RLE_GROUP_SIZE : count;
+        in += run_bytes;
+    }
+    return in;
+}
+
+// Whole bytes between the (aligned) position and the end of the stream
+static inline size_t aligned_bytes_left(const BitStream* stream) {
+    size_t end = stream->bit_length / 8;
+    return (stream->byte_pos < end) ? end - stream->byte_pos : 0;
+}
+
+BitStreamResult bit_stream_write_rle_hybrid(BitStream* stream, const uint32_t* values, size_t count, uint8_t bit_width) {
+    if (bit_width > RLE_MAX_BIT_WIDTH) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (bit_stream_bit_width64(values[i]) > bit_width) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+    }
+    
+    uint8_t* bytes = (uint8_t*)malloc(rle_hybrid_max_encoded_length(count, bit_width));
+    if (bytes == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    size_t length = rle_hybrid_encode(values, count, bit_width, bytes);
+    
+    BitStreamResult result = bit_stream_align(stream);
+    if (result.success) {
+        result = bit_stream_write_bytes(stream, bytes, length);
+    }
+    free(bytes);
+    return result;
+}
+
+BitStreamResult bit_stream_read_rle_hybrid(BitStream* stream, uint32_t* values, size_t count, uint8_t bit_width) {
+    if (bit_width > RLE_MAX_BIT_WIDTH) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    BitStreamResult result = bit_stream_align_read(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    size_t length = rle_hybrid_decode(stream->buffer + stream->byte_pos, aligned_bytes_left(stream), bit_width, values, count);
+    if (length == 0 && count > 0) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    
+    stream->byte_pos += length;
+    return create_success_result();
+}
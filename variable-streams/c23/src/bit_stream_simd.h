@@ -0,0 +1,42 @@
+#ifndef BIT_STREAM_SIMD_H
+#define BIT_STREAM_SIMD_H
+
+// Internal helpers for the vectorised kernels. Kernels are compiled for
+// their instruction set with a target attribute and selected at run time,
+// so the library itself still builds for the baseline architecture.
+
+#include <stdbool.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BIT_STREAM_X86_SIMD 1
+#include <immintrin.h>
+
+#define BIT_STREAM_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BIT_STREAM_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define BIT_STREAM_TARGET_AVX2 __attribute__((target("avx2")))
+#define BIT_STREAM_TARGET_POPCNT __attribute__((target("popcnt")))
+// Every BMI2 processor also has popcnt and tzcnt
+#define BIT_STREAM_TARGET_BMI2 __attribute__((target("popcnt,bmi,bmi2")))
+
+static inline bool bit_stream_cpu_has_ssse3(void) {
+    return __builtin_cpu_supports("ssse3");
+}
+
+static inline bool bit_stream_cpu_has_sse41(void) {
+    return __builtin_cpu_supports("sse4.1");
+}
+
+static inline bool bit_stream_cpu_has_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+static inline bool bit_stream_cpu_has_popcnt(void) {
+    return __builtin_cpu_supports("popcnt");
+}
+
+static inline bool bit_stream_cpu_has_bmi2(void) {
+    return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("popcnt");
+}
+#endif
+
+#endif /* BIT_STREAM_SIMD_H */
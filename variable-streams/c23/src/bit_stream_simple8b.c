@@ -0,0 +1,171 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Simple-8b packs as many equal-width integers as fit into the low 60 bits
+// of a 64-bit word, first value in the least significant bits, with a
+// 4-bit selector in the top bits naming the width:
+//
+//   selector  0    1    2   3   4   5   6   7   8   9  10  11  12  13  14  15
+//   values  240  120   60  30  20  15  12  10   8   7   6   5   4   3   2   1
+//   bits      0    0    1   2   3   4   5   6   7   8  10  12  15  20  30  60
+//
+// Values never straddle words, so decoding is a jump on the selector into
+// a fixed-width unpack. On a BitStream the words start on a byte boundary
+// and are stored big-endian, like any other 64-bit field.
+
+#define SIMPLE8B_SELECTORS 16
+#define SIMPLE8B_PAYLOAD_BITS 60
+
+static const uint8_t simple8b_counts[SIMPLE8B_SELECTORS] = {
+    240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1
+};
+
+static const uint8_t simple8b_widths[SIMPLE8B_SELECTORS] = {
+    0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60
+};
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+size_t simple8b_pack_word(const uint64_t* values, size_t count, uint64_t* word) {
+    if (count == 0 || values[0] >> SIMPLE8B_PAYLOAD_BITS != 0) {
+        return 0;
+    }
+    
+    // Try selectors from one value upwards; once the widest of the first n
+    // values no longer fits, no selector with more values can fit either
+    uint64_t combined = 0;
+    size_t scanned = 0;
+    int selector = SIMPLE8B_SELECTORS - 1;
+    for (int candidate = SIMPLE8B_SELECTORS - 1; candidate >= 0; candidate--) {
+        size_t n = simple8b_counts[candidate];
+        if (n > count) {
+            break;
+        }
+        while (scanned < n) {
+            combined |= values[scanned++];
+        }
+        if (bit_stream_bit_width64(combined) > simple8b_widths[candidate]) {
+            break;
+        }
+        selector = candidate;
+    }
+    
+    size_t n = simple8b_counts[selector];
+    uint8_t width = simple8b_widths[selector];
+    uint64_t packed = (uint64_t)selector << SIMPLE8B_PAYLOAD_BITS;
+    for (size_t i = 0; i < n && width > 0; i++) {
+        packed |= values[i] << (i * width);
+    }
+    *word = packed;
+    return n;
+}
+
+// Unpacks n values of a fixed width; called with constants so that each
+// selector gets its own unrolled loop
+static inline void unpack_fixed(uint64_t word, uint64_t* values, unsigned n, unsigned width) {
+    uint64_t mask = (1ULL << width) - 1;
+    for (unsigned i = 0; i < n; i++) {
+        values[i] = (word >> (i * width)) & mask;
+    }
+}
+
+size_t simple8b_unpack_word(uint64_t word, uint64_t* values) {
+    switch (word >> SIMPLE8B_PAYLOAD_BITS) {
+        case 0: memset(values, 0, 240 * sizeof(uint64_t)); return 240;
+        case 1: memset(values, 0, 120 * sizeof(uint64_t)); return 120;
+        case 2: unpack_fixed(word, values, 60, 1); return 60;
+        case 3: unpack_fixed(word, values, 30, 2); return 30;
+        case 4: unpack_fixed(word, values, 20, 3); return 20;
+        case 5: unpack_fixed(word, values, 15, 4); return 15;
+        case 6: unpack_fixed(word, values, 12, 5); return 12;
+        case 7: unpack_fixed(word, values, 10, 6); return 10;
+        case 8: unpack_fixed(word, values, 8, 7); return 8;
+        case 9: unpack_fixed(word, values, 7, 8); return 7;
+        case 10: unpack_fixed(word, values, 6, 10); return 6;
+        case 11: unpack_fixed(word, values, 5, 12); return 5;
+        case 12: unpack_fixed(word, values, 4, 15); return 4;
+        case 13: unpack_fixed(word, values, 3, 20); return 3;
+        case 14: unpack_fixed(word, values, 2, 30); return 2;
+        default: unpack_fixed(word, values, 1, 60); return 1;
+    }
+}
+
+BitStreamResult bit_stream_write_simple8b(BitStream* stream, const uint64_t* values, size_t count) {
+    BitStreamResult result = bit_stream_align(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    // Pack words in chunks on the stack and append each chunk in one copy
+    uint8_t bytes[64 * 8];
+    size_t i = 0;
+    while (i < count) {
+        size_t length = 0;
+        while (i < count && length < sizeof(bytes)) {
+            uint64_t word;
+            size_t packed = simple8b_pack_word(values + i, count - i, &word);
+            if (packed == 0) {
+                return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+            }
+            for (int b = 0; b < 8; b++) {
+                bytes[length++] = (uint8_t)(word >> (56 - 8 * b));
+            }
+            i += packed;
+        }
+        result = bit_stream_write_bytes(stream, bytes, length);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_simple8b(BitStream* stream, uint64_t* values, size_t count) {
+    BitStreamResult result = bit_stream_align_read(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    const uint8_t* bytes = stream->buffer + stream->byte_pos;
+    size_t end = stream->bit_length / 8;
+    size_t available = (stream->byte_pos < end) ? end - stream->byte_pos : 0;
+    size_t offset = 0;
+    size_t i = 0;
+    
+    // The encoder never packs a word with more values than remain, so each
+    // word unpacks straight into the output
+    while (i < count) {
+        if (available - offset < 8) {
+            stream->byte_pos += offset;
+            return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+        }
+        uint64_t word = bit_stream_load_be64(bytes + offset);
+        size_t n = simple8b_counts[word >> SIMPLE8B_PAYLOAD_BITS];
+        if (n > count - i) {
+            stream->byte_pos += offset;
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        simple8b_unpack_word(word, values + i);
+        i += n;
+        offset += 8;
+    }
+    
+    stream->byte_pos += offset;
+    return create_success_result();
+}
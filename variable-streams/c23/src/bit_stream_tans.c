@@ -0,0 +1,477 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Table-based asymmetric numeral systems (tANS, as in FSE). Symbol counts
+// are normalized to sum to 2^table_log and spread over a table of that many
+// states. Encoding runs over the symbols last to first and writes the low
+// bits of each state forward; decoding starts from the end and reads those
+// bits backward, so symbols come out first to last. Symbols at even and odd
+// indexes go through two interleaved states, which lets the decoder overlap
+// two table lookups. The payload is
+//
+//   state bits of each symbol | odd state | even state | marker bit 1
+//
+// with both final states taking table_log bits, and a backward read skips
+// any zero padding after the marker. The table
+// header carries the normalized counts:
+//
+//   table_log (4 bits) | symbol count (9 bits) | count of each symbol
+//
+// where each count takes as many bits as the part of 2^table_log not yet
+// handed out needs, so counts after the table is full take no bits.
+
+#define TANS_LOG_BITS 4
+#define TANS_COUNT_BITS 9
+#define TANS_TABLE_SIZE (1U << TANS_MAX_TABLE_LOG)
+
+typedef struct {
+    uint16_t base;       // Next state before the bits read are added
+    uint8_t symbol;
+    uint8_t bit_count;   // Bits read to reach the next state
+} TansDecodeEntry;
+
+typedef struct {
+    int32_t delta_find_state;  // Offset of the symbol's states in the state table
+    uint32_t delta_bit_count;  // (state + delta_bit_count) >> 16 is the bits to emit
+} TansSymbolTransform;
+
+struct TansCode {
+    uint8_t table_log;
+    size_t symbol_count;
+    uint16_t counts[TANS_MAX_SYMBOLS];
+    TansDecodeEntry decode[TANS_TABLE_SIZE];
+    uint16_t states[TANS_TABLE_SIZE];
+    TansSymbolTransform transforms[TANS_MAX_SYMBOLS];
+};
+
+// Destination of encoded fields, so the stream and writer share one encoder
+typedef BitStreamResult (*TansWriteFn)(void* target, uint64_t value, uint8_t bit_count);
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Scales the histogram so the counts sum to 2^table_log, keeping every used
+// symbol at a count of at least 1; fails when no symbol is used or more
+// symbols are used than there are states
+static bool normalize_counts(const uint64_t* histogram, size_t symbol_count, uint8_t table_log, uint16_t* counts) {
+    uint64_t total = 0;
+    size_t used = 0;
+    for (size_t s = 0; s < symbol_count; s++) {
+        total += histogram[s];
+        used += (histogram[s] > 0) ? 1 : 0;
+    }
+    uint32_t size = 1U << table_log;
+    if (used == 0 || used > size) {
+        return false;
+    }
+    
+    uint32_t sum = 0;
+    for (size_t s = 0; s < symbol_count; s++) {
+        uint32_t count = 0;
+        if (histogram[s] > 0) {
+            count = (uint32_t)((double)histogram[s] * size / (double)total + 0.5);
+            count = (count == 0) ? 1 : count;
+        }
+        counts[s] = (uint16_t)count;
+        sum += count;
+    }
+    
+    // Settle the rounding error on the most frequent symbols, where it
+    // costs the least
+    while (sum != size) {
+        size_t largest = 0;
+        for (size_t s = 1; s < symbol_count; s++) {
+            if (counts[s] > counts[largest]) {
+                largest = s;
+            }
+        }
+        if (sum < size) {
+            counts[largest] = (uint16_t)(counts[largest] + size - sum);
+            sum = size;
+        } else {
+            uint32_t excess = sum - size;
+            uint32_t take = (counts[largest] - 1U < excess) ? counts[largest] - 1U : excess;
+            counts[largest] = (uint16_t)(counts[largest] - take);
+            sum -= take;
+        }
+    }
+    return true;
+}
+
+// Spreads the symbols over the states and builds the decode table, the
+// encoder's state table and the per-symbol transforms from the counts
+static void build_tables(TansCode* code) {
+    uint32_t size = 1U << code->table_log;
+    uint32_t mask = size - 1;
+    
+    // The step is odd, so it visits every state once
+    uint32_t step = (size >> 1) + (size >> 3) + 3;
+    uint8_t spread[TANS_TABLE_SIZE];
+    uint32_t position = 0;
+    for (size_t s = 0; s < code->symbol_count; s++) {
+        for (uint32_t i = 0; i < code->counts[s]; i++) {
+            spread[position] = (uint8_t)s;
+            position = (position + step) & mask;
+        }
+    }
+    
+    uint32_t next[TANS_MAX_SYMBOLS];
+    uint32_t cumulative[TANS_MAX_SYMBOLS];
+    uint32_t total = 0;
+    for (size_t s = 0; s < code->symbol_count; s++) {
+        uint32_t count = code->counts[s];
+        next[s] = count;
+        cumulative[s] = total;
+        
+        TansSymbolTransform* transform = &code->transforms[s];
+        if (count == 1) {
+            transform->delta_bit_count = ((uint32_t)code->table_log << 16) - size;
+            transform->delta_find_state = (int32_t)total - 1;
+        } else if (count > 1) {
+            uint32_t max_bits = code->table_log - (bit_stream_bit_width64(count - 1) - 1);
+            transform->delta_bit_count = (max_bits << 16) - (count << max_bits);
+            transform->delta_find_state = (int32_t)total - (int32_t)count;
+        }
+        total += count;
+    }
+    
+    for (uint32_t u = 0; u < size; u++) {
+        uint8_t s = spread[u];
+        uint32_t x = next[s]++;
+        uint8_t bit_count = (uint8_t)(code->table_log - (bit_stream_bit_width64(x) - 1));
+        code->decode[u].symbol = s;
+        code->decode[u].bit_count = bit_count;
+        code->decode[u].base = (uint16_t)((x << bit_count) - size);
+        code->states[cumulative[s]++] = (uint16_t)(size + u);
+    }
+}
+
+TansCode* tans_code_from_histogram(const uint64_t* histogram, size_t symbol_count, uint8_t table_log) {
+    if (symbol_count > TANS_MAX_SYMBOLS || table_log < TANS_MIN_TABLE_LOG || table_log > TANS_MAX_TABLE_LOG) {
+        return NULL;
+    }
+    TansCode* code = (TansCode*)malloc(sizeof(TansCode));
+    if (code == NULL) {
+        return NULL;
+    }
+    
+    code->table_log = table_log;
+    code->symbol_count = symbol_count;
+    if (!normalize_counts(histogram, symbol_count, table_log, code->counts)) {
+        free(code);
+        return NULL;
+    }
+    build_tables(code);
+    return code;
+}
+
+void tans_code_free(TansCode* code) {
+    free(code);
+}
+
+uint16_t tans_code_normalized_count(const TansCode* code, uint8_t symbol) {
+    return (symbol < code->symbol_count) ? code->counts[symbol] : 0;
+}
+
+// Rebuilds a code from header counts, which must fill the table exactly
+static BitStreamErrorCode code_from_counts(uint8_t table_log, const uint16_t* counts, size_t symbol_count, TansCode** out) {
+    uint32_t sum = 0;
+    for (size_t s = 0; s < symbol_count; s++) {
+        sum += counts[s];
+    }
+    if (sum != (1U << table_log)) {
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    
+    TansCode* code = (TansCode*)malloc(sizeof(TansCode));
+    if (code == NULL) {
+        return BIT_STREAM_ERROR_IO;
+    }
+    code->table_log = table_log;
+    code->symbol_count = symbol_count;
+    memcpy(code->counts, counts, symbol_count * sizeof(uint16_t));
+    build_tables(code);
+    *out = code;
+    return BIT_STREAM_ERROR_NONE;
+}
+
+// Writes the table header through write
+static BitStreamResult write_table(const TansCode* code, TansWriteFn write, void* target) {
+    BitStreamResult result = write(target, code->table_log, TANS_LOG_BITS);
+    if (result.success) {
+        result = write(target, code->symbol_count, TANS_COUNT_BITS);
+    }
+    uint32_t remaining = 1U << code->table_log;
+    for (size_t s = 0; s < code->symbol_count && result.success && remaining > 0; s++) {
+        result = write(target, code->counts[s], (uint8_t)bit_stream_bit_width64(remaining));
+        remaining -= code->counts[s];
+    }
+    return result;
+}
+
+// Encodes the payload through write, gathering state bits into 64-bit fields
+static BitStreamResult write_payload(const TansCode* code, const uint8_t* symbols, size_t count,
+                                     TansWriteFn write, void* target) {
+    uint32_t size = 1U << code->table_log;
+    uint32_t states[2] = {size, size};
+    uint64_t pending = 0;
+    unsigned pending_bits = 0;
+    
+    for (size_t i = count; i-- > 0;) {
+        uint8_t symbol = symbols[i];
+        if (symbol >= code->symbol_count || code->counts[symbol] == 0) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        const TansSymbolTransform* transform = &code->transforms[symbol];
+        uint32_t state = states[i & 1];
+        unsigned bit_count = (state + transform->delta_bit_count) >> 16;
+        if (pending_bits + bit_count > 64) {
+            BitStreamResult result = write(target, pending, (uint8_t)pending_bits);
+            if (!result.success) {
+                return result;
+            }
+            pending = 0;
+            pending_bits = 0;
+        }
+        pending = (pending << bit_count) | (state & ((1U << bit_count) - 1));
+        pending_bits += bit_count;
+        states[i & 1] = code->states[(int32_t)(state >> bit_count) + transform->delta_find_state];
+    }
+    
+    // The final states and the marker bit close the payload
+    if (pending_bits + 2U * code->table_log + 1 > 64) {
+        BitStreamResult result = write(target, pending, (uint8_t)pending_bits);
+        if (!result.success) {
+            return result;
+        }
+        pending = 0;
+        pending_bits = 0;
+    }
+    pending = (pending << code->table_log) | (states[1] - size);
+    pending = (pending << code->table_log) | (states[0] - size);
+    pending = (pending << 1) | 1;
+    pending_bits += 2U * code->table_log + 1;
+    return write(target, pending, (uint8_t)pending_bits);
+}
+
+// ---------------------------------------------------------------------------
+// BitStream
+// ---------------------------------------------------------------------------
+
+static BitStreamResult stream_write(void* target, uint64_t value, uint8_t bit_count) {
+    return bit_stream_write_bits((BitStream*)target, value, bit_count);
+}
+
+BitStreamResult bit_stream_write_tans_table(BitStream* stream, const TansCode* code) {
+    return write_table(code, stream_write, stream);
+}
+
+BitStreamResult bit_stream_read_tans_table(BitStream* stream, TansCode** code) {
+    BitStreamResult result = bit_stream_read_bits(stream, TANS_LOG_BITS);
+    if (!result.success) {
+        return result;
+    }
+    uint8_t table_log = (uint8_t)result.value.u64;
+    result = bit_stream_read_bits(stream, TANS_COUNT_BITS);
+    if (!result.success) {
+        return result;
+    }
+    size_t symbol_count = result.value.u64;
+    if (table_log < TANS_MIN_TABLE_LOG || table_log > TANS_MAX_TABLE_LOG || symbol_count > TANS_MAX_SYMBOLS) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint16_t counts[TANS_MAX_SYMBOLS] = {0};
+    uint32_t remaining = 1U << table_log;
+    for (size_t s = 0; s < symbol_count && remaining > 0; s++) {
+        result = bit_stream_read_bits(stream, (uint8_t)bit_stream_bit_width64(remaining));
+        if (!result.success) {
+            return result;
+        }
+        if (result.value.u64 > remaining) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        counts[s] = (uint16_t)result.value.u64;
+        remaining -= counts[s];
+    }
+    
+    BitStreamErrorCode error = code_from_counts(table_log, counts, symbol_count, code);
+    if (error != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(error);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_tans(BitStream* stream, const TansCode* code, const uint8_t* symbols, size_t count) {
+    return write_payload(code, symbols, count, stream_write, stream);
+}
+
+BitStreamResult bit_stream_read_tans(BitStream* stream, const TansCode* code, uint8_t* symbols, size_t count) {
+    size_t position = bit_stream_position(stream);
+    
+    // Step back over the zero padding and the marker bit
+    unsigned padding = 0;
+    while (true) {
+        if (position == 0) {
+            return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+        }
+        position--;
+        if ((stream->buffer[position / 8] >> (7 - position % 8)) & 1) {
+            break;
+        }
+        if (++padding == 8) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+    }
+    
+    if (position < 2U * code->table_log) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    uint32_t mask = (1U << code->table_log) - 1;
+    uint64_t window = bit_stream_window64_before(stream->buffer, stream->buffer_size, position);
+    uint32_t even = (uint32_t)window & mask;
+    uint32_t odd = (uint32_t)(window >> code->table_log) & mask;
+    position -= 2U * code->table_log;
+    
+    // Several symbol pairs are served from each 64-bit window; each symbol
+    // reads at most table_log bits
+    size_t i = 0;
+    while (i < count) {
+        window = bit_stream_window64_before(stream->buffer, stream->buffer_size, position);
+        unsigned consumed = 0;
+        while (i + 2 <= count && consumed + 2U * code->table_log <= 64) {
+            const TansDecodeEntry* even_entry = &code->decode[even];
+            const TansDecodeEntry* odd_entry = &code->decode[odd];
+            symbols[i] = even_entry->symbol;
+            symbols[i + 1] = odd_entry->symbol;
+            even = even_entry->base + ((uint32_t)(window >> consumed) & ((1U << even_entry->bit_count) - 1));
+            consumed += even_entry->bit_count;
+            odd = odd_entry->base + ((uint32_t)(window >> consumed) & ((1U << odd_entry->bit_count) - 1));
+            consumed += odd_entry->bit_count;
+            i += 2;
+        }
+        if (i + 1 == count && consumed + code->table_log <= 64) {
+            const TansDecodeEntry* entry = &code->decode[even];
+            symbols[i++] = entry->symbol;
+            consumed += entry->bit_count;
+        }
+        
+        // Bits before the start read as zero; catch states built from them
+        if (consumed > position) {
+            return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+        }
+        position -= consumed;
+    }
+    
+    stream->byte_pos = position / 8;
+    stream->bit_pos = position % 8;
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// BitStreamReader / BitStreamWriter
+// ---------------------------------------------------------------------------
+
+static BitStreamResult writer_write(void* target, uint64_t value, uint8_t bit_count) {
+    return bit_stream_writer_write_bits_msb((BitStreamWriter*)target, value, bit_count);
+}
+
+BitStreamResult bit_stream_writer_write_tans_table(BitStreamWriter* writer, const TansCode* code) {
+    return write_table(code, writer_write, writer);
+}
+
+BitStreamResult bit_stream_writer_write_tans(BitStreamWriter* writer, const TansCode* code, const uint8_t* symbols, size_t count) {
+    return write_payload(code, symbols, count, writer_write, writer);
+}
+
+BitStreamResult bit_stream_reader_read_tans_table(BitStreamReader* reader, TansCode** code) {
+    BitStreamResult result = bit_stream_reader_read_bits_msb(reader, TANS_LOG_BITS);
+    if (!result.success) {
+        return result;
+    }
+    uint8_t table_log = (uint8_t)result.value.u64;
+    result = bit_stream_reader_read_bits_msb(reader, TANS_COUNT_BITS);
+    if (!result.success) {
+        return result;
+    }
+    size_t symbol_count = result.value.u64;
+    if (table_log < TANS_MIN_TABLE_LOG || table_log > TANS_MAX_TABLE_LOG || symbol_count > TANS_MAX_SYMBOLS) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    uint16_t counts[TANS_MAX_SYMBOLS] = {0};
+    uint32_t remaining = 1U << table_log;
+    for (size_t s = 0; s < symbol_count && remaining > 0; s++) {
+        result = bit_stream_reader_read_bits_msb(reader, (uint8_t)bit_stream_bit_width64(remaining));
+        if (!result.success) {
+            return result;
+        }
+        if (result.value.u64 > remaining) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        counts[s] = (uint16_t)result.value.u64;
+        remaining -= counts[s];
+    }
+    
+    BitStreamErrorCode error = code_from_counts(table_log, counts, symbol_count, code);
+    if (error != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(error);
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_tans(BitStreamReader* reader, const TansCode* code, uint8_t* symbols, size_t count) {
+    // Step back over the zero padding and the marker bit
+    unsigned padding = 0;
+    while (true) {
+        BitStreamResult result = bit_stream_reader_read_bits_backward(reader, 1);
+        if (!result.success) {
+            return result;
+        }
+        if (result.value.u64 == 1) {
+            break;
+        }
+        if (++padding == 8) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+    }
+    
+    uint32_t states[2];
+    for (int k = 0; k < 2; k++) {
+        BitStreamResult result = bit_stream_reader_read_bits_backward(reader, code->table_log);
+        if (!result.success) {
+            return result;
+        }
+        states[k] = (uint32_t)result.value.u64;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        const TansDecodeEntry* entry = &code->decode[states[i & 1]];
+        symbols[i] = entry->symbol;
+        uint32_t bits = 0;
+        if (entry->bit_count > 0) {
+            BitStreamResult result = bit_stream_reader_read_bits_backward(reader, entry->bit_count);
+            if (!result.success) {
+                return result;
+            }
+            bits = (uint32_t)result.value.u64;
+        }
+        states[i & 1] = entry->base + bits;
+    }
+    return create_success_result();
+}
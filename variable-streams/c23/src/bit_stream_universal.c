@@ -0,0 +1,504 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Every code here is a run of z zero bits followed by a value m whose top
+// bit is set. Elias gamma of n is the 0th order Exp-Golomb code of n - 1,
+// the k-th order Exp-Golomb code of n writes m = n + 2^k with k fewer
+// zeros, and Elias delta of n writes the gamma code of n's bit width
+// followed by n without its top bit.
+//
+// Decoding peeks a 64-bit window and takes z from a leading-zero count, so
+// any code of up to 64 bits is cut out of the window in one step. Longer
+// codes (values of 2^32 and above for gamma) take a slower general path.
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with a u64 value
+static BitStreamResult create_u64_result(uint64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.u64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Maps a value to the prefixed form of its k-th order Exp-Golomb code;
+// fails when value + 2^k does not fit in 64 bits
+static inline bool exp_golomb_prefixed(uint64_t value, uint8_t k, uint64_t* prefixed, unsigned* zeros) {
+    uint64_t offset = 1ULL << k;
+    if (value > UINT64_MAX - offset) {
+        return false;
+    }
+    *prefixed = value + offset;
+    *zeros = bit_stream_bit_width64(*prefixed) - 1 - k;
+    return true;
+}
+
+// Decodes a k-th order Exp-Golomb code at the top of a window, returning the
+// code length or 0 when the code does not fit in the window
+static inline unsigned exp_golomb_from_window(uint64_t window, uint8_t k, uint64_t* value) {
+    if (window == 0) {
+        return 0;
+    }
+    unsigned zeros = bit_stream_clz64(window);
+    unsigned length = 2 * zeros + k + 1;
+    if (length > 64) {
+        return 0;
+    }
+    *value = (window >> (64 - length)) - (1ULL << k);
+    return length;
+}
+
+// ---------------------------------------------------------------------------
+// BitStream
+// ---------------------------------------------------------------------------
+
+static BitStreamResult stream_write_prefixed(BitStream* stream, uint64_t prefixed, unsigned zeros) {
+    unsigned width = bit_stream_bit_width64(prefixed);
+    
+    // The zeros are the leading bits of one wider field when it fits
+    if (zeros + width <= 64) {
+        return bit_stream_write_bits(stream, prefixed, (uint8_t)(zeros + width));
+    }
+    
+    BitStreamResult result = bit_stream_write_bits(stream, 0, (uint8_t)zeros);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_write_bits(stream, prefixed, (uint8_t)width);
+}
+
+// Counts and consumes the zero run of a code longer than the window
+static BitStreamErrorCode stream_read_zeros(BitStream* stream, unsigned* zeros) {
+    *zeros = 0;
+    while (true) {
+        uint64_t window = bit_stream_peek_bits(stream, 64).value.u64;
+        unsigned run = (window == 0) ? 64 : bit_stream_clz64(window);
+        if (!bit_stream_skip_bits(stream, run).success) {
+            return BIT_STREAM_ERROR_END_OF_STREAM;
+        }
+        *zeros += run;
+        if (*zeros > 64) {
+            return BIT_STREAM_ERROR_INVALID_VALUE;
+        }
+        if (window != 0) {
+            return BIT_STREAM_ERROR_NONE;
+        }
+    }
+}
+
+static inline BitStreamErrorCode stream_decode_exp_golomb(BitStream* stream, uint8_t k, uint64_t* value) {
+    size_t position = bit_stream_position(stream);
+    size_t available = (stream->byte_pos < stream->buffer_size) ? stream->buffer_size - stream->byte_pos : 0;
+    uint64_t window = bit_stream_window64(stream->buffer + stream->byte_pos, available, stream->bit_pos);
+    
+    unsigned length = exp_golomb_from_window(window, k, value);
+    if (length > 0) {
+        if (length > stream->bit_length - position) {
+            return BIT_STREAM_ERROR_END_OF_STREAM;
+        }
+        position += length;
+        stream->byte_pos = position / 8;
+        stream->bit_pos = position % 8;
+        return BIT_STREAM_ERROR_NONE;
+    }
+    
+    // General path for codes longer than 64 bits
+    unsigned zeros;
+    BitStreamErrorCode code = stream_read_zeros(stream, &zeros);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return code;
+    }
+    unsigned width = zeros + k + 1;
+    if (width > 64) {
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    BitStreamResult result = bit_stream_read_bits(stream, (uint8_t)width);
+    if (!result.success) {
+        return result.error.code;
+    }
+    *value = result.value.u64 - (1ULL << k);
+    return BIT_STREAM_ERROR_NONE;
+}
+
+static inline BitStreamErrorCode stream_decode_elias_delta(BitStream* stream, uint64_t* value) {
+    uint64_t width;
+    BitStreamErrorCode code = stream_decode_exp_golomb(stream, 0, &width);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return code;
+    }
+    
+    // width was coded as gamma(width), i.e. Exp-Golomb of width - 1
+    width += 1;
+    if (width > 64) {
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    if (width == 1) {
+        *value = 1;
+        return BIT_STREAM_ERROR_NONE;
+    }
+    
+    BitStreamResult result = bit_stream_read_bits(stream, (uint8_t)(width - 1));
+    if (!result.success) {
+        return result.error.code;
+    }
+    *value = (1ULL << (width - 1)) | result.value.u64;
+    return BIT_STREAM_ERROR_NONE;
+}
+
+BitStreamResult bit_stream_write_exp_golomb(BitStream* stream, uint64_t value, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    uint64_t prefixed;
+    unsigned zeros;
+    if (!exp_golomb_prefixed(value, k, &prefixed, &zeros)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return stream_write_prefixed(stream, prefixed, zeros);
+}
+
+BitStreamResult bit_stream_read_exp_golomb(BitStream* stream, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    uint64_t value;
+    BitStreamErrorCode code = stream_decode_exp_golomb(stream, k, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_write_elias_gamma(BitStream* stream, uint64_t value) {
+    if (value == 0) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return stream_write_prefixed(stream, value, bit_stream_bit_width64(value) - 1);
+}
+
+BitStreamResult bit_stream_read_elias_gamma(BitStream* stream) {
+    uint64_t value;
+    BitStreamErrorCode code = stream_decode_exp_golomb(stream, 0, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value + 1);
+}
+
+BitStreamResult bit_stream_write_elias_delta(BitStream* stream, uint64_t value) {
+    if (value == 0) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    unsigned width = bit_stream_bit_width64(value);
+    BitStreamResult result = bit_stream_write_elias_gamma(stream, width);
+    if (!result.success || width == 1) {
+        return result;
+    }
+    return bit_stream_write_bits(stream, value, (uint8_t)(width - 1));
+}
+
+BitStreamResult bit_stream_read_elias_delta(BitStream* stream) {
+    uint64_t value;
+    BitStreamErrorCode code = stream_decode_elias_delta(stream, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_write_elias_gamma_batch(BitStream* stream, const uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_write_elias_gamma(stream, values[i]);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_elias_gamma_batch(BitStream* stream, uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = stream_decode_exp_golomb(stream, 0, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+        values[i] += 1;
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_elias_delta_batch(BitStream* stream, const uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_write_elias_delta(stream, values[i]);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_elias_delta_batch(BitStream* stream, uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = stream_decode_elias_delta(stream, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_exp_golomb_batch(BitStream* stream, const uint64_t* values, size_t count, uint8_t k) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_write_exp_golomb(stream, values[i], k);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_exp_golomb_batch(BitStream* stream, uint64_t* values, size_t count, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = stream_decode_exp_golomb(stream, k, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+    }
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// BitStreamReader / BitStreamWriter
+// ---------------------------------------------------------------------------
+
+static BitStreamResult writer_write_prefixed(BitStreamWriter* writer, uint64_t prefixed, unsigned zeros) {
+    unsigned width = bit_stream_bit_width64(prefixed);
+    
+    if (zeros + width <= 64) {
+        return bit_stream_writer_write_bits_msb(writer, prefixed, (uint8_t)(zeros + width));
+    }
+    
+    BitStreamResult result = bit_stream_writer_write_bits_msb(writer, 0, (uint8_t)zeros);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_writer_write_bits_msb(writer, prefixed, (uint8_t)width);
+}
+
+static BitStreamErrorCode reader_decode_exp_golomb(BitStreamReader* reader, uint8_t k, uint64_t* value) {
+    BitStreamResult result = bit_stream_reader_peek_bits_msb(reader, 64);
+    if (!result.success) {
+        return result.error.code;
+    }
+    
+    unsigned length = exp_golomb_from_window(result.value.u64, k, value);
+    if (length > 0) {
+        result = bit_stream_reader_skip_bits(reader, length);
+        return result.success ? BIT_STREAM_ERROR_NONE : result.error.code;
+    }
+    
+    // General path for codes longer than 64 bits
+    unsigned zeros = 0;
+    while (true) {
+        result = bit_stream_reader_peek_bits_msb(reader, 64);
+        if (!result.success) {
+            return result.error.code;
+        }
+        uint64_t window = result.value.u64;
+        unsigned run = (window == 0) ? 64 : bit_stream_clz64(window);
+        result = bit_stream_reader_skip_bits(reader, run);
+        if (!result.success) {
+            return result.error.code;
+        }
+        zeros += run;
+        if (zeros > 64) {
+            return BIT_STREAM_ERROR_INVALID_VALUE;
+        }
+        if (window != 0) {
+            break;
+        }
+    }
+    
+    unsigned width = zeros + k + 1;
+    if (width > 64) {
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    result = bit_stream_reader_read_bits_msb(reader, (uint8_t)width);
+    if (!result.success) {
+        return result.error.code;
+    }
+    *value = result.value.u64 - (1ULL << k);
+    return BIT_STREAM_ERROR_NONE;
+}
+
+static BitStreamErrorCode reader_decode_elias_delta(BitStreamReader* reader, uint64_t* value) {
+    uint64_t width;
+    BitStreamErrorCode code = reader_decode_exp_golomb(reader, 0, &width);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return code;
+    }
+    
+    width += 1;
+    if (width > 64) {
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    if (width == 1) {
+        *value = 1;
+        return BIT_STREAM_ERROR_NONE;
+    }
+    
+    BitStreamResult result = bit_stream_reader_read_bits_msb(reader, (uint8_t)(width - 1));
+    if (!result.success) {
+        return result.error.code;
+    }
+    *value = (1ULL << (width - 1)) | result.value.u64;
+    return BIT_STREAM_ERROR_NONE;
+}
+
+BitStreamResult bit_stream_reader_read_exp_golomb(BitStreamReader* reader, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    uint64_t value;
+    BitStreamErrorCode code = reader_decode_exp_golomb(reader, k, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_reader_read_elias_gamma(BitStreamReader* reader) {
+    uint64_t value;
+    BitStreamErrorCode code = reader_decode_exp_golomb(reader, 0, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value + 1);
+}
+
+BitStreamResult bit_stream_reader_read_elias_delta(BitStreamReader* reader) {
+    uint64_t value;
+    BitStreamErrorCode code = reader_decode_elias_delta(reader, &value);
+    if (code != BIT_STREAM_ERROR_NONE) {
+        return create_error_result(code);
+    }
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_reader_read_elias_gamma_batch(BitStreamReader* reader, uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = reader_decode_exp_golomb(reader, 0, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+        values[i] += 1;
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_elias_delta_batch(BitStreamReader* reader, uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = reader_decode_elias_delta(reader, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_exp_golomb_batch(BitStreamReader* reader, uint64_t* values, size_t count, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    for (size_t i = 0; i < count; i++) {
+        BitStreamErrorCode code = reader_decode_exp_golomb(reader, k, &values[i]);
+        if (code != BIT_STREAM_ERROR_NONE) {
+            return create_error_result(code);
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_exp_golomb(BitStreamWriter* writer, uint64_t value, uint8_t k) {
+    if (k > 63) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT);
+    }
+    uint64_t prefixed;
+    unsigned zeros;
+    if (!exp_golomb_prefixed(value, k, &prefixed, &zeros)) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return writer_write_prefixed(writer, prefixed, zeros);
+}
+
+BitStreamResult bit_stream_writer_write_elias_gamma(BitStreamWriter* writer, uint64_t value) {
+    if (value == 0) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    return writer_write_prefixed(writer, value, bit_stream_bit_width64(value) - 1);
+}
+
+BitStreamResult bit_stream_writer_write_elias_delta(BitStreamWriter* writer, uint64_t value) {
+    if (value == 0) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+    }
+    
+    unsigned width = bit_stream_bit_width64(value);
+    BitStreamResult result = bit_stream_writer_write_elias_gamma(writer, width);
+    if (!result.success || width == 1) {
+        return result;
+    }
+    return bit_stream_writer_write_bits_msb(writer, value & ((1ULL << (width - 1)) - 1), (uint8_t)(width - 1));
+}
+
+BitStreamResult bit_stream_writer_write_elias_gamma_batch(BitStreamWriter* writer, const uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_writer_write_elias_gamma(writer, values[i]);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_elias_delta_batch(BitStreamWriter* writer, const uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_writer_write_elias_delta(writer, values[i]);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_exp_golomb_batch(BitStreamWriter* writer, const uint64_t* values, size_t count, uint8_t k) {
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_writer_write_exp_golomb(writer, values[i], k);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
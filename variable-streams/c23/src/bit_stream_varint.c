@@ -0,0 +1,386 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+#include <pthread.h>
+
+// Byte-aligned variable length integers. LEB128 is the protobuf varint: 7
+// bits per byte, least significant group first, high bit set on every byte
+// but the last. Stream-VByte codes 32-bit values as a run of control bytes,
+// two bits per value holding its byte length minus one, followed by the
+// little-endian value bytes. Keeping lengths apart from the data lets a
+// whole control byte be decoded with one byte shuffle.
+//
+// On a BitStream both codes start at the next byte boundary.
+
+#define STREAM_VBYTE_MAX_VALUE_BYTES 4
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with a u64 value
+static BitStreamResult create_u64_result(uint64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.u64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with an i64 value
+static BitStreamResult create_i64_result(int64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// LEB128
+// ---------------------------------------------------------------------------
+
+size_t leb128_encode_u64(uint64_t value, uint8_t* bytes) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (uint8_t)value;
+    return length;
+}
+
+size_t leb128_decode_u64(const uint8_t* bytes, size_t length, uint64_t* value) {
+    uint64_t result = 0;
+    size_t limit = (length < LEB128_MAX_BYTES) ? length : LEB128_MAX_BYTES;
+    for (size_t i = 0; i < limit; i++) {
+        uint8_t byte = bytes[i];
+        // The tenth byte may only carry the top bit of a 64-bit value
+        if (i == LEB128_MAX_BYTES - 1 && byte > 1) {
+            return 0;
+        }
+        result |= (uint64_t)(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Decodes a varint of up to 8 bytes from a little-endian word by gathering
+// the 7-bit groups pairwise; returns 0 for longer varints
+static inline size_t leb128_decode_word(uint64_t word, uint64_t* value) {
+    uint64_t stops = ~word & 0x8080808080808080ULL;
+    if (stops == 0) {
+        return 0;
+    }
+    unsigned length = bit_stream_ctz64(stops) / 8 + 1;
+    uint64_t groups = word & 0x7F7F7F7F7F7F7F7FULL;
+    if (length < 8) {
+        groups &= (1ULL << (8 * length)) - 1;
+    }
+    groups = ((groups & 0x7F007F007F007F00ULL) >> 1) | (groups & 0x007F007F007F007FULL);
+    groups = ((groups & 0x3FFF00003FFF0000ULL) >> 2) | (groups & 0x00003FFF00003FFFULL);
+    groups = ((groups & 0x0FFFFFFF00000000ULL) >> 4) | (groups & 0x000000000FFFFFFFULL);
+    *value = groups;
+    return length;
+}
+
+// Tells a varint cut off by the end of the data from a malformed one
+static BitStreamErrorCode leb128_error(const uint8_t* bytes, size_t length) {
+    if (length >= LEB128_MAX_BYTES) {
+        return BIT_STREAM_ERROR_INVALID_VALUE;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if ((bytes[i] & 0x80) == 0) {
+            return BIT_STREAM_ERROR_INVALID_VALUE;
+        }
+    }
+    return BIT_STREAM_ERROR_END_OF_STREAM;
+}
+
+// Whole bytes between the (aligned) position and the end of the stream
+static inline size_t aligned_bytes_left(const BitStream* stream) {
+    size_t end = stream->bit_length / 8;
+    return (stream->byte_pos < end) ? end - stream->byte_pos : 0;
+}
+
+BitStreamResult bit_stream_write_varint(BitStream* stream, uint64_t value) {
+    uint8_t bytes[LEB128_MAX_BYTES];
+    size_t length = leb128_encode_u64(value, bytes);
+    BitStreamResult result = bit_stream_align(stream);
+    if (!result.success) {
+        return result;
+    }
+    return bit_stream_write_bytes(stream, bytes, length);
+}
+
+BitStreamResult bit_stream_read_varint(BitStream* stream) {
+    BitStreamResult result = bit_stream_align_read(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    const uint8_t* bytes = stream->buffer + stream->byte_pos;
+    size_t available = aligned_bytes_left(stream);
+    uint64_t value;
+    size_t length = leb128_decode_u64(bytes, available, &value);
+    if (length == 0) {
+        return create_error_result(leb128_error(bytes, available));
+    }
+    
+    stream->byte_pos += length;
+    return create_u64_result(value);
+}
+
+BitStreamResult bit_stream_write_varint_signed(BitStream* stream, int64_t value) {
+    return bit_stream_write_varint(stream, zigzag_encode_i64(value));
+}
+
+BitStreamResult bit_stream_read_varint_signed(BitStream* stream) {
+    BitStreamResult result = bit_stream_read_varint(stream);
+    if (!result.success) {
+        return result;
+    }
+    return create_i64_result(zigzag_decode_u64(result.value.u64));
+}
+
+BitStreamResult bit_stream_write_varint_batch(BitStream* stream, const uint64_t* values, size_t count) {
+    BitStreamResult result = bit_stream_align(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    // Encode in chunks on the stack and append each chunk in one copy
+    uint8_t bytes[64 * LEB128_MAX_BYTES];
+    size_t i = 0;
+    while (i < count) {
+        size_t length = 0;
+        size_t chunk_end = (count - i < 64) ? count : i + 64;
+        for (; i < chunk_end; i++) {
+            length += leb128_encode_u64(values[i], bytes + length);
+        }
+        result = bit_stream_write_bytes(stream, bytes, length);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_read_varint_batch(BitStream* stream, uint64_t* values, size_t count) {
+    BitStreamResult result = bit_stream_align_read(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    const uint8_t* bytes = stream->buffer + stream->byte_pos;
+    size_t available = aligned_bytes_left(stream);
+    size_t offset = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        size_t length = 0;
+        if (available - offset >= 8) {
+            length = leb128_decode_word(bit_stream_load_le64(bytes + offset), &values[i]);
+        }
+        if (length == 0) {
+            length = leb128_decode_u64(bytes + offset, available - offset, &values[i]);
+            if (length == 0) {
+                stream->byte_pos += offset;
+                return create_error_result(leb128_error(bytes + offset, available - offset));
+            }
+        }
+        offset += length;
+    }
+    
+    stream->byte_pos += offset;
+    return create_success_result();
+}
+
+// ---------------------------------------------------------------------------
+// Stream-VByte
+// ---------------------------------------------------------------------------
+
+// Data length and byte shuffle of each control byte, built once
+static uint8_t stream_vbyte_lengths[256];
+static uint8_t stream_vbyte_shuffles[256][16];
+static pthread_once_t stream_vbyte_tables_once = PTHREAD_ONCE_INIT;
+
+static void stream_vbyte_build_tables(void) {
+    for (unsigned control = 0; control < 256; control++) {
+        uint8_t source = 0;
+        for (unsigned j = 0; j < 4; j++) {
+            unsigned length = ((control >> (2 * j)) & 3) + 1;
+            for (unsigned b = 0; b < 4; b++) {
+                // 0x80 makes the shuffle write a zero byte
+                stream_vbyte_shuffles[control][4 * j + b] = (b < length) ? source++ : 0x80;
+            }
+        }
+        stream_vbyte_lengths[control] = source;
+    }
+}
+
+static inline unsigned stream_vbyte_code(uint32_t value) {
+    return (value > 0xFF) + (value > 0xFFFF) + (value > 0xFFFFFF);
+}
+
+size_t stream_vbyte_max_encoded_length(size_t count) {
+    return (count + 3) / 4 + count * STREAM_VBYTE_MAX_VALUE_BYTES;
+}
+
+size_t stream_vbyte_encode(const uint32_t* values, size_t count, uint8_t* bytes) {
+    size_t control_length = (count + 3) / 4;
+    uint8_t* control = bytes;
+    uint8_t* data = bytes + control_length;
+    
+    memset(control, 0, control_length);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value = values[i];
+        unsigned code = stream_vbyte_code(value);
+        control[i / 4] |= (uint8_t)(code << (2 * (i % 4)));
+        for (unsigned b = 0; b <= code; b++) {
+            *data++ = (uint8_t)(value >> (8 * b));
+        }
+    }
+    return (size_t)(data - bytes);
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+// Each kernel decodes whole control bytes while a full 16-byte load stays
+// within the readable data, and returns the number of control bytes done
+BIT_STREAM_TARGET_SSSE3
+static size_t stream_vbyte_decode_ssse3(const uint8_t* control, size_t groups, const uint8_t** data,
+                                        const uint8_t* data_end, uint32_t* values) {
+    const uint8_t* in = *data;
+    size_t g = 0;
+    for (; g < groups && data_end - in >= 16; g++) {
+        uint8_t code = control[g];
+        __m128i bytes = _mm_loadu_si128((const __m128i*)in);
+        __m128i shuffle = _mm_loadu_si128((const __m128i*)stream_vbyte_shuffles[code]);
+        _mm_storeu_si128((__m128i*)(values + 4 * g), _mm_shuffle_epi8(bytes, shuffle));
+        in += stream_vbyte_lengths[code];
+    }
+    *data = in;
+    return g;
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t stream_vbyte_decode_avx2(const uint8_t* control, size_t groups, const uint8_t** data,
+                                       const uint8_t* data_end, uint32_t* values) {
+    // Two control bytes per step, one in each 128-bit lane
+    const uint8_t* in = *data;
+    size_t g = 0;
+    for (; g + 2 <= groups && data_end - in >= 32; g += 2) {
+        uint8_t code_low = control[g];
+        uint8_t code_high = control[g + 1];
+        const uint8_t* in_high = in + stream_vbyte_lengths[code_low];
+        __m256i bytes = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)in)),
+            _mm_loadu_si128((const __m128i*)in_high), 1);
+        __m256i shuffle = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)stream_vbyte_shuffles[code_low])),
+            _mm_loadu_si128((const __m128i*)stream_vbyte_shuffles[code_high]), 1);
+        _mm256_storeu_si256((__m256i*)(values + 4 * g), _mm256_shuffle_epi8(bytes, shuffle));
+        in = in_high + stream_vbyte_lengths[code_high];
+    }
+    *data = in;
+    return g;
+}
+#endif
+
+size_t stream_vbyte_decode(const uint8_t* bytes, size_t length, uint32_t* values, size_t count) {
+    pthread_once(&stream_vbyte_tables_once, stream_vbyte_build_tables);
+    
+    size_t control_length = (count + 3) / 4;
+    if (length < control_length) {
+        return 0;
+    }
+    const uint8_t* control = bytes;
+    
+    // Check the data length up front so the loops below need no checks
+    size_t full_groups = count / 4;
+    size_t data_length = 0;
+    for (size_t g = 0; g < full_groups; g++) {
+        data_length += stream_vbyte_lengths[control[g]];
+    }
+    for (size_t i = full_groups * 4; i < count; i++) {
+        data_length += ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+    }
+    if (data_length > length - control_length) {
+        return 0;
+    }
+    
+    const uint8_t* data = bytes + control_length;
+    size_t g = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    // Loads may run past the data into the rest of the readable bytes
+    const uint8_t* readable_end = bytes + length;
+    if (bit_stream_cpu_has_avx2()) {
+        g = stream_vbyte_decode_avx2(control, full_groups, &data, readable_end, values);
+    }
+    if (bit_stream_cpu_has_ssse3()) {
+        g += stream_vbyte_decode_ssse3(control + g, full_groups - g, &data, readable_end, values + 4 * g);
+    }
+#endif
+    
+    for (size_t i = g * 4; i < count; i++) {
+        unsigned value_length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+        for (unsigned b = 0; b < value_length; b++) {
+            value |= (uint32_t)data[b] << (8 * b);
+        }
+        values[i] = value;
+        data += value_length;
+    }
+    
+    return control_length + data_length;
+}
+
+BitStreamResult bit_stream_write_stream_vbyte(BitStream* stream, const uint32_t* values, size_t count) {
+    uint8_t* bytes = (uint8_t*)malloc(stream_vbyte_max_encoded_length(count) + 1);
+    if (bytes == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_IO);
+    }
+    size_t length = stream_vbyte_encode(values, count, bytes);
+    
+    BitStreamResult result = bit_stream_align(stream);
+    if (result.success) {
+        result = bit_stream_write_bytes(stream, bytes, length);
+    }
+    free(bytes);
+    return result;
+}
+
+BitStreamResult bit_stream_read_stream_vbyte(BitStream* stream, uint32_t* values, size_t count) {
+    BitStreamResult result = bit_stream_align_read(stream);
+    if (!result.success) {
+        return result;
+    }
+    
+    size_t length = stream_vbyte_decode(stream->buffer + stream->byte_pos, aligned_bytes_left(stream), values, count);
+    if (length == 0 && count > 0) {
+        return create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+    }
+    
+    stream->byte_pos += length;
+    return create_success_result();
+}
@@ -0,0 +1,167 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+#include "bit_stream_simd.h"
+
+// Minimum bit widths of columns. Unsigned columns need the width of the OR
+// of their values. Signed columns are folded first, with each negative
+// value replaced by its complement, so the OR holds the width of the
+// largest magnitude and one more bit is added for the sign; this gives the
+// same width as a min/max pass with a single reduction. Every width is at
+// least 1, so it can be handed straight to the batch functions.
+
+static inline uint8_t at_least_one(unsigned width) {
+    return (uint8_t)((width > 0) ? width : 1);
+}
+
+// Complement of negative values, the value itself otherwise
+static inline uint64_t fold_i64(int64_t value) {
+    return (uint64_t)value ^ -((uint64_t)value >> 63);
+}
+
+static inline uint32_t fold_i32(int32_t value) {
+    return (uint32_t)value ^ -((uint32_t)value >> 31);
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+static inline uint64_t or_lanes64(const uint64_t lanes[4]) {
+    return lanes[0] | lanes[1] | lanes[2] | lanes[3];
+}
+
+// ORs values (folded when is_signed) four lanes at a time; returns the
+// number of values done
+BIT_STREAM_TARGET_AVX2
+static size_t or_reduce_u64_avx2(const uint64_t* values, size_t count, bool is_signed, uint64_t* bits) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i folded = zero;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(values + i));
+        if (is_signed) {
+            value = _mm256_xor_si256(value, _mm256_cmpgt_epi64(zero, value));
+        }
+        folded = _mm256_or_si256(folded, value);
+    }
+    
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, folded);
+    *bits |= or_lanes64(lanes);
+    return i;
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t or_reduce_u32_avx2(const uint32_t* values, size_t count, bool is_signed, uint32_t* bits) {
+    __m256i folded = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(values + i));
+        if (is_signed) {
+            value = _mm256_xor_si256(value, _mm256_srai_epi32(value, 31));
+        }
+        folded = _mm256_or_si256(folded, value);
+    }
+    
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, folded);
+    uint64_t pairs = or_lanes64(lanes);
+    *bits |= (uint32_t)pairs | (uint32_t)(pairs >> 32);
+    return i;
+}
+
+// Each register holds two 128-bit values as [high, low, high, low]; for
+// signed values the sign of each high half is copied over its low half
+BIT_STREAM_TARGET_AVX2
+static size_t or_reduce_u128_avx2(const UInt128* values, size_t count, bool is_signed, uint64_t* high, uint64_t* low) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i folded = zero;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(values + i));
+        if (is_signed) {
+            __m256i sign = _mm256_shuffle_epi32(_mm256_cmpgt_epi64(zero, value), _MM_SHUFFLE(1, 0, 1, 0));
+            value = _mm256_xor_si256(value, sign);
+        }
+        folded = _mm256_or_si256(folded, value);
+    }
+    
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, folded);
+    *high |= lanes[0] | lanes[2];
+    *low |= lanes[1] | lanes[3];
+    return i;
+}
+#endif
+
+static uint64_t or_reduce_u64(const uint64_t* values, size_t count, bool is_signed) {
+    uint64_t bits = 0;
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = or_reduce_u64_avx2(values, count, is_signed, &bits);
+    }
+#endif
+    for (; i < count; i++) {
+        bits |= is_signed ? fold_i64((int64_t)values[i]) : values[i];
+    }
+    return bits;
+}
+
+static uint32_t or_reduce_u32(const uint32_t* values, size_t count, bool is_signed) {
+    uint32_t bits = 0;
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = or_reduce_u32_avx2(values, count, is_signed, &bits);
+    }
+#endif
+    for (; i < count; i++) {
+        bits |= is_signed ? fold_i32((int32_t)values[i]) : values[i];
+    }
+    return bits;
+}
+
+// Width of the 128-bit value high:low; 0 for 0
+static inline unsigned bit_width128(uint64_t high, uint64_t low) {
+    return (high != 0) ? 64 + bit_stream_bit_width64(high) : bit_stream_bit_width64(low);
+}
+
+static unsigned or_reduce_width_u128(const UInt128* values, size_t count, bool is_signed) {
+    uint64_t high = 0;
+    uint64_t low = 0;
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = or_reduce_u128_avx2(values, count, is_signed, &high, &low);
+    }
+#endif
+    for (; i < count; i++) {
+        uint64_t sign = is_signed ? -(values[i].high >> 63) : 0;
+        high |= values[i].high ^ sign;
+        low |= values[i].low ^ sign;
+    }
+    return bit_width128(high, low);
+}
+
+uint8_t bit_width_required_u64(const uint64_t* values, size_t count) {
+    return at_least_one(bit_stream_bit_width64(or_reduce_u64(values, count, false)));
+}
+
+uint8_t bit_width_required_u32(const uint32_t* values, size_t count) {
+    return at_least_one(bit_stream_bit_width64(or_reduce_u32(values, count, false)));
+}
+
+uint8_t bit_width_required_u128(const UInt128* values, size_t count) {
+    return at_least_one(or_reduce_width_u128(values, count, false));
+}
+
+uint8_t bit_width_required_i64(const int64_t* values, size_t count) {
+    return (uint8_t)(bit_stream_bit_width64(or_reduce_u64((const uint64_t*)values, count, true)) + 1);
+}
+
+uint8_t bit_width_required_i32(const int32_t* values, size_t count) {
+    return (uint8_t)(bit_stream_bit_width64(or_reduce_u32((const uint32_t*)values, count, true)) + 1);
+}
+
+uint8_t bit_width_required_i128(const Int128* values, size_t count) {
+    // Int128 shares the layout of UInt128, with the sign in the high half
+    return (uint8_t)(or_reduce_width_u128((const UInt128*)values, count, true) + 1);
+}
@@ -1,4 +1,8 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "bit_stream.h"
+#include <time.h>
+#include <unistd.h>
 
 // Helper function to create a BitStreamResult with an error
 static BitStreamResult create_error_result(BitStreamErrorCode code, int io_errno) {
@@ -9,6 +13,16 @@ static BitStreamResult create_error_result(BitStreamErrorCode code, int io_errno
     return result;
 }
 
+// Helper function to create a BitStreamResult with a reserved field handle
+static BitStreamResult create_field_result(BitStreamField field) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.field = field;
+    return result;
+}
+
 // Helper function to create a BitStreamResult with success status
 static BitStreamResult create_success_result(void) {
     BitStreamResult result;
@@ -18,6 +32,45 @@ static BitStreamResult create_success_result(void) {
     return result;
 }
 
+// Current time on a monotonic clock in milliseconds
+static uint64_t monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+// Pushes everything handed to the file through to stable storage
+static BitStreamResult sync_file(BitStreamWriter* writer) {
+    if (fflush(writer->file) != 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, errno);
+    }
+    if (fdatasync(fileno(writer->file)) != 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, errno);
+    }
+    
+    writer->unsynced_bytes = 0;
+    writer->last_sync_ms = monotonic_ms();
+    
+    return create_success_result();
+}
+
+// Syncs when the periodic policy's byte or time threshold has been reached
+static BitStreamResult apply_durability(BitStreamWriter* writer) {
+    if (writer->durability.mode != BIT_STREAM_DURABILITY_PERIODIC || writer->unsynced_bytes == 0) {
+        return create_success_result();
+    }
+    
+    bool bytes_due = writer->durability.sync_bytes > 0 &&
+                     writer->unsynced_bytes >= writer->durability.sync_bytes;
+    bool time_due = writer->durability.sync_interval_ms > 0 &&
+                    monotonic_ms() - writer->last_sync_ms >= writer->durability.sync_interval_ms;
+    
+    if (bytes_due || time_due) {
+        return sync_file(writer);
+    }
+    return create_success_result();
+}
+
 BitStreamWriter* bit_stream_writer_new(FILE* file) {
     return bit_stream_writer_with_capacity(file, 4096);
 }
@@ -35,49 +88,134 @@ BitStreamWriter* bit_stream_writer_with_capacity(FILE* file, size_t capacity) {
         return NULL;
     }
     
+    // The buffer is deliberately left uninitialised: every byte is stored
+    // outright the first time bits land in it, so zeroing it here would only
+    // be overwritten again.
     writer->buffer_capacity = capacity;
     writer->byte_pos = 0;
     writer->bit_pos = 0;
-    
-    // Initialize buffer to zeros
-    memset(writer->buffer, 0, capacity);
+    writer->bytes_flushed = 0;
+    writer->open_fields = NULL;
+    writer->open_field_count = 0;
+    writer->open_field_capacity = 0;
+    writer->patched_fields = NULL;
+    writer->patched_count = 0;
+    writer->patched_capacity = 0;
+    writer->patched_dropped = 0;
+    writer->durability.mode = BIT_STREAM_DURABILITY_NONE;
+    writer->durability.sync_bytes = 0;
+    writer->durability.sync_interval_ms = 0;
+    writer->durability.group = NULL;
+    writer->unsynced_bytes = 0;
+    writer->last_sync_ms = monotonic_ms();
     
     return writer;
 }
 
 void bit_stream_writer_free(BitStreamWriter* writer) {
     if (writer != NULL) {
+        free(writer->open_fields);
+        free(writer->patched_fields);
         free(writer->buffer);
         free(writer);
     }
 }
 
-// Flushes the internal buffer to the underlying file
+// Flushes the internal buffer to the underlying file. Bytes from the first
+// byte of the earliest open field onwards are held back so the field can
+// still be patched; if that leaves the buffer full it is grown instead.
 static BitStreamResult flush_buffer(BitStreamWriter* writer) {
-    if (writer->byte_pos > 0) {
+    size_t flushable = writer->byte_pos;
+    for (size_t i = 0; i < writer->open_field_count; i++) {
+        size_t field_byte = writer->open_fields[i] / 8 - writer->bytes_flushed;
+        if (field_byte < flushable) {
+            flushable = field_byte;
+        }
+    }
+    
+    if (flushable > 0) {
         // Write the buffer to the underlying file
-        size_t bytes_written = fwrite(writer->buffer, 1, writer->byte_pos, writer->file);
+        size_t bytes_written = fwrite(writer->buffer, 1, flushable, writer->file);
         
-        if (bytes_written != writer->byte_pos) {
+        if (bytes_written != flushable) {
             return create_error_result(BIT_STREAM_ERROR_IO, errno);
         }
         
+        // Move any held back bytes, including a partial byte, to the front
+        size_t kept = writer->byte_pos - flushable + (writer->bit_pos > 0 ? 1 : 0);
+        if (kept > 0) {
+            memmove(writer->buffer, writer->buffer + flushable, kept);
+        }
+        
         // Reset buffer position
-        writer->byte_pos = 0;
+        writer->bytes_flushed += flushable;
+        writer->unsynced_bytes += flushable;
+        writer->byte_pos -= flushable;
         
-        // Clear the first byte for the next write
-        writer->buffer[0] = 0;
+        // Patches whose bytes have all started to reach the file can no
+        // longer be undone; the log is dropped once every entry is such
+        bool all_flushed = true;
+        for (size_t i = 0; i < writer->patched_count; i++) {
+            all_flushed = all_flushed && writer->patched_fields[i].bit_position / 8 < writer->bytes_flushed;
+        }
+        if (all_flushed) {
+            writer->patched_dropped += writer->patched_count;
+            writer->patched_count = 0;
+        }
+    }
+    
+    // The periodic thresholds are checked here, whenever the writer hands
+    // data to the file, rather than on every write or by a timer
+    BitStreamResult sync_result = apply_durability(writer);
+    if (!sync_result.success) {
+        return sync_result;
+    }
+    
+    if (writer->byte_pos >= writer->buffer_capacity) {
+        size_t new_capacity = writer->buffer_capacity * 2;
+        uint8_t* new_buffer = (uint8_t*)realloc(writer->buffer, new_capacity);
+        if (new_buffer == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO, ENOMEM);
+        }
+        writer->buffer = new_buffer;
+        writer->buffer_capacity = new_capacity;
     }
     
     return create_success_result();
 }
 
+// Writes bits over already buffered data at an absolute bit position, using
+// the same chunk layout as bit_stream_writer_write_bits
+static void overwrite_bits(BitStreamWriter* writer, size_t bit_position, uint64_t value, uint8_t bit_count) {
+    size_t offset = bit_position - writer->bytes_flushed * 8;
+    size_t byte_pos = offset / 8;
+    uint8_t bit_pos = offset % 8;
+    uint8_t bits_written = 0;
+    
+    while (bits_written < bit_count) {
+        uint8_t bits_left_in_byte = 8 - bit_pos;
+        uint8_t bits_to_write = (bit_count - bits_written < bits_left_in_byte) ?
+                                (bit_count - bits_written) : bits_left_in_byte;
+        uint8_t chunk = (uint8_t)((value >> bits_written) & ((1U << bits_to_write) - 1));
+        uint8_t byte_shift = bits_left_in_byte - bits_to_write;
+        uint8_t byte_mask = (uint8_t)(((1U << bits_to_write) - 1) << byte_shift);
+        
+        writer->buffer[byte_pos] = (uint8_t)((writer->buffer[byte_pos] & ~byte_mask) | (chunk << byte_shift));
+        
+        bits_written += bits_to_write;
+        bit_pos = 0;
+        byte_pos++;
+    }
+}
+
 BitStreamResult bit_stream_writer_write_bits(BitStreamWriter* writer, uint64_t value, uint8_t bit_count) {
     if (bit_count == 0 || bit_count > 64) {
         return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
     }
     
-    uint8_t bits_written = 0;
+    if (bit_count < 64) {
+        value &= (1ULL << bit_count) - 1;
+    }
     
     // Ensure the buffer has enough space
     if (writer->byte_pos >= writer->buffer_capacity) {
@@ -87,6 +225,47 @@ BitStreamResult bit_stream_writer_write_bits(BitStreamWriter* writer, uint64_t v
         }
     }
     
+    // Fast path: every byte the value touches is already inside the buffer,
+    // so the value is laid down as a head, whole body bytes and a tail.
+    // A byte with bit_pos == 0 holds nothing yet and is stored outright;
+    // only a partially filled head byte is merged into.
+    size_t span = (writer->bit_pos + bit_count + 7) / 8;
+    if (writer->byte_pos + span <= writer->buffer_capacity) {
+        uint8_t* dst = writer->buffer + writer->byte_pos;
+        uint8_t bits_left_in_byte = 8 - writer->bit_pos;
+        uint8_t head_bits = (bit_count < bits_left_in_byte) ? bit_count : bits_left_in_byte;
+        
+        // Head: the least significant bits fill the current byte
+        uint8_t head = (uint8_t)((value & ((1U << head_bits) - 1)) << (bits_left_in_byte - head_bits));
+        *dst = (writer->bit_pos == 0) ? head : (uint8_t)(*dst | head);
+        value >>= head_bits;
+        
+        // Body: whole bytes, least significant first
+        uint8_t remaining = bit_count - head_bits;
+        while (remaining >= 8) {
+            *++dst = (uint8_t)value;
+            value >>= 8;
+            remaining -= 8;
+        }
+        
+        // Tail: the most significant bits start the next byte
+        if (remaining > 0) {
+            *++dst = (uint8_t)(value << (8 - remaining));
+        }
+        
+        size_t bit_offset = writer->bit_pos + bit_count;
+        writer->byte_pos += bit_offset / 8;
+        writer->bit_pos = bit_offset % 8;
+        
+        // If the buffer is full, flush it
+        if (writer->byte_pos >= writer->buffer_capacity) {
+            return flush_buffer(writer);
+        }
+        return create_success_result();
+    }
+    
+    uint8_t bits_written = 0;
+    
     while (bits_written < bit_count) {
         uint8_t bits_left_in_byte = 8 - writer->bit_pos;
         uint8_t bits_to_write = (bit_count - bits_written < bits_left_in_byte) ? 
@@ -97,11 +276,14 @@ BitStreamResult bit_stream_writer_write_bits(BitStreamWriter* writer, uint64_t v
         uint64_t mask = ((1ULL << bits_to_write) - 1) << shift;
         uint8_t extracted_bits = (uint8_t)((value & mask) >> shift);
         
-        // Write the bits to the current byte
+        // Write the bits to the current byte, storing rather than merging
+        // when the byte is fresh
         uint8_t byte_shift = bits_left_in_byte - bits_to_write;
-        uint8_t byte_mask = ~(((1U << bits_to_write) - 1) << byte_shift);
-        writer->buffer[writer->byte_pos] &= byte_mask;
-        writer->buffer[writer->byte_pos] |= extracted_bits << byte_shift;
+        if (writer->bit_pos == 0) {
+            writer->buffer[writer->byte_pos] = extracted_bits << byte_shift;
+        } else {
+            writer->buffer[writer->byte_pos] |= extracted_bits << byte_shift;
+        }
         
         // Update position
         bits_written += bits_to_write;
@@ -116,9 +298,6 @@ BitStreamResult bit_stream_writer_write_bits(BitStreamWriter* writer, uint64_t v
                 if (!flush_result.success) {
                     return flush_result;
                 }
-            } else {
-                // Initialize the next byte to zero
-                writer->buffer[writer->byte_pos] = 0;
             }
         }
     }
@@ -173,5 +352,253 @@ BitStreamResult bit_stream_writer_flush(BitStreamWriter* writer) {
         return create_error_result(BIT_STREAM_ERROR_IO, errno);
     }
     
+    return create_success_result();
+}
+
+// Makes room for at least required open fields
+static BitStreamResult grow_open_fields(BitStreamWriter* writer, size_t required) {
+    if (required <= writer->open_field_capacity) {
+        return create_success_result();
+    }
+    size_t new_capacity = (writer->open_field_capacity == 0) ? 4 : writer->open_field_capacity * 2;
+    new_capacity = (required > new_capacity) ? required : new_capacity;
+    size_t* new_fields = (size_t*)realloc(writer->open_fields, new_capacity * sizeof(size_t));
+    if (new_fields == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_IO, ENOMEM);
+    }
+    writer->open_fields = new_fields;
+    writer->open_field_capacity = new_capacity;
+    return create_success_result();
+}
+
+BitStreamCheckpoint bit_stream_writer_checkpoint(const BitStreamWriter* writer) {
+    BitStreamCheckpoint checkpoint;
+    checkpoint.bit_position = (writer->bytes_flushed + writer->byte_pos) * 8 + writer->bit_pos;
+    checkpoint.bit_length = checkpoint.bit_position;
+    checkpoint.overwrite_count = writer->patched_dropped + writer->patched_count;
+    return checkpoint;
+}
+
+BitStreamResult bit_stream_writer_rollback(BitStreamWriter* writer, BitStreamCheckpoint checkpoint) {
+    size_t buffer_start = writer->bytes_flushed * 8;
+    size_t current_position = (writer->bytes_flushed + writer->byte_pos) * 8 + writer->bit_pos;
+    
+    // Bits that already reached the file cannot be taken back
+    if (checkpoint.bit_position < buffer_start || checkpoint.bit_position > current_position ||
+        checkpoint.overwrite_count < writer->patched_dropped ||
+        checkpoint.overwrite_count > writer->patched_dropped + writer->patched_count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_CHECKPOINT, 0);
+    }
+    
+    // Fields patched since the checkpoint that were reserved before it go
+    // back to their reserved zeros and are open again, so every one of them
+    // must still be wholly buffered
+    size_t kept_patches = checkpoint.overwrite_count - writer->patched_dropped;
+    size_t reopened = 0;
+    for (size_t i = kept_patches; i < writer->patched_count; i++) {
+        size_t field_position = writer->patched_fields[i].bit_position;
+        if (field_position < checkpoint.bit_position) {
+            if (field_position < buffer_start) {
+                return create_error_result(BIT_STREAM_ERROR_INVALID_CHECKPOINT, 0);
+            }
+            reopened++;
+        }
+    }
+    BitStreamResult grow_result = grow_open_fields(writer, writer->open_field_count + reopened);
+    if (!grow_result.success) {
+        return grow_result;
+    }
+    for (size_t i = writer->patched_count; i > kept_patches; i--) {
+        BitStreamField field = writer->patched_fields[i - 1];
+        if (field.bit_position < checkpoint.bit_position) {
+            overwrite_bits(writer, field.bit_position, 0, field.bit_count);
+            writer->open_fields[writer->open_field_count++] = field.bit_position;
+        }
+    }
+    writer->patched_count = kept_patches;
+    
+    size_t buffered_bits = checkpoint.bit_position - buffer_start;
+    writer->byte_pos = buffered_bits / 8;
+    writer->bit_pos = buffered_bits % 8;
+    
+    // Later writes merge into a partially filled byte, so clear the bits
+    // that were written after the checkpoint
+    if (writer->bit_pos > 0) {
+        writer->buffer[writer->byte_pos] &= (uint8_t)(0xFF << (8 - writer->bit_pos));
+    }
+    
+    // Fields reserved after the checkpoint no longer exist
+    size_t kept_fields = 0;
+    for (size_t i = 0; i < writer->open_field_count; i++) {
+        if (writer->open_fields[i] < checkpoint.bit_position) {
+            writer->open_fields[kept_fields++] = writer->open_fields[i];
+        }
+    }
+    writer->open_field_count = kept_fields;
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_reserve_field(BitStreamWriter* writer, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    BitStreamResult grow_result = grow_open_fields(writer, writer->open_field_count + 1);
+    if (!grow_result.success) {
+        return grow_result;
+    }
+    
+    BitStreamField field;
+    field.bit_position = (writer->bytes_flushed + writer->byte_pos) * 8 + writer->bit_pos;
+    field.bit_count = bit_count;
+    
+    // Register the field before writing so no flush can pass it
+    writer->open_fields[writer->open_field_count++] = field.bit_position;
+    
+    // Reserved bits read as zero until the field is patched
+    BitStreamResult result = bit_stream_writer_write_bits(writer, 0, bit_count);
+    if (!result.success) {
+        writer->open_field_count--;
+        return result;
+    }
+    
+    return create_field_result(field);
+}
+
+BitStreamResult bit_stream_writer_patch_field(BitStreamWriter* writer, BitStreamField field, uint64_t value) {
+    if (field.bit_count == 0 || field.bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    // Only fields that are still open are guaranteed to be in the buffer
+    size_t index = writer->open_field_count;
+    for (size_t i = 0; i < writer->open_field_count; i++) {
+        if (writer->open_fields[i] == field.bit_position) {
+            index = i;
+            break;
+        }
+    }
+    if (index == writer->open_field_count) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_FIELD, 0);
+    }
+    
+    // Log the patch so that a rollback can undo it
+    if (writer->patched_count == writer->patched_capacity) {
+        size_t new_capacity = (writer->patched_capacity == 0) ? 4 : writer->patched_capacity * 2;
+        BitStreamField* new_patched = (BitStreamField*)realloc(writer->patched_fields, new_capacity * sizeof(BitStreamField));
+        if (new_patched == NULL) {
+            return create_error_result(BIT_STREAM_ERROR_IO, ENOMEM);
+        }
+        writer->patched_fields = new_patched;
+        writer->patched_capacity = new_capacity;
+    }
+    writer->patched_fields[writer->patched_count++] = field;
+    
+    overwrite_bits(writer, field.bit_position, value, field.bit_count);
+    
+    // Close the field so flushing may pass it
+    writer->open_fields[index] = writer->open_fields[--writer->open_field_count];
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_set_durability(BitStreamWriter* writer, BitStreamDurability durability) {
+    // Group commit needs the committer the writers share
+    if (durability.mode == BIT_STREAM_DURABILITY_GROUP_COMMIT && durability.group == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE, 0);
+    }
+    
+    writer->durability = durability;
+    writer->last_sync_ms = monotonic_ms();
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_commit(BitStreamWriter* writer) {
+    if (writer->durability.mode == BIT_STREAM_DURABILITY_GROUP_COMMIT && writer->durability.group == NULL) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE, 0);
+    }
+    
+    // Hand every whole byte up to the earliest open field to the kernel; a
+    // partially filled byte stays buffered for the bits that follow
+    BitStreamResult result = flush_buffer(writer);
+    if (!result.success) {
+        return result;
+    }
+    if (fflush(writer->file) != 0) {
+        return create_error_result(BIT_STREAM_ERROR_IO, errno);
+    }
+    
+    switch (writer->durability.mode) {
+        case BIT_STREAM_DURABILITY_PERIODIC:
+            if (writer->unsynced_bytes > 0) {
+                return sync_file(writer);
+            }
+            return create_success_result();
+        case BIT_STREAM_DURABILITY_GROUP_COMMIT:
+            // One fdatasync is shared with every other pending commit
+            result = bit_stream_group_commit_sync(writer->durability.group);
+            if (result.success) {
+                writer->unsynced_bytes = 0;
+                writer->last_sync_ms = monotonic_ms();
+            }
+            return result;
+        case BIT_STREAM_DURABILITY_NONE:
+        default:
+            return create_success_result();
+    }
+}
+
+BitStreamResult bit_stream_writer_write_signed_bits(BitStreamWriter* writer, int64_t value, uint8_t bit_count) {
+    // The low bit_count bits of the two's complement form are the field
+    return bit_stream_writer_write_bits(writer, (uint64_t)value, bit_count);
+}
+
+BitStreamResult bit_stream_writer_write_signed_bits_i128(BitStreamWriter* writer, Int128 value, uint8_t bit_count) {
+    return bit_stream_writer_write_bits_u128(writer, uint128_from_parts((uint64_t)value.high, value.low), bit_count);
+}
+
+BitStreamResult bit_stream_writer_write_bits_batch(BitStreamWriter* writer, const uint64_t* values, size_t count, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        BitStreamResult result = bit_stream_writer_write_bits(writer, values[i], bit_count);
+        if (!result.success) {
+            return result;
+        }
+    }
+    
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_signed_bits_batch(BitStreamWriter* writer, const int64_t* values, size_t count, uint8_t bit_count) {
+    // Two's complement values are written as their low bit_count bits
+    return bit_stream_writer_write_bits_batch(writer, (const uint64_t*)values, count, bit_count);
+}
+
+BitStreamResult bit_stream_writer_write_bits_msb(BitStreamWriter* writer, uint64_t value, uint8_t bit_count) {
+    if (bit_count == 0 || bit_count > 64) {
+        return create_error_result(BIT_STREAM_ERROR_INVALID_BIT_COUNT, 0);
+    }
+    
+    // A chunk that fits in the current byte is laid down in natural order,
+    // so writing the most significant chunk first at each byte boundary
+    // gives the same bytes as bit_stream_write_bits
+    uint8_t remaining = bit_count;
+    while (remaining > 0) {
+        uint8_t bits_left_in_byte = 8 - writer->bit_pos;
+        uint8_t chunk_bits = (remaining < bits_left_in_byte) ? remaining : bits_left_in_byte;
+        remaining -= chunk_bits;
+        
+        uint64_t chunk = (value >> remaining) & ((1ULL << chunk_bits) - 1);
+        BitStreamResult result = bit_stream_writer_write_bits(writer, chunk, chunk_bits);
+        if (!result.success) {
+            return result;
+        }
+    }
+    
     return create_success_result();
 }
\ No newline at end of file
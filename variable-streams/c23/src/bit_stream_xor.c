@@ -0,0 +1,342 @@
+#include "bit_stream.h"
+#include "bit_stream_bits.h"
+
+// Gorilla-style XOR compression for float and double columns. The first
+// value is written as its raw bits; every following value is XORed with its
+// predecessor and the XOR is written as
+//
+//   0                                  same value as before
+//   10 | meaningful bits               the set bits lie within the window
+//                                      of leading and trailing zeros used
+//                                      last, which is reused
+//   11 | leading | length - 1 |        a new window; leading and length - 1
+//        meaningful bits               take 6 bits for doubles, 5 for floats
+//
+// Slowly changing samples share sign, exponent and high mantissa bits, so
+// their XORs are short runs of meaningful bits in the middle of the word.
+// Floats are handled as the low 32 bits of the same 64-bit code path.
+
+// Control prefixes
+#define XOR_CONTROL_SAME 0x0
+#define XOR_CONTROL_REUSE 0x2
+#define XOR_CONTROL_NEW 0x3
+
+// Leading and trailing zeros before any window exists; no XOR fits in it
+#define XOR_NO_WINDOW 64
+
+typedef struct {
+    uint64_t previous;
+    unsigned leading;
+    unsigned trailing;
+} XorState;
+
+// Helper function to create a BitStreamResult with an error
+static BitStreamResult create_error_result(BitStreamErrorCode code) {
+    BitStreamResult result;
+    result.success = false;
+    result.error.code = code;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+// Raw bits of element i of a float (width 32) or double (width 64) array
+static inline uint64_t load_value(const void* values, size_t i, unsigned width) {
+    if (width == 64) {
+        uint64_t bits;
+        memcpy(&bits, (const uint8_t*)values + i * sizeof(bits), sizeof(bits));
+        return bits;
+    }
+    uint32_t bits;
+    memcpy(&bits, (const uint8_t*)values + i * sizeof(bits), sizeof(bits));
+    return bits;
+}
+
+static inline void store_value(void* values, size_t i, unsigned width, uint64_t bits) {
+    if (width == 64) {
+        memcpy((uint8_t*)values + i * sizeof(bits), &bits, sizeof(bits));
+        return;
+    }
+    uint32_t narrow = (uint32_t)bits;
+    memcpy((uint8_t*)values + i * sizeof(narrow), &narrow, sizeof(narrow));
+}
+
+// Bits of the leading and length fields for a value width of 64 or 32
+static inline unsigned field_bits(unsigned width) {
+    return (width == 64) ? 6 : 5;
+}
+
+static inline void xor_state_init(XorState* state, uint64_t first) {
+    state->previous = first;
+    state->leading = XOR_NO_WINDOW;
+    state->trailing = XOR_NO_WINDOW;
+}
+
+// Encodes value against the state as a header of up to 14 bits, returned
+// with its length in header_bits, followed by meaningful_bits bits
+static uint64_t xor_encode(XorState* state, uint64_t value, unsigned width, unsigned* header_bits, uint64_t* meaningful, unsigned* meaningful_bits) {
+    uint64_t difference = value ^ state->previous;
+    state->previous = value;
+    if (difference == 0) {
+        *header_bits = 1;
+        *meaningful_bits = 0;
+        return XOR_CONTROL_SAME;
+    }
+    
+    unsigned leading = bit_stream_clz64(difference) - (64 - width);
+    unsigned trailing = bit_stream_ctz64(difference);
+    if (leading >= state->leading && trailing >= state->trailing) {
+        *meaningful_bits = width - state->leading - state->trailing;
+        *meaningful = difference >> state->trailing;
+        *header_bits = 2;
+        return XOR_CONTROL_REUSE;
+    }
+    
+    unsigned length = width - leading - trailing;
+    unsigned bits = field_bits(width);
+    state->leading = leading;
+    state->trailing = trailing;
+    *meaningful_bits = length;
+    *meaningful = difference >> trailing;
+    *header_bits = 2 + 2 * bits;
+    return ((uint64_t)XOR_CONTROL_NEW << (2 * bits)) | ((uint64_t)leading << bits) | (length - 1);
+}
+
+// Parses the header at the top of window; returns its length, or 0 when the
+// window it describes is missing or does not fit in the value width. The
+// three controls are told apart with masks rather than branches, as repeats
+// and changes tend to alternate unpredictably.
+static inline unsigned xor_decode_header(XorState* state, uint64_t window, unsigned width, unsigned* meaningful_bits) {
+    unsigned changed = (unsigned)(window >> 63);
+    unsigned fresh = changed & (unsigned)(window >> 62);
+    unsigned bits = field_bits(width);
+    unsigned leading = (unsigned)(window >> (62 - bits)) & ((1U << bits) - 1);
+    unsigned length = ((unsigned)(window >> (62 - 2 * bits)) & ((1U << bits) - 1)) + 1;
+    if ((fresh & (leading + length > width)) | (changed & !fresh & (state->leading == XOR_NO_WINDOW))) {
+        return 0;
+    }
+    
+    unsigned fresh_mask = 0U - fresh;
+    state->leading = (leading & fresh_mask) | (state->leading & ~fresh_mask);
+    state->trailing = ((width - leading - length) & fresh_mask) | (state->trailing & ~fresh_mask);
+    *meaningful_bits = (width - state->leading - state->trailing) & (0U - changed);
+    return 1 + changed + fresh * 2 * bits;
+}
+
+// Applies the meaningful bits of a decoded XOR and returns the new value;
+// without a window yet, meaningful is 0 and the shift is kept in range
+static inline uint64_t xor_apply(XorState* state, uint64_t meaningful) {
+    state->previous ^= meaningful << (state->trailing & 63);
+    return state->previous;
+}
+
+// Encodes value into one field of up to 64 bits when header and meaningful
+// bits fit together; otherwise returns the header alone and leaves the
+// meaningful bits in *tail
+static uint64_t xor_encode_field(XorState* state, uint64_t value, unsigned width, unsigned* field_length, uint64_t* tail, unsigned* tail_bits) {
+    unsigned header_bits;
+    uint64_t meaningful = 0;
+    unsigned meaningful_bits;
+    uint64_t header = xor_encode(state, value, width, &header_bits, &meaningful, &meaningful_bits);
+    if (header_bits + meaningful_bits <= 64) {
+        *field_length = header_bits + meaningful_bits;
+        *tail_bits = 0;
+        return (meaningful_bits > 0) ? (header << meaningful_bits) | meaningful : header;
+    }
+    *field_length = header_bits;
+    *tail = meaningful;
+    *tail_bits = meaningful_bits;
+    return header;
+}
+
+// ---------------------------------------------------------------------------
+// BitStream
+// ---------------------------------------------------------------------------
+
+static BitStreamResult write_xor(BitStream* stream, const void* values, size_t count, unsigned width) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    XorState state;
+    xor_state_init(&state, load_value(values, 0, width));
+    BitStreamResult result = bit_stream_write_bits(stream, state.previous, (uint8_t)width);
+    for (size_t i = 1; i < count && result.success; i++) {
+        unsigned field_length;
+        uint64_t tail;
+        unsigned tail_bits;
+        uint64_t field = xor_encode_field(&state, load_value(values, i, width), width, &field_length, &tail, &tail_bits);
+        result = bit_stream_write_bits(stream, field, (uint8_t)field_length);
+        if (result.success && tail_bits > 0) {
+            result = bit_stream_write_bits(stream, tail, (uint8_t)tail_bits);
+        }
+    }
+    return result;
+}
+
+// The 64 bits at position; whole words are loaded without bounds checks
+// while 9 bytes remain
+static inline uint64_t window_at(const uint8_t* buffer, size_t buffer_size, size_t position) {
+    size_t byte = position / 8;
+    unsigned offset = position % 8;
+    if (byte + 9 <= buffer_size) {
+        const uint8_t* bytes = buffer + byte;
+        return (bit_stream_load_be64(bytes) << offset) | ((uint64_t)bytes[8] >> (8 - offset));
+    }
+    size_t available = (byte < buffer_size) ? buffer_size - byte : 0;
+    return bit_stream_window64(buffer + byte, available, (uint8_t)offset);
+}
+
+static BitStreamResult read_xor(BitStream* stream, void* values, size_t count, unsigned width) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    BitStreamResult result = bit_stream_read_bits(stream, (uint8_t)width);
+    if (!result.success) {
+        return result;
+    }
+    XorState state;
+    xor_state_init(&state, result.value.u64);
+    store_value(values, 0, width, state.previous);
+    
+    // Each value is parsed from a 64-bit window, with a second window for
+    // meaningful bits reaching past it. The stream fields are kept in locals
+    // as the stores to values could otherwise alias them.
+    const uint8_t* buffer = stream->buffer;
+    size_t buffer_size = stream->buffer_size;
+    size_t bit_length = stream->bit_length;
+    size_t position = bit_stream_position(stream);
+    for (size_t i = 1; i < count; i++) {
+        uint64_t window = window_at(buffer, buffer_size, position);
+        unsigned meaningful_bits;
+        unsigned header_bits = xor_decode_header(&state, window, width, &meaningful_bits);
+        if (header_bits == 0) {
+            result = create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+            break;
+        }
+        
+        uint64_t rest = window << header_bits;
+        if (header_bits + meaningful_bits > 64) {
+            rest = window_at(buffer, buffer_size, position + header_bits);
+        }
+        
+        // Masked rather than branched on, like the header; a length of 64
+        // needs no shift and a length of 0 keeps nothing
+        uint64_t meaningful = (rest >> ((64 - meaningful_bits) & 63)) & (0 - (uint64_t)(meaningful_bits != 0));
+        
+        // Bits past the end read as zero; catch values decoded from them
+        if (header_bits + meaningful_bits > bit_length - position) {
+            result = create_error_result(BIT_STREAM_ERROR_END_OF_STREAM);
+            break;
+        }
+        position += header_bits + meaningful_bits;
+        store_value(values, i, width, xor_apply(&state, meaningful));
+    }
+    
+    stream->byte_pos = position / 8;
+    stream->bit_pos = position % 8;
+    return result;
+}
+
+BitStreamResult bit_stream_write_xor_double(BitStream* stream, const double* values, size_t count) {
+    return write_xor(stream, values, count, 64);
+}
+
+BitStreamResult bit_stream_read_xor_double(BitStream* stream, double* values, size_t count) {
+    return read_xor(stream, values, count, 64);
+}
+
+BitStreamResult bit_stream_write_xor_float(BitStream* stream, const float* values, size_t count) {
+    return write_xor(stream, values, count, 32);
+}
+
+BitStreamResult bit_stream_read_xor_float(BitStream* stream, float* values, size_t count) {
+    return read_xor(stream, values, count, 32);
+}
+
+// ---------------------------------------------------------------------------
+// BitStreamReader / BitStreamWriter
+// ---------------------------------------------------------------------------
+
+static BitStreamResult writer_write_xor(BitStreamWriter* writer, const void* values, size_t count, unsigned width) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    XorState state;
+    xor_state_init(&state, load_value(values, 0, width));
+    BitStreamResult result = bit_stream_writer_write_bits_msb(writer, state.previous, (uint8_t)width);
+    for (size_t i = 1; i < count && result.success; i++) {
+        unsigned field_length;
+        uint64_t tail;
+        unsigned tail_bits;
+        uint64_t field = xor_encode_field(&state, load_value(values, i, width), width, &field_length, &tail, &tail_bits);
+        result = bit_stream_writer_write_bits_msb(writer, field, (uint8_t)field_length);
+        if (result.success && tail_bits > 0) {
+            result = bit_stream_writer_write_bits_msb(writer, tail, (uint8_t)tail_bits);
+        }
+    }
+    return result;
+}
+
+static BitStreamResult reader_read_xor(BitStreamReader* reader, void* values, size_t count, unsigned width) {
+    if (count == 0) {
+        return create_success_result();
+    }
+    
+    BitStreamResult result = bit_stream_reader_read_bits_msb(reader, (uint8_t)width);
+    if (!result.success) {
+        return result;
+    }
+    XorState state;
+    xor_state_init(&state, result.value.u64);
+    store_value(values, 0, width, state.previous);
+    
+    // The header is peeked whole, then only its own bits are skipped
+    uint8_t peek_bits = (uint8_t)(2 + 2 * field_bits(width));
+    for (size_t i = 1; i < count; i++) {
+        result = bit_stream_reader_peek_bits_msb(reader, peek_bits);
+        if (!result.success) {
+            return result;
+        }
+        unsigned meaningful_bits;
+        unsigned header_bits = xor_decode_header(&state, result.value.u64 << (64 - peek_bits), width, &meaningful_bits);
+        if (header_bits == 0) {
+            return create_error_result(BIT_STREAM_ERROR_INVALID_VALUE);
+        }
+        result = bit_stream_reader_read_bits_msb(reader, (uint8_t)header_bits);
+        if (result.success && meaningful_bits > 0) {
+            result = bit_stream_reader_read_bits_msb(reader, (uint8_t)meaningful_bits);
+        }
+        if (!result.success) {
+            return result;
+        }
+        store_value(values, i, width, xor_apply(&state, (meaningful_bits > 0) ? result.value.u64 : 0));
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_xor_double(BitStreamWriter* writer, const double* values, size_t count) {
+    return writer_write_xor(writer, values, count, 64);
+}
+
+BitStreamResult bit_stream_writer_write_xor_float(BitStreamWriter* writer, const float* values, size_t count) {
+    return writer_write_xor(writer, values, count, 32);
+}
+
+BitStreamResult bit_stream_reader_read_xor_double(BitStreamReader* reader, double* values, size_t count) {
+    return reader_read_xor(reader, values, count, 64);
+}
+
+BitStreamResult bit_stream_reader_read_xor_float(BitStreamReader* reader, float* values, size_t count) {
+    return reader_read_xor(reader, values, count, 32);
+}
@@ -0,0 +1,206 @@
+#include "bit_stream.h"
+#include "bit_stream_simd.h"
+
+// Number of values encoded on the stack per batch chunk
+#define ZIGZAG_CHUNK_SIZE 256
+
+// Helper function to create a BitStreamResult with an i64 value
+static BitStreamResult create_i64_result(int64_t value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i64 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with an i128 value
+static BitStreamResult create_i128_result(Int128 value) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    result.value.i128 = value;
+    return result;
+}
+
+// Helper function to create a BitStreamResult with success status
+static BitStreamResult create_success_result(void) {
+    BitStreamResult result;
+    result.success = true;
+    result.error.code = BIT_STREAM_ERROR_NONE;
+    result.error.io_errno = 0;
+    return result;
+}
+
+uint64_t zigzag_encode_i64(int64_t value) {
+    // The sign mask is all ones for negative values and zero otherwise
+    uint64_t sign = -((uint64_t)value >> 63);
+    return ((uint64_t)value << 1) ^ sign;
+}
+
+int64_t zigzag_decode_u64(uint64_t value) {
+    return (int64_t)((value >> 1) ^ -(value & 1));
+}
+
+UInt128 zigzag_encode_i128(Int128 value) {
+    uint64_t sign = -((uint64_t)value.high >> 63);
+    UInt128 result;
+    result.high = (((uint64_t)value.high << 1) | (value.low >> 63)) ^ sign;
+    result.low = (value.low << 1) ^ sign;
+    return result;
+}
+
+Int128 zigzag_decode_u128(UInt128 value) {
+    uint64_t sign = -(value.low & 1);
+    Int128 result;
+    result.high = (int64_t)((value.high >> 1) ^ sign);
+    result.low = ((value.low >> 1) | (value.high << 63)) ^ sign;
+    return result;
+}
+
+#ifdef BIT_STREAM_X86_SIMD
+BIT_STREAM_TARGET_AVX2
+static size_t zigzag_encode_avx2(const int64_t* values, uint64_t* encoded, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256i sign = _mm256_cmpgt_epi64(zero, value);
+        __m256i result = _mm256_xor_si256(_mm256_slli_epi64(value, 1), sign);
+        _mm256_storeu_si256((__m256i*)(encoded + i), result);
+    }
+    return i;
+}
+
+BIT_STREAM_TARGET_AVX2
+static size_t zigzag_decode_avx2(const uint64_t* encoded, int64_t* values, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi64x(1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(encoded + i));
+        __m256i sign = _mm256_sub_epi64(zero, _mm256_and_si256(value, one));
+        __m256i result = _mm256_xor_si256(_mm256_srli_epi64(value, 1), sign);
+        _mm256_storeu_si256((__m256i*)(values + i), result);
+    }
+    return i;
+}
+#endif
+
+void zigzag_encode_i64_batch(const int64_t* values, uint64_t* encoded, size_t count) {
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = zigzag_encode_avx2(values, encoded, count);
+    }
+#endif
+    for (; i < count; i++) {
+        encoded[i] = zigzag_encode_i64(values[i]);
+    }
+}
+
+void zigzag_decode_u64_batch(const uint64_t* encoded, int64_t* values, size_t count) {
+    size_t i = 0;
+#ifdef BIT_STREAM_X86_SIMD
+    if (bit_stream_cpu_has_avx2()) {
+        i = zigzag_decode_avx2(encoded, values, count);
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] = zigzag_decode_u64(encoded[i]);
+    }
+}
+
+BitStreamResult bit_stream_read_zigzag(BitStream* stream, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits(stream, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i64_result(zigzag_decode_u64(result.value.u64));
+}
+
+BitStreamResult bit_stream_read_zigzag_i128(BitStream* stream, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_read_bits_u128(stream, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i128_result(zigzag_decode_u128(result.value.u128));
+}
+
+BitStreamResult bit_stream_write_zigzag(BitStream* stream, int64_t value, uint8_t bit_count) {
+    return bit_stream_write_bits(stream, zigzag_encode_i64(value), bit_count);
+}
+
+BitStreamResult bit_stream_write_zigzag_i128(BitStream* stream, Int128 value, uint8_t bit_count) {
+    return bit_stream_write_bits_u128(stream, zigzag_encode_i128(value), bit_count);
+}
+
+BitStreamResult bit_stream_read_zigzag_batch(BitStream* stream, int64_t* values, size_t count, uint8_t bit_count) {
+    // Decode in place once the raw fields are unpacked
+    BitStreamResult result = bit_stream_read_bits_batch(stream, (uint64_t*)values, count, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    zigzag_decode_u64_batch((const uint64_t*)values, values, count);
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_write_zigzag_batch(BitStream* stream, const int64_t* values, size_t count, uint8_t bit_count) {
+    uint64_t encoded[ZIGZAG_CHUNK_SIZE];
+    for (size_t i = 0; i < count; i += ZIGZAG_CHUNK_SIZE) {
+        size_t chunk = (count - i < ZIGZAG_CHUNK_SIZE) ? count - i : ZIGZAG_CHUNK_SIZE;
+        zigzag_encode_i64_batch(values + i, encoded, chunk);
+        BitStreamResult result = bit_stream_write_bits_batch(stream, encoded, chunk, bit_count);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_reader_read_zigzag(BitStreamReader* reader, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_read_bits(reader, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i64_result(zigzag_decode_u64(result.value.u64));
+}
+
+BitStreamResult bit_stream_reader_read_zigzag_i128(BitStreamReader* reader, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_read_bits_u128(reader, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    return create_i128_result(zigzag_decode_u128(result.value.u128));
+}
+
+BitStreamResult bit_stream_reader_read_zigzag_batch(BitStreamReader* reader, int64_t* values, size_t count, uint8_t bit_count) {
+    BitStreamResult result = bit_stream_reader_read_bits_batch(reader, (uint64_t*)values, count, bit_count);
+    if (!result.success) {
+        return result;
+    }
+    zigzag_decode_u64_batch((const uint64_t*)values, values, count);
+    return create_success_result();
+}
+
+BitStreamResult bit_stream_writer_write_zigzag(BitStreamWriter* writer, int64_t value, uint8_t bit_count) {
+    return bit_stream_writer_write_bits(writer, zigzag_encode_i64(value), bit_count);
+}
+
+BitStreamResult bit_stream_writer_write_zigzag_i128(BitStreamWriter* writer, Int128 value, uint8_t bit_count) {
+    return bit_stream_writer_write_bits_u128(writer, zigzag_encode_i128(value), bit_count);
+}
+
+BitStreamResult bit_stream_writer_write_zigzag_batch(BitStreamWriter* writer, const int64_t* values, size_t count, uint8_t bit_count) {
+    uint64_t encoded[ZIGZAG_CHUNK_SIZE];
+    for (size_t i = 0; i < count; i += ZIGZAG_CHUNK_SIZE) {
+        size_t chunk = (count - i < ZIGZAG_CHUNK_SIZE) ? count - i : ZIGZAG_CHUNK_SIZE;
+        zigzag_encode_i64_batch(values + i, encoded, chunk);
+        BitStreamResult result = bit_stream_writer_write_bits_batch(writer, encoded, chunk, bit_count);
+        if (!result.success) {
+            return result;
+        }
+    }
+    return create_success_result();
+}
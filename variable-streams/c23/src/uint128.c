@@ -130,4 +130,26 @@ int uint128_compare(UInt128 a, UInt128 b) {
     } else {
         return 0;
     }
+}
+
+// Interprets the low bit_count bits of value as two's complement. Flipping
+// the sign bit and subtracting it back borrows through every higher bit when
+// the sign bit was set, which extends the sign without a branch.
+int64_t int64_sign_extend(uint64_t value, uint8_t bit_count) {
+    uint64_t sign_bit = 1ULL << (bit_count - 1);
+    uint64_t mask = (sign_bit << 1) - 1;  // Wraps to all ones for 64 bits
+    return (int64_t)(((value & mask) ^ sign_bit) - sign_bit);
+}
+
+Int128 int128_sign_extend(UInt128 value, uint8_t bit_count) {
+    Int128 result;
+    if (bit_count <= 64) {
+        int64_t low = int64_sign_extend(value.low, bit_count);
+        result.low = (uint64_t)low;
+        result.high = -(int64_t)((uint64_t)low >> 63);
+    } else {
+        result.low = value.low;
+        result.high = int64_sign_extend(value.high, bit_count - 64);
+    }
+    return result;
 }
\ No newline at end of file
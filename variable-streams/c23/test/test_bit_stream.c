@@ -1,5 +1,6 @@
 #include "bit_stream.h"
 #include "unity.h"
+#include "test_helpers.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -285,6 +286,398 @@ void test_bit_stream_reset_and_eof(void) {
     bit_stream_free(stream);
 }
 
+// Reference MSB-first packer that sets one bit at a time into a zeroed buffer
+static void reference_pack_bits(uint8_t* buffer, size_t* position, uint64_t value, uint8_t bit_count) {
+    for (int bit = bit_count - 1; bit >= 0; bit--) {
+        if ((value >> bit) & 1) {
+            buffer[*position / 8] |= (uint8_t)(0x80 >> (*position % 8));
+        }
+        (*position)++;
+    }
+}
+
+void test_bit_stream_write_bits_matches_reference(void) {
+    // Test that the store-once write path produces the same bytes as a
+    // bit-at-a-time packer for every width and alignment
+    BitStream* stream = bit_stream_new();
+    uint8_t expected[8192];
+    memset(expected, 0, sizeof(expected));
+    size_t position = 0;
+    
+    uint64_t seed = TEST_RANDOM_SEED;
+    for (int i = 0; i < 1000; i++) {
+        test_next_random(&seed);
+        uint8_t bit_count = (uint8_t)(seed % 64) + 1;
+        uint64_t value = seed * 0xD1B54A32D192ED03ULL;
+        if (bit_count < 64) {
+            value &= (1ULL << bit_count) - 1;
+        }
+        
+        BitStreamResult result = bit_stream_write_bits(stream, value, bit_count);
+        TEST_ASSERT_TRUE(result.success);
+        reference_pack_bits(expected, &position, value, bit_count);
+    }
+    
+    TEST_ASSERT_EQUAL_size_t(position, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_size_t((position + 7) / 8, stream->buffer_size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, stream->buffer, stream->buffer_size);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_overwrite_preserves_surrounding_bits(void) {
+    // Test that overwriting inside existing data leaves neighbouring bits alone
+    uint8_t bytes[] = {0xFF, 0xFF, 0xFF, 0xFF};
+    BitStream* stream = bit_stream_from_bytes(bytes, sizeof(bytes));
+    BitStreamResult result;
+    
+    // Clear 3 bits inside the first byte
+    result = bit_stream_set_position(stream, 2);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_bits(stream, 0, 3);
+    TEST_ASSERT_TRUE(result.success);
+    
+    // Clear 13 bits straddling the second and third bytes
+    result = bit_stream_set_position(stream, 13);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_bits(stream, 0, 13);
+    TEST_ASSERT_TRUE(result.success);
+    
+    TEST_ASSERT_EQUAL_size_t(32, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_UINT8(0xC7, stream->buffer[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xF8, stream->buffer[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x00, stream->buffer[2]);
+    TEST_ASSERT_EQUAL_UINT8(0x3F, stream->buffer[3]);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_checkpoint_rollback(void) {
+    // Test that rolling back discards a partially encoded record
+    BitStream* stream = bit_stream_new();
+    BitStreamResult result;
+    
+    result = bit_stream_write_bits(stream, 0b101, 3);
+    TEST_ASSERT_TRUE(result.success);
+    
+    BitStreamCheckpoint checkpoint = bit_stream_checkpoint(stream);
+    
+    // Start a record that fails half way through
+    result = bit_stream_write_bits(stream, 0x1F, 5);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_bits(stream, 0xFFFFFFFFFFFFFFFF, 64);
+    TEST_ASSERT_TRUE(result.success);
+    
+    result = bit_stream_rollback(stream, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_position(stream));
+    TEST_ASSERT_EQUAL_size_t(1, stream->buffer_size);
+    TEST_ASSERT_EQUAL_UINT8(0xA0, stream->buffer[0]);
+    
+    // Encode a replacement record
+    result = bit_stream_write_bits(stream, 0b10, 2);
+    TEST_ASSERT_TRUE(result.success);
+    
+    size_t length;
+    uint8_t* bytes = bit_stream_into_bytes(stream, &length);
+    TEST_ASSERT_EQUAL_size_t(1, length);
+    TEST_ASSERT_EQUAL_UINT8(0xB0, bytes[0]);
+    free(bytes);
+    
+    // A checkpoint beyond the current length is rejected
+    result = bit_stream_rollback(stream, checkpoint);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_CHECKPOINT, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reserve_and_patch_field(void) {
+    // Test single-pass length-prefixed framing
+    BitStream* stream = bit_stream_new();
+    BitStreamResult result;
+    
+    result = bit_stream_write_bits(stream, 0b11, 2);
+    TEST_ASSERT_TRUE(result.success);
+    
+    result = bit_stream_reserve_field(stream, 12);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamField length_field = result.value.field;
+    TEST_ASSERT_EQUAL_size_t(2, length_field.bit_position);
+    TEST_ASSERT_EQUAL_UINT8(12, length_field.bit_count);
+    
+    // Variable sized payload
+    size_t payload_start = bit_stream_position(stream);
+    for (int i = 0; i < 5; i++) {
+        result = bit_stream_write_bits(stream, (uint64_t)i, 7);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    size_t payload_bits = bit_stream_position(stream) - payload_start;
+    
+    result = bit_stream_patch_field(stream, length_field, payload_bits);
+    TEST_ASSERT_TRUE(result.success);
+    
+    // Patching leaves the write position where it was
+    TEST_ASSERT_EQUAL_size_t(payload_start + payload_bits, bit_stream_position(stream));
+    
+    bit_stream_reset(stream);
+    result = bit_stream_read_bits(stream, 2);
+    TEST_ASSERT_EQUAL_UINT64(0b11, result.value.u64);
+    result = bit_stream_read_bits(stream, 12);
+    TEST_ASSERT_EQUAL_UINT64(35, result.value.u64);
+    for (int i = 0; i < 5; i++) {
+        result = bit_stream_read_bits(stream, 7);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64((uint64_t)i, result.value.u64);
+    }
+    
+    // A field that was rolled back can no longer be patched
+    BitStreamCheckpoint checkpoint = bit_stream_checkpoint(stream);
+    result = bit_stream_reserve_field(stream, 8);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamField dropped_field = result.value.field;
+    result = bit_stream_rollback(stream, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_patch_field(stream, dropped_field, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_FIELD, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_rollback_restores_overwrites(void) {
+    // Test that a rollback undoes patches and in-place writes made since the
+    // checkpoint, but not those made before it
+    BitStream* stream = bit_stream_new();
+    BitStreamResult result;
+    
+    result = bit_stream_reserve_field(stream, 8);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamField field = result.value.field;
+    result = bit_stream_write_bits(stream, 0x11, 8);
+    TEST_ASSERT_TRUE(result.success);
+    
+    BitStreamCheckpoint checkpoint = bit_stream_checkpoint(stream);
+    result = bit_stream_patch_field(stream, field, 0xAB);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_rollback(stream, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT8(0x00, stream->buffer[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x11, stream->buffer[1]);
+    
+    // An unaligned overwrite that runs past the end of the stream
+    result = bit_stream_set_position(stream, 4);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_bits(stream, 0xEEE, 16);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_set_position(stream, 0);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_bits(stream, 0xEE, 8);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_rollback(stream, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(16, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_size_t(2, stream->buffer_size);
+    TEST_ASSERT_EQUAL_UINT8(0x00, stream->buffer[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x11, stream->buffer[1]);
+    
+    // A patch made before the checkpoint is kept
+    result = bit_stream_patch_field(stream, field, 0x5A);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamCheckpoint later = bit_stream_checkpoint(stream);
+    result = bit_stream_write_bits(stream, 0x3, 2);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_rollback(stream, later);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, stream->buffer[0]);
+    
+    // Rolling back to the earlier checkpoint undoes it, after which the later
+    // checkpoint's overwrites are gone and it is refused
+    result = bit_stream_rollback(stream, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT8(0x00, stream->buffer[0]);
+    result = bit_stream_rollback(stream, later);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_CHECKPOINT, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_undo_log_only_while_checkpoint_live(void) {
+    // Test that in-place overwrites are logged only while a checkpoint is
+    // live, and that releasing the last one, a reset or a rollback to the
+    // empty stream clears the log
+    BitStream* stream = bit_stream_new();
+    BitStreamResult result;
+    
+    result = bit_stream_reserve_field(stream, 8);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamField field = result.value.field;
+    result = bit_stream_write_bits(stream, 0x11, 8);
+    TEST_ASSERT_TRUE(result.success);
+    
+    // No checkpoint: patches are not logged
+    for (uint64_t i = 0; i < 100; i++) {
+        result = bit_stream_patch_field(stream, field, i);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    TEST_ASSERT_EQUAL_size_t(0, stream->undo_count);
+    
+    // Nested checkpoints keep the log until the outer one is released
+    BitStreamCheckpoint outer = bit_stream_checkpoint(stream);
+    result = bit_stream_patch_field(stream, field, 0xAB);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamCheckpoint inner = bit_stream_checkpoint(stream);
+    result = bit_stream_patch_field(stream, field, 0xCD);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(2, stream->undo_count);
+    result = bit_stream_release_checkpoint(stream, inner);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(2, stream->undo_count);
+    result = bit_stream_rollback(stream, outer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT8(99, stream->buffer[0]);
+    result = bit_stream_release_checkpoint(stream, outer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(0, stream->undo_count);
+    result = bit_stream_release_checkpoint(stream, outer);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_CHECKPOINT, result.error.code);
+    
+    // A reset clears the log and ends the checkpoint
+    bit_stream_checkpoint(stream);
+    result = bit_stream_patch_field(stream, field, 0xAB);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(1, stream->undo_count);
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_size_t(0, stream->undo_count);
+    result = bit_stream_patch_field(stream, field, 0xCD);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(0, stream->undo_count);
+    
+    bit_stream_free(stream);
+    
+    // A rollback to the empty stream clears the log
+    stream = bit_stream_new();
+    BitStreamCheckpoint empty = bit_stream_checkpoint(stream);
+    result = bit_stream_write_bits(stream, 0x11, 8);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamCheckpoint written = bit_stream_checkpoint(stream);
+    result = bit_stream_set_position(stream, 0);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_bits(stream, 0x22, 8);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(1, stream->undo_count);
+    result = bit_stream_rollback(stream, empty);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(0, stream->undo_count);
+    TEST_ASSERT_EQUAL_size_t(0, bit_stream_length(stream));
+    result = bit_stream_rollback(stream, written);
+    TEST_ASSERT_FALSE(result.success);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_signed_bits(void) {
+    // Test arbitrary-width two's complement fields
+    BitStream* stream = bit_stream_new();
+    BitStreamResult result;
+    
+    result = bit_stream_write_signed_bits(stream, -1000, 13);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_signed_bits(stream, 4095, 13);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_signed_bits(stream, -4096, 13);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_signed_bits(stream, -1, 1);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_signed_bits(stream, INT64_MIN, 64);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_signed_bits_i128(stream, int128_from_i64(-5), 100);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_signed_bits_i128(stream, int128_from_parts(-(1LL << 35), 0), 100);
+    TEST_ASSERT_TRUE(result.success);
+    
+    bit_stream_reset(stream);
+    
+    result = bit_stream_read_signed_bits(stream, 13);
+    TEST_ASSERT_EQUAL_INT64(-1000, result.value.i64);
+    result = bit_stream_read_signed_bits(stream, 13);
+    TEST_ASSERT_EQUAL_INT64(4095, result.value.i64);
+    result = bit_stream_read_signed_bits(stream, 13);
+    TEST_ASSERT_EQUAL_INT64(-4096, result.value.i64);
+    result = bit_stream_read_signed_bits(stream, 1);
+    TEST_ASSERT_EQUAL_INT64(-1, result.value.i64);
+    result = bit_stream_read_signed_bits(stream, 64);
+    TEST_ASSERT_EQUAL_INT64(INT64_MIN, result.value.i64);
+    
+    result = bit_stream_read_signed_bits_i128(stream, 100);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-1, result.value.i128.high);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-5, result.value.i128.low);
+    
+    result = bit_stream_read_signed_bits_i128(stream, 100);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-(1LL << 35), result.value.i128.high);
+    TEST_ASSERT_EQUAL_UINT64(0, result.value.i128.low);
+    
+    // Sign extension at every width
+    for (uint8_t bit_count = 1; bit_count <= 64; bit_count++) {
+        TEST_ASSERT_EQUAL_INT64(-1, int64_sign_extend(UINT64_MAX, bit_count));
+        TEST_ASSERT_EQUAL_INT64(bit_count == 1 ? -1 : 1, int64_sign_extend(1, bit_count));
+    }
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_bits_batch(void) {
+    // Test that batch reads and writes match the scalar calls at every width
+    // and starting alignment
+    int64_t values[100];
+    int64_t decoded[100];
+    
+    for (uint8_t bit_count = 1; bit_count <= 64; bit_count++) {
+        // Values spread over the whole signed range of the width
+        for (int i = 0; i < 100; i++) {
+            values[i] = int64_sign_extend((uint64_t)i * TEST_RANDOM_SEED, bit_count);
+        }
+        
+        BitStream* batch_stream = bit_stream_new();
+        BitStream* scalar_stream = bit_stream_new();
+        
+        // Start both streams off byte alignment
+        bit_stream_write_bits(batch_stream, 0b101, 3);
+        bit_stream_write_bits(scalar_stream, 0b101, 3);
+        
+        BitStreamResult result = bit_stream_write_signed_bits_batch(batch_stream, values, 100, bit_count);
+        TEST_ASSERT_TRUE(result.success);
+        for (int i = 0; i < 100; i++) {
+            bit_stream_write_signed_bits(scalar_stream, values[i], bit_count);
+        }
+        
+        TEST_ASSERT_EQUAL_size_t(bit_stream_length(scalar_stream), bit_stream_length(batch_stream));
+        TEST_ASSERT_EQUAL_size_t(scalar_stream->buffer_size, batch_stream->buffer_size);
+        TEST_ASSERT_EQUAL_MEMORY(scalar_stream->buffer, batch_stream->buffer, batch_stream->buffer_size);
+        
+        bit_stream_set_position(batch_stream, 3);
+        result = bit_stream_read_signed_bits_batch(batch_stream, decoded, 100, bit_count);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+        TEST_ASSERT_TRUE(bit_stream_is_eof(batch_stream));
+        
+        // Reading past the end consumes nothing
+        bit_stream_set_position(batch_stream, 3);
+        result = bit_stream_read_bits_batch(batch_stream, (uint64_t*)decoded, 101, bit_count);
+        TEST_ASSERT_FALSE(result.success);
+        TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+        TEST_ASSERT_EQUAL_size_t(3, bit_stream_position(batch_stream));
+        
+        bit_stream_free(batch_stream);
+        bit_stream_free(scalar_stream);
+    }
+}
+
 int main(void) {
     UNITY_BEGIN();
     
@@ -299,6 +692,14 @@ int main(void) {
     RUN_TEST(test_bit_stream_error_handling);
     RUN_TEST(test_bit_stream_into_bytes);
     RUN_TEST(test_bit_stream_reset_and_eof);
+    RUN_TEST(test_bit_stream_write_bits_matches_reference);
+    RUN_TEST(test_bit_stream_overwrite_preserves_surrounding_bits);
+    RUN_TEST(test_bit_stream_checkpoint_rollback);
+    RUN_TEST(test_bit_stream_reserve_and_patch_field);
+    RUN_TEST(test_bit_stream_rollback_restores_overwrites);
+    RUN_TEST(test_bit_stream_undo_log_only_while_checkpoint_live);
+    RUN_TEST(test_bit_stream_signed_bits);
+    RUN_TEST(test_bit_stream_bits_batch);
     
     return UNITY_END();
 }
\ No newline at end of file
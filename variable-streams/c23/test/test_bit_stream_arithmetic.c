@@ -0,0 +1,197 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_arithmetic.bin"
+
+#define FLAG_COUNT 20000
+#define CONTEXT_COUNT 4
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+// Fills flags for CONTEXT_COUNT interleaved contexts; context k is set with
+// probability 1/(20 << k), so the first one is 95% zero
+static void fill_flags(bool* flags, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        flags[i] = (state % (20U << (i % CONTEXT_COUNT))) == 0;
+    }
+}
+
+void test_arithmetic_flags(void) {
+    // Test a round trip and that skewed flags cost well under a bit each
+    static bool flags[FLAG_COUNT];
+    fill_flags(flags, FLAG_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x3, 2).success);
+    ArithmeticEncoder* encoder = arithmetic_encoder_new(stream, CONTEXT_COUNT);
+    TEST_ASSERT_NOT_NULL(encoder);
+    for (size_t i = 0; i < FLAG_COUNT; i++) {
+        TEST_ASSERT_TRUE(arithmetic_encoder_encode_flag(encoder, i % CONTEXT_COUNT, flags[i]).success);
+    }
+    TEST_ASSERT_TRUE(arithmetic_encoder_finish(encoder).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    arithmetic_encoder_free(encoder);
+    
+    // About 0.13 bits per flag on average by entropy
+    TEST_ASSERT_TRUE(bit_stream_length(stream) < FLAG_COUNT / 5);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x3, bit_stream_read_bits(stream, 2).value.u64);
+    ArithmeticDecoder* decoder = arithmetic_decoder_new(stream, CONTEXT_COUNT);
+    TEST_ASSERT_NOT_NULL(decoder);
+    for (size_t i = 0; i < FLAG_COUNT; i++) {
+        BitStreamResult result = arithmetic_decoder_decode_flag(decoder, i % CONTEXT_COUNT);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(flags[i], result.value.u64);
+    }
+    TEST_ASSERT_TRUE(arithmetic_decoder_finish(decoder).success);
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    arithmetic_decoder_free(decoder);
+    
+    bit_stream_free(stream);
+}
+
+void test_arithmetic_restart_and_contexts(void) {
+    // Test that a finished coder starts a new payload with adapted contexts
+    // and that unknown contexts are refused
+    BitStream* stream = bit_stream_new();
+    ArithmeticEncoder* encoder = arithmetic_encoder_new(stream, 2);
+    for (int run = 0; run < 2; run++) {
+        for (int i = 0; i < 100; i++) {
+            TEST_ASSERT_TRUE(arithmetic_encoder_encode_flag(encoder, 0, i % 7 == 0).success);
+            TEST_ASSERT_TRUE(arithmetic_encoder_encode_flag(encoder, 1, i % 3 != 0).success);
+        }
+        TEST_ASSERT_TRUE(arithmetic_encoder_finish(encoder).success);
+    }
+    BitStreamResult result = arithmetic_encoder_encode_flag(encoder, 2, true);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    arithmetic_encoder_free(encoder);
+    
+    bit_stream_reset(stream);
+    ArithmeticDecoder* decoder = arithmetic_decoder_new(stream, 2);
+    for (int run = 0; run < 2; run++) {
+        for (int i = 0; i < 100; i++) {
+            TEST_ASSERT_EQUAL_UINT64(i % 7 == 0, arithmetic_decoder_decode_flag(decoder, 0).value.u64);
+            TEST_ASSERT_EQUAL_UINT64(i % 3 != 0, arithmetic_decoder_decode_flag(decoder, 1).value.u64);
+        }
+        TEST_ASSERT_TRUE(arithmetic_decoder_finish(decoder).success);
+    }
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    result = arithmetic_decoder_decode_flag(decoder, 2);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    // Reading on past the payload runs out of stream
+    result = arithmetic_decoder_decode_flag(decoder, 0);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    arithmetic_decoder_free(decoder);
+    
+    bit_stream_free(stream);
+}
+
+void test_arithmetic_empty_group(void) {
+    // Test that a group with no flags between two fields is skipped whole,
+    // so the field after it reads back
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    ArithmeticEncoder* encoder = arithmetic_encoder_new(stream, 1);
+    TEST_ASSERT_NOT_NULL(encoder);
+    TEST_ASSERT_TRUE(arithmetic_encoder_finish(encoder).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0xAB, 8).success);
+    arithmetic_encoder_free(encoder);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    ArithmeticDecoder* decoder = arithmetic_decoder_new(stream, 1);
+    TEST_ASSERT_NOT_NULL(decoder);
+    TEST_ASSERT_TRUE(arithmetic_decoder_finish(decoder).success);
+    BitStreamResult result = bit_stream_read_bits(stream, 8);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(0xAB, result.value.u64);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    arithmetic_decoder_free(decoder);
+    
+    bit_stream_free(stream);
+}
+
+void test_arithmetic_reader_writer(void) {
+    // Test that the file writer emits the same bytes as BitStream and that
+    // the reader decodes them across small buffer refills
+    static bool flags[FLAG_COUNT];
+    fill_flags(flags, FLAG_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    ArithmeticEncoder* encoder = arithmetic_encoder_new(stream, CONTEXT_COUNT);
+    for (size_t i = 0; i < FLAG_COUNT; i++) {
+        TEST_ASSERT_TRUE(arithmetic_encoder_encode_flag(encoder, i % CONTEXT_COUNT, flags[i]).success);
+    }
+    TEST_ASSERT_TRUE(arithmetic_encoder_finish(encoder).success);
+    arithmetic_encoder_free(encoder);
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    encoder = arithmetic_encoder_new_writer(writer, CONTEXT_COUNT);
+    for (size_t i = 0; i < FLAG_COUNT; i++) {
+        TEST_ASSERT_TRUE(arithmetic_encoder_encode_flag(encoder, i % CONTEXT_COUNT, flags[i]).success);
+    }
+    TEST_ASSERT_TRUE(arithmetic_encoder_finish(encoder).success);
+    arithmetic_encoder_free(encoder);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    static uint8_t bytes[FLAG_COUNT / 8];
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_size_t(bit_stream_length(stream) / 8, size);
+    TEST_ASSERT_EQUAL_MEMORY(stream->buffer, bytes, size);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 3);
+    TEST_ASSERT_NOT_NULL(reader);
+    ArithmeticDecoder* decoder = arithmetic_decoder_new_reader(reader, CONTEXT_COUNT);
+    for (size_t i = 0; i < FLAG_COUNT; i++) {
+        BitStreamResult result = arithmetic_decoder_decode_flag(decoder, i % CONTEXT_COUNT);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(flags[i], result.value.u64);
+    }
+    arithmetic_decoder_free(decoder);
+    bit_stream_reader_free(reader);
+    fclose(file);
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_arithmetic_flags);
+    RUN_TEST(test_arithmetic_restart_and_contexts);
+    RUN_TEST(test_arithmetic_empty_group);
+    RUN_TEST(test_arithmetic_reader_writer);
+    
+    return UNITY_END();
+}
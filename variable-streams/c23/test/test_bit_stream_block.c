@@ -0,0 +1,229 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#define VALUE_COUNT 1000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with a slowly drifting metric: a wide global range made of
+// small local ranges
+static void fill_metric(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    uint64_t level = 1ULL << 40;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 128 == 0) {
+            level += test_next_random(&state) % (1ULL << 36);
+        }
+        values[i] = level + test_next_random(&state) % 1000;
+    }
+}
+
+void test_block_range(void) {
+    // Test the vector min/max against a scalar scan, across the sign bit
+    uint64_t values[37];
+    uint64_t state = 7;
+    for (size_t count = 0; count <= 37; count++) {
+        for (size_t i = 0; i < count; i++) {
+            values[i] = test_next_random(&state);
+        }
+        uint64_t expected_min = (count > 0) ? values[0] : 0;
+        uint64_t expected_max = expected_min;
+        for (size_t i = 0; i < count; i++) {
+            expected_min = (values[i] < expected_min) ? values[i] : expected_min;
+            expected_max = (values[i] > expected_max) ? values[i] : expected_max;
+        }
+        
+        uint64_t min;
+        uint64_t max;
+        bit_stream_block_range(values, count, &min, &max);
+        TEST_ASSERT_EQUAL_UINT64(expected_min, min);
+        TEST_ASSERT_EQUAL_UINT64(expected_max, max);
+    }
+}
+
+void test_for_block_layout(void) {
+    // Test the header and residuals of one small block
+    BitStream* stream = bit_stream_new();
+    uint64_t values[4] = {1000, 1003, 1001, 1007};
+    
+    TEST_ASSERT_TRUE(bit_stream_write_for_block(stream, values, 4).success);
+    TEST_ASSERT_EQUAL_size_t(7 + 64 + 4 * 3, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(3, bit_stream_read_bits(stream, 7).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(1000, bit_stream_read_bits(stream, 64).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(3, bit_stream_read_bits(stream, 3).value.u64);
+    
+    // Equal values need no residual bits
+    BitStreamCheckpoint start = {0, 0, 0};
+    TEST_ASSERT_TRUE(bit_stream_rollback(stream, start).success);
+    uint64_t constant[5] = {42, 42, 42, 42, 42};
+    uint64_t decoded[5];
+    TEST_ASSERT_TRUE(bit_stream_write_for_block(stream, constant, 5).success);
+    TEST_ASSERT_EQUAL_size_t(7 + 64, bit_stream_length(stream));
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_for_block(stream, decoded, 5).success);
+    TEST_ASSERT_EQUAL_MEMORY(constant, decoded, sizeof(constant));
+    
+    BitStreamResult result = bit_stream_write_for_block(stream, decoded, BIT_STREAM_BLOCK_MAX_VALUES + 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_for_round_trip(void) {
+    // Test a drifting metric column and full-range values
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    fill_metric(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_write_for(stream, values, VALUE_COUNT).success);
+    size_t packed_bits = bit_stream_length(stream) - 1;
+    
+    // Per-block widths beat the single width the global range needs
+    uint64_t min;
+    uint64_t max;
+    bit_stream_block_range(values, VALUE_COUNT, &min, &max);
+    size_t global_width = 64 - (size_t)__builtin_clzll(max - min);
+    TEST_ASSERT_TRUE(packed_bits * 2 < VALUE_COUNT * global_width);
+    
+    uint64_t extremes[3] = {0, UINT64_MAX, 5};
+    TEST_ASSERT_TRUE(bit_stream_write_for_block(stream, extremes, 3).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(1, bit_stream_read_bits(stream, 1).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_for(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_for_block(stream, decoded, 3).success);
+    TEST_ASSERT_EQUAL_MEMORY(extremes, decoded, sizeof(extremes));
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    BitStreamResult result = bit_stream_read_for_block(stream, decoded, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+// Fills values with latency-histogram-like data: mostly small counts with
+// a rare 40-bit outlier
+static void fill_latencies(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        values[i] = test_next_random(&state) % 50;
+        if (i % 61 == 17) {
+            values[i] = (1ULL << 39) + test_next_random(&state) % 1000;
+        }
+    }
+}
+
+void test_pfor_outliers(void) {
+    // Test that one outlier no longer widens the whole block
+    BitStream* for_stream = bit_stream_new();
+    BitStream* pfor_stream = bit_stream_new();
+    uint64_t values[128];
+    uint64_t decoded[128];
+    for (size_t i = 0; i < 128; i++) {
+        values[i] = i % 40;
+    }
+    values[77] = 1ULL << 40;
+    
+    TEST_ASSERT_TRUE(bit_stream_write_for_block(for_stream, values, 128).success);
+    TEST_ASSERT_TRUE(bit_stream_write_pfor_block(pfor_stream, values, 128).success);
+    
+    // 6 bits per value plus one exception of 8 position and 35 high bits
+    TEST_ASSERT_EQUAL_size_t(7 + 64 + 128 * 41, bit_stream_length(for_stream));
+    TEST_ASSERT_EQUAL_size_t(7 + 64 + 128 * 6 + 9 + 7 + 8 + 35, bit_stream_length(pfor_stream));
+    
+    bit_stream_reset(pfor_stream);
+    TEST_ASSERT_TRUE(bit_stream_read_pfor_block(pfor_stream, decoded, 128).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    bit_stream_free(for_stream);
+    bit_stream_free(pfor_stream);
+}
+
+void test_pfor_round_trip(void) {
+    // Test columns with outliers, no outliers and only outliers
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    fill_latencies(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 3, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_pfor(stream, values, VALUE_COUNT).success);
+    size_t pfor_bits = bit_stream_length(stream) - 2;
+    
+    BitStream* reference = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_for(reference, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(pfor_bits * 3 < bit_stream_length(reference));
+    bit_stream_free(reference);
+    
+    uint64_t constant[3] = {9, 9, 9};
+    uint64_t extremes[4] = {0, UINT64_MAX, 1, UINT64_MAX - 1};
+    TEST_ASSERT_TRUE(bit_stream_write_pfor_block(stream, constant, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_pfor_block(stream, extremes, 4).success);
+    TEST_ASSERT_TRUE(bit_stream_write_pfor_block(stream, values, BIT_STREAM_BLOCK_MAX_VALUES).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(3, bit_stream_read_bits(stream, 2).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_pfor(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_pfor_block(stream, decoded, 3).success);
+    TEST_ASSERT_EQUAL_MEMORY(constant, decoded, sizeof(constant));
+    TEST_ASSERT_TRUE(bit_stream_read_pfor_block(stream, decoded, 4).success);
+    TEST_ASSERT_EQUAL_MEMORY(extremes, decoded, sizeof(extremes));
+    TEST_ASSERT_TRUE(bit_stream_read_pfor_block(stream, decoded, BIT_STREAM_BLOCK_MAX_VALUES).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, BIT_STREAM_BLOCK_MAX_VALUES * sizeof(uint64_t));
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    bit_stream_free(stream);
+}
+
+void test_pfor_corrupt_position(void) {
+    // Test that an exception pointing past the block is rejected
+    BitStream* stream = bit_stream_new();
+    uint64_t decoded[4];
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 7).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 64).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 4).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 9).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 3, 7).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 4, 8).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 5, 3).success);
+    
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_pfor_block(stream, decoded, 4);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_block_range);
+    RUN_TEST(test_for_block_layout);
+    RUN_TEST(test_for_round_trip);
+    RUN_TEST(test_pfor_outliers);
+    RUN_TEST(test_pfor_round_trip);
+    RUN_TEST(test_pfor_corrupt_position);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define FLAG_COUNT 5000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills flags with a presence map where roughly one in four is set
+static void fill_flags(bool* flags, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        flags[i] = (state % 4) == 0;
+    }
+}
+
+void test_bit_stream_bool_array_layout(void) {
+    // Test that element 0 is the first bit written, as with 1-bit fields
+    bool flags[70] = {false};
+    flags[0] = true;
+    flags[2] = true;
+    flags[63] = true;
+    flags[64] = true;
+    flags[69] = true;
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bool_array(stream, flags, 70).success);
+    TEST_ASSERT_EQUAL_size_t(70, bit_stream_length(stream));
+    
+    BitStream* expected = bit_stream_new();
+    for (size_t i = 0; i < 70; i++) {
+        TEST_ASSERT_TRUE(bit_stream_write_bits(expected, flags[i], 1).success);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(expected->buffer, stream->buffer, 9);
+    
+    bit_stream_free(expected);
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_bool_array(void) {
+    // Test a round trip at an unaligned position
+    static bool flags[FLAG_COUNT];
+    static bool decoded[FLAG_COUNT];
+    fill_flags(flags, FLAG_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bool_array(stream, flags, FLAG_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    TEST_ASSERT_EQUAL_size_t(3 + FLAG_COUNT + 7, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_bool_array(stream, decoded, FLAG_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(flags, decoded, sizeof(flags));
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    
+    // Reading past the end fails
+    BitStreamResult result = bit_stream_read_bool_array(stream, decoded, 64);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_popcount_range(void) {
+    // Test ranges against a count of the flags themselves
+    static bool flags[FLAG_COUNT];
+    fill_flags(flags, FLAG_COUNT);
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x7, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bool_array(stream, flags, FLAG_COUNT).success);
+    
+    size_t ranges[6][2] = {{0, 0}, {3, 4}, {5, 7}, {3, 3 + FLAG_COUNT}, {100, 1000}, {1234, 4321}};
+    for (size_t r = 0; r < 6; r++) {
+        uint64_t expected = 0;
+        for (size_t i = ranges[r][0]; i < ranges[r][1]; i++) {
+            expected += flags[i - 3];
+        }
+        TEST_ASSERT_EQUAL_UINT64(expected, bit_stream_popcount_range(stream, ranges[r][0], ranges[r][1]));
+    }
+    
+    // The prefix bits count too, and the end is clamped to the length
+    TEST_ASSERT_EQUAL_UINT64(3, bit_stream_popcount_range(stream, 0, 3));
+    TEST_ASSERT_EQUAL_UINT64(bit_stream_popcount_range(stream, 0, 3 + FLAG_COUNT),
+                             bit_stream_popcount_range(stream, 0, SIZE_MAX));
+    TEST_ASSERT_EQUAL_UINT64(0, bit_stream_popcount_range(stream, 10, 5));
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_bit_stream_bool_array_layout);
+    RUN_TEST(test_bit_stream_bool_array);
+    RUN_TEST(test_bit_stream_popcount_range);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#define VALUE_COUNT 1000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with nanosecond timestamps sampled every millisecond with
+// a little jitter
+static void fill_timestamps(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    uint64_t time = 1700000000000000000ULL;
+    for (size_t i = 0; i < count; i++) {
+        time += 1000000 + test_next_random(&state) % 64;
+        values[i] = time;
+    }
+}
+
+void test_prefix_sum(void) {
+    // Test the vector scan against a scalar one, including tails
+    uint64_t values[23];
+    uint64_t expected[23];
+    uint64_t state = 3;
+    for (size_t count = 0; count <= 23; count++) {
+        uint64_t total = 1000;
+        for (size_t i = 0; i < count; i++) {
+            values[i] = test_next_random(&state);
+            total += values[i];
+            expected[i] = total;
+        }
+        prefix_sum_u64(values, count, 1000);
+        TEST_ASSERT_EQUAL_MEMORY(expected, values, count * sizeof(uint64_t));
+    }
+}
+
+void test_delta_round_trip(void) {
+    // Test timestamps, a signed series and short columns
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    fill_timestamps(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_delta(stream, values, VALUE_COUNT).success);
+    
+    // Jitter of under 64ns on a 1ms step packs in a few bits per sample
+    TEST_ASSERT_TRUE(bit_stream_length(stream) < VALUE_COUNT * 24);
+    
+    int64_t wave[6] = {5, -3, -3, 100, INT64_MIN, INT64_MAX};
+    TEST_ASSERT_TRUE(bit_stream_write_delta(stream, (const uint64_t*)wave, 6).success);
+    TEST_ASSERT_TRUE(bit_stream_write_delta(stream, values, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_write_delta(stream, values, 0).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_delta(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_delta(stream, decoded, 6).success);
+    TEST_ASSERT_EQUAL_MEMORY(wave, decoded, sizeof(wave));
+    TEST_ASSERT_TRUE(bit_stream_read_delta(stream, decoded, 1).success);
+    TEST_ASSERT_EQUAL_UINT64(values[0], decoded[0]);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    bit_stream_free(stream);
+}
+
+void test_delta_of_delta_round_trip(void) {
+    // Test that a steady sampling rate costs almost nothing per sample
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        values[i] = 1700000000000000000ULL + i * 15000000000ULL + ((i % 50 == 0) ? 3 : 0);
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_delta_of_delta(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_length(stream) < VALUE_COUNT * 8);
+    
+    uint64_t jittered[VALUE_COUNT];
+    fill_timestamps(jittered, VALUE_COUNT);
+    TEST_ASSERT_TRUE(bit_stream_write_delta_of_delta(stream, jittered, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_delta_of_delta(stream, values, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_delta_of_delta(stream, values, 1).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_delta_of_delta(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_delta_of_delta(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(jittered, decoded, sizeof(jittered));
+    TEST_ASSERT_TRUE(bit_stream_read_delta_of_delta(stream, decoded, 2).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, 2 * sizeof(uint64_t));
+    TEST_ASSERT_TRUE(bit_stream_read_delta_of_delta(stream, decoded, 1).success);
+    TEST_ASSERT_EQUAL_UINT64(values[0], decoded[0]);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    BitStreamResult result = bit_stream_read_delta_of_delta(stream, decoded, 3);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_prefix_sum);
+    RUN_TEST(test_delta_round_trip);
+    RUN_TEST(test_delta_of_delta_round_trip);
+    
+    return UNITY_END();
+}
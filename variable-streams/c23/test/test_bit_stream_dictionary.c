@@ -0,0 +1,146 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define VALUE_COUNT 4000
+#define DEVICE_COUNT 37
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with 64-bit identifiers drawn from DEVICE_COUNT devices
+static void fill_devices(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        values[i] = ((state % DEVICE_COUNT) + 1) * 0xD1B54A32D192ED03ULL;
+    }
+}
+
+void test_dictionary_build(void) {
+    // Test first-occurrence order and indices
+    uint64_t values[7] = {50, 7, 50, 50, 9, 7, 0};
+    uint64_t entries[7];
+    uint64_t indices[7];
+    TEST_ASSERT_EQUAL_size_t(4, dictionary_build_u64(values, 7, entries, indices));
+    uint64_t expected_entries[4] = {50, 7, 9, 0};
+    uint64_t expected_indices[7] = {0, 1, 0, 0, 2, 1, 3};
+    TEST_ASSERT_EQUAL_UINT64_ARRAY(expected_entries, entries, 4);
+    TEST_ASSERT_EQUAL_UINT64_ARRAY(expected_indices, indices, 7);
+    
+    // 128-bit values that share a half stay distinct
+    UInt128 wide[4] = {uint128_from_parts(1, 2), uint128_from_parts(2, 1), uint128_from_parts(1, 2), uint128_from_parts(1, 3)};
+    UInt128 wide_entries[4];
+    TEST_ASSERT_EQUAL_size_t(3, dictionary_build_u128(wide, 4, wide_entries, indices));
+    TEST_ASSERT_EQUAL_UINT64(0, indices[2]);
+    TEST_ASSERT_EQUAL_UINT64(2, indices[3]);
+}
+
+void test_bit_stream_dictionary(void) {
+    // Test a round trip of low-cardinality identifiers and its size
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    fill_devices(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_dictionary(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    
+    // 37 entries take 6-bit indices plus the page
+    size_t expected_bits = 3 + 11 + DEVICE_COUNT * 64 + VALUE_COUNT * 6 + 7;
+    TEST_ASSERT_EQUAL_size_t(expected_bits, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_dictionary(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_UINT64_ARRAY(values, decoded, VALUE_COUNT);
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_dictionary_single_and_empty(void) {
+    // Test that a constant batch needs no index bits and an empty one works
+    uint64_t values[100];
+    uint64_t decoded[100];
+    for (size_t i = 0; i < 100; i++) {
+        values[i] = 0xFEEDFACECAFEBEEFULL;
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_dictionary(stream, values, 100).success);
+    TEST_ASSERT_EQUAL_size_t(3 + 64, bit_stream_length(stream));
+    TEST_ASSERT_TRUE(bit_stream_write_dictionary(stream, values, 0).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_dictionary(stream, decoded, 100).success);
+    TEST_ASSERT_EQUAL_UINT64_ARRAY(values, decoded, 100);
+    TEST_ASSERT_TRUE(bit_stream_read_dictionary(stream, decoded, 0).success);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_dictionary_rejects_bad_index(void) {
+    // Test that an index past the dictionary is refused
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_elias_gamma(stream, 4).success);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(bit_stream_write_bits(stream, (uint64_t)i, 64).success);
+    }
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 3, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 2).success);
+    
+    bit_stream_reset(stream);
+    uint64_t decoded[3];
+    BitStreamResult result = bit_stream_read_dictionary(stream, decoded, 3);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_dictionary_u128(void) {
+    // Test 128-bit identifiers, such as UUIDs of a few regions
+    static UInt128 values[VALUE_COUNT];
+    static UInt128 decoded[VALUE_COUNT];
+    static uint64_t seeds[VALUE_COUNT];
+    fill_devices(seeds, VALUE_COUNT);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        values[i] = uint128_from_parts(seeds[i] % 5, seeds[i] ^ 0x0123456789ABCDEFULL);
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_dictionary_u128(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_size_t(11 + DEVICE_COUNT * 128 + VALUE_COUNT * 6, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_dictionary_u128(stream, decoded, VALUE_COUNT).success);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        TEST_ASSERT_TRUE(uint128_equal(values[i], decoded[i]));
+    }
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_dictionary_build);
+    RUN_TEST(test_bit_stream_dictionary);
+    RUN_TEST(test_bit_stream_dictionary_single_and_empty);
+    RUN_TEST(test_bit_stream_dictionary_rejects_bad_index);
+    RUN_TEST(test_bit_stream_dictionary_u128);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_durability.bin"
+
+#define GROUP_THREAD_COUNT 4
+#define GROUP_ROUND_COUNT 25
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+static long file_size(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+void test_durability_none_commit_flushes(void) {
+    // Test that committing without a durability policy still hands the data over
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_new(file);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamResult result = bit_stream_writer_write_bits(writer, 0xABCD, 16);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_commit(writer);
+    TEST_ASSERT_TRUE(result.success);
+    
+    TEST_ASSERT_EQUAL(2, file_size(TEST_FILE_PATH));
+    
+    bit_stream_writer_free(writer);
+    fclose(file);
+}
+
+void test_durability_commit_keeps_partial_byte(void) {
+    // Test that a commit leaves a partial byte buffered instead of padding it
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_new(file);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamResult result = bit_stream_writer_write_bits(writer, 0xABC, 12);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_commit(writer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL(1, file_size(TEST_FILE_PATH));
+    
+    // The next bits complete the held back byte
+    result = bit_stream_writer_write_bits(writer, 0x5, 4);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_commit(writer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL(2, file_size(TEST_FILE_PATH));
+    
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_new(file);
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_EQUAL_UINT64(0xABC, bit_stream_reader_read_bits(reader, 12).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_reader_read_bits(reader, 4).value.u64);
+    bit_stream_reader_free(reader);
+    fclose(file);
+}
+
+void test_durability_periodic_by_bytes(void) {
+    // Test that the writer syncs once enough bytes have been flushed
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamDurability durability = {BIT_STREAM_DURABILITY_PERIODIC, 32, 0, NULL};
+    TEST_ASSERT_TRUE(bit_stream_writer_set_durability(writer, durability).success);
+    
+    // 24 bytes: one 16 byte flush, below the threshold
+    for (int i = 0; i < 3; i++) {
+        BitStreamResult result = bit_stream_writer_write_bits(writer, (uint64_t)i, 64);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    TEST_ASSERT_EQUAL_size_t(16, writer->unsynced_bytes);
+    
+    // 40 bytes: the second flush crosses the threshold and syncs
+    for (int i = 0; i < 2; i++) {
+        BitStreamResult result = bit_stream_writer_write_bits(writer, (uint64_t)i, 64);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    TEST_ASSERT_EQUAL_size_t(0, writer->unsynced_bytes);
+    
+    // Committing forces the remainder out
+    BitStreamResult result = bit_stream_writer_commit(writer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(0, writer->unsynced_bytes);
+    TEST_ASSERT_EQUAL(40, file_size(TEST_FILE_PATH));
+    
+    bit_stream_writer_free(writer);
+    fclose(file);
+}
+
+void test_durability_periodic_by_interval(void) {
+    // Test that a flush syncs once the last sync is older than the interval,
+    // even when it has no new bytes to hand over
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamDurability durability = {BIT_STREAM_DURABILITY_PERIODIC, 0, 60000, NULL};
+    TEST_ASSERT_TRUE(bit_stream_writer_set_durability(writer, durability).success);
+    
+    BitStreamResult result = bit_stream_writer_write_bits(writer, 0x0123456789ABCDEFULL, 64);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(8, writer->unsynced_bytes);
+    
+    // Age the last sync past the interval
+    writer->last_sync_ms -= 60000;
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_size_t(0, writer->unsynced_bytes);
+    TEST_ASSERT_EQUAL(8, file_size(TEST_FILE_PATH));
+    
+    bit_stream_writer_free(writer);
+    fclose(file);
+}
+
+typedef struct {
+    FILE* file;
+    BitStreamGroupCommit* group;
+    uint64_t tag;
+    int failures;
+} GroupCommitThread;
+
+static void* group_commit_worker(void* arg) {
+    GroupCommitThread* context = (GroupCommitThread*)arg;
+    BitStreamWriter* writer = bit_stream_writer_new(context->file);
+    if (writer == NULL) {
+        context->failures++;
+        return NULL;
+    }
+    
+    BitStreamDurability durability = {BIT_STREAM_DURABILITY_GROUP_COMMIT, 0, 0, context->group};
+    if (!bit_stream_writer_set_durability(writer, durability).success) {
+        context->failures++;
+    }
+    
+    BitStreamResult result = bit_stream_writer_write_bits(writer, context->tag, 64);
+    if (!result.success) {
+        context->failures++;
+    }
+    result = bit_stream_writer_commit(writer);
+    if (!result.success) {
+        context->failures++;
+    }
+    
+    bit_stream_writer_free(writer);
+    return NULL;
+}
+
+void test_durability_group_commit(void) {
+    // Test that concurrent commits gathered while the committer is held share
+    // one sync per round
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamGroupCommit* group = bit_stream_group_commit_new(file);
+    TEST_ASSERT_NOT_NULL(group);
+    
+    pthread_t threads[GROUP_THREAD_COUNT];
+    GroupCommitThread contexts[GROUP_THREAD_COUNT];
+    for (int round = 0; round < GROUP_ROUND_COUNT; round++) {
+        bit_stream_group_commit_hold(group);
+        for (int t = 0; t < GROUP_THREAD_COUNT; t++) {
+            contexts[t].file = file;
+            contexts[t].group = group;
+            contexts[t].tag = (uint64_t)round << 32 | (uint64_t)t;
+            contexts[t].failures = 0;
+            TEST_ASSERT_EQUAL(0, pthread_create(&threads[t], NULL, group_commit_worker, &contexts[t]));
+        }
+        
+        // Every thread has handed its data over and is waiting for a sync
+        while (bit_stream_group_commit_pending(group) < GROUP_THREAD_COUNT) {
+            sched_yield();
+        }
+        TEST_ASSERT_EQUAL_UINT64(round, bit_stream_group_commit_sync_count(group));
+        bit_stream_group_commit_release(group);
+        
+        for (int t = 0; t < GROUP_THREAD_COUNT; t++) {
+            pthread_join(threads[t], NULL);
+            TEST_ASSERT_EQUAL(0, contexts[t].failures);
+        }
+        TEST_ASSERT_EQUAL_UINT64(0, bit_stream_group_commit_pending(group));
+    }
+    
+    // One sync covered each round's commits
+    uint64_t sync_count = bit_stream_group_commit_sync_count(group);
+    TEST_ASSERT_EQUAL_UINT64(GROUP_ROUND_COUNT, sync_count);
+    TEST_ASSERT_TRUE(sync_count < GROUP_THREAD_COUNT * GROUP_ROUND_COUNT);
+    
+    bit_stream_group_commit_free(group);
+    fclose(file);
+    
+    TEST_ASSERT_EQUAL(GROUP_THREAD_COUNT * GROUP_ROUND_COUNT * 8, file_size(TEST_FILE_PATH));
+}
+
+void test_durability_group_commit_requires_group(void) {
+    // Test that group commit without a committer is refused instead of used
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_new(file);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamDurability durability = {BIT_STREAM_DURABILITY_GROUP_COMMIT, 0, 0, NULL};
+    BitStreamResult result = bit_stream_writer_set_durability(writer, durability);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    TEST_ASSERT_EQUAL(BIT_STREAM_DURABILITY_NONE, writer->durability.mode);
+    
+    // A policy set directly on the writer is caught at commit
+    writer->durability = durability;
+    result = bit_stream_writer_write_bits(writer, 0xAB, 8);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_commit(writer);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_writer_free(writer);
+    fclose(file);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_durability_none_commit_flushes);
+    RUN_TEST(test_durability_commit_keeps_partial_byte);
+    RUN_TEST(test_durability_periodic_by_bytes);
+    RUN_TEST(test_durability_periodic_by_interval);
+    RUN_TEST(test_durability_group_commit);
+    RUN_TEST(test_durability_group_commit_requires_group);
+    
+    return UNITY_END();
+}
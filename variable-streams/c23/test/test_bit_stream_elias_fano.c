@@ -0,0 +1,169 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define VALUE_COUNT 3000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with a sorted sequence whose gaps are below max_gap, repeats
+// included
+static void fill_sorted(uint64_t* values, size_t count, uint64_t start, uint64_t max_gap) {
+    uint64_t state = TEST_RANDOM_SEED;
+    uint64_t value = start;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        value += state % max_gap;
+        values[i] = value;
+    }
+}
+
+// Checks access and next_geq of a sequence against its values
+static void check_sequence(const EliasFano* sequence, const uint64_t* values, size_t count) {
+    TEST_ASSERT_EQUAL_size_t(count, elias_fano_count(sequence));
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT64(values[i], elias_fano_access(sequence, i));
+    }
+    for (size_t i = 0; i < count; i++) {
+        // The first of a run of repeats, and the value just above the one before
+        size_t first = i;
+        while (first > 0 && values[first - 1] == values[i]) {
+            first--;
+        }
+        TEST_ASSERT_EQUAL_size_t(first, elias_fano_next_geq(sequence, values[i]));
+        if (i > 0 && values[i - 1] + 1 < values[i]) {
+            TEST_ASSERT_EQUAL_size_t(i, elias_fano_next_geq(sequence, values[i - 1] + 1));
+        }
+    }
+    if (count > 0 && values[count - 1] < UINT64_MAX) {
+        TEST_ASSERT_EQUAL_size_t(count, elias_fano_next_geq(sequence, values[count - 1] + 1));
+        TEST_ASSERT_EQUAL_size_t(count, elias_fano_next_geq(sequence, UINT64_MAX));
+    }
+    TEST_ASSERT_EQUAL_size_t(0, elias_fano_next_geq(sequence, 0));
+}
+
+// Writes values between two markers, then decodes them both ways
+static void check_round_trip(const uint64_t* values, size_t count) {
+    static uint64_t decoded[VALUE_COUNT];
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_elias_fano(stream, values, count).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_elias_fano(stream, decoded, count).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, count * sizeof(uint64_t));
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    EliasFano* sequence = NULL;
+    TEST_ASSERT_TRUE(bit_stream_read_elias_fano_sequence(stream, &sequence).success);
+    check_sequence(sequence, values, count);
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    
+    elias_fano_free(sequence);
+    bit_stream_free(stream);
+}
+
+void test_elias_fano_round_trip(void) {
+    // Test dense runs with repeats, sparse values and large values
+    static uint64_t values[VALUE_COUNT];
+    uint64_t max_gaps[4] = {2, 16, 100000, 1ULL << 40};
+    for (size_t g = 0; g < 4; g++) {
+        fill_sorted(values, VALUE_COUNT, g * 1000, max_gaps[g]);
+        check_round_trip(values, VALUE_COUNT);
+    }
+    
+    uint64_t edges[4] = {0, 0, UINT64_MAX - 1, UINT64_MAX};
+    check_round_trip(edges, 4);
+    check_round_trip(edges + 2, 1);
+    check_round_trip(edges, 0);
+}
+
+void test_elias_fano_size(void) {
+    // Test the size against the bound of 2 + ceil(log2(last / count)) bits
+    static uint64_t values[VALUE_COUNT];
+    fill_sorted(values, VALUE_COUNT, 0, 1000);
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_elias_fano(stream, values, VALUE_COUNT).success);
+    
+    uint64_t spacing = values[VALUE_COUNT - 1] / VALUE_COUNT;
+    size_t ceil_log2 = 0;
+    while (((uint64_t)1 << ceil_log2) < spacing) {
+        ceil_log2++;
+    }
+    TEST_ASSERT_TRUE(bit_stream_length(stream) <= VALUE_COUNT * (2 + ceil_log2) + 64);
+    bit_stream_free(stream);
+}
+
+void test_elias_fano_from_values(void) {
+    // Test a sequence built in memory
+    static uint64_t values[VALUE_COUNT];
+    fill_sorted(values, VALUE_COUNT, 7, 300);
+    EliasFano* sequence = elias_fano_from_values(values, VALUE_COUNT);
+    TEST_ASSERT_NOT_NULL(sequence);
+    check_sequence(sequence, values, VALUE_COUNT);
+    elias_fano_free(sequence);
+}
+
+void test_elias_fano_rejects_unsorted(void) {
+    // Test that decreasing values are refused
+    uint64_t values[4] = {1, 5, 4, 9};
+    BitStream* stream = bit_stream_new();
+    BitStreamResult result = bit_stream_write_elias_fano(stream, values, 4);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    TEST_ASSERT_NULL(elias_fano_from_values(values, 4));
+    bit_stream_free(stream);
+}
+
+void test_elias_fano_read_errors(void) {
+    // Test a count that does not match and a truncated sequence
+    static uint64_t values[VALUE_COUNT];
+    fill_sorted(values, VALUE_COUNT, 0, 50);
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_elias_fano(stream, values, VALUE_COUNT).success);
+    
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_elias_fano(stream, values, VALUE_COUNT - 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    BitStreamCheckpoint checkpoint = bit_stream_checkpoint(stream);
+    checkpoint.bit_position = 0;
+    checkpoint.bit_length = bit_stream_length(stream) - 10;
+    TEST_ASSERT_TRUE(bit_stream_rollback(stream, checkpoint).success);
+    result = bit_stream_read_elias_fano(stream, values, VALUE_COUNT);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_reset(stream);
+    EliasFano* sequence = NULL;
+    result = bit_stream_read_elias_fano_sequence(stream, &sequence);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_NULL(sequence);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_elias_fano_round_trip);
+    RUN_TEST(test_elias_fano_size);
+    RUN_TEST(test_elias_fano_from_values);
+    RUN_TEST(test_elias_fano_rejects_unsorted);
+    RUN_TEST(test_elias_fano_read_errors);
+    
+    return UNITY_END();
+}
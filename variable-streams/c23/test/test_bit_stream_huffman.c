@@ -0,0 +1,190 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_huffman.bin"
+
+#define SYMBOL_COUNT 5000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+// Fills symbols with a skewed enum: symbol k is about twice as likely as
+// symbol k + 1, over a 16-value alphabet
+static void fill_events(uint8_t* symbols, size_t count, uint64_t* histogram) {
+    uint64_t state = TEST_RANDOM_SEED;
+    memset(histogram, 0, 16 * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        uint8_t symbol = 0;
+        uint64_t bits = state;
+        while ((bits & 1) == 0 && symbol < 15) {
+            symbol++;
+            bits >>= 1;
+        }
+        symbols[i] = symbol;
+        histogram[symbol]++;
+    }
+}
+
+void test_huffman_lengths(void) {
+    // Test that lengths follow the weights and respect the length limit
+    uint64_t histogram[4] = {8, 4, 2, 2};
+    HuffmanCode* code = huffman_code_from_histogram(histogram, 4);
+    TEST_ASSERT_NOT_NULL(code);
+    TEST_ASSERT_EQUAL_UINT8(1, huffman_code_length(code, 0));
+    TEST_ASSERT_EQUAL_UINT8(2, huffman_code_length(code, 1));
+    TEST_ASSERT_EQUAL_UINT8(3, huffman_code_length(code, 2));
+    TEST_ASSERT_EQUAL_UINT8(3, huffman_code_length(code, 3));
+    huffman_code_free(code);
+    
+    // Fibonacci weights would need codes of up to 39 bits without a limit
+    uint64_t fibonacci[40];
+    fibonacci[0] = 1;
+    fibonacci[1] = 1;
+    for (size_t i = 2; i < 40; i++) {
+        fibonacci[i] = fibonacci[i - 1] + fibonacci[i - 2];
+    }
+    code = huffman_code_from_histogram(fibonacci, 40);
+    TEST_ASSERT_NOT_NULL(code);
+    uint32_t kraft = 0;
+    for (uint8_t s = 0; s < 40; s++) {
+        uint8_t length = huffman_code_length(code, s);
+        TEST_ASSERT_TRUE(length >= 1 && length <= HUFFMAN_MAX_CODE_LENGTH);
+        kraft += 1U << (HUFFMAN_MAX_CODE_LENGTH - length);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1U << HUFFMAN_MAX_CODE_LENGTH, kraft);
+    huffman_code_free(code);
+    
+    // One used symbol still gets a one-bit code
+    uint64_t single[3] = {0, 9, 0};
+    code = huffman_code_from_histogram(single, 3);
+    TEST_ASSERT_EQUAL_UINT8(0, huffman_code_length(code, 0));
+    TEST_ASSERT_EQUAL_UINT8(1, huffman_code_length(code, 1));
+    huffman_code_free(code);
+}
+
+void test_bit_stream_huffman(void) {
+    // Test skewed symbols through a table header, against fixed 4-bit enums
+    static uint8_t symbols[SYMBOL_COUNT];
+    static uint8_t decoded[SYMBOL_COUNT];
+    uint64_t histogram[16];
+    fill_events(symbols, SYMBOL_COUNT, histogram);
+    HuffmanCode* code = huffman_code_from_histogram(histogram, 16);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_huffman_table(stream, code).success);
+    TEST_ASSERT_TRUE(bit_stream_write_huffman(stream, code, symbols, SYMBOL_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_length(stream) < SYMBOL_COUNT * 4 * 6 / 10);
+    
+    uint8_t unknown = 20;
+    BitStreamResult result = bit_stream_write_huffman(stream, code, &unknown, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(1, bit_stream_read_bits(stream, 3).value.u64);
+    HuffmanCode* read_code = NULL;
+    TEST_ASSERT_TRUE(bit_stream_read_huffman_table(stream, &read_code).success);
+    TEST_ASSERT_NOT_NULL(read_code);
+    TEST_ASSERT_TRUE(bit_stream_read_huffman(stream, read_code, decoded, 7).success);
+    TEST_ASSERT_TRUE(bit_stream_read_huffman(stream, read_code, decoded + 7, SYMBOL_COUNT - 7).success);
+    TEST_ASSERT_EQUAL_MEMORY(symbols, decoded, sizeof(symbols));
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    result = bit_stream_read_huffman(stream, read_code, decoded, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    huffman_code_free(read_code);
+    huffman_code_free(code);
+    bit_stream_free(stream);
+}
+
+void test_huffman_table_rejects_oversubscribed(void) {
+    // Test that three one-bit codes are refused
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 3, 9).success);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 4).success);
+    }
+    
+    bit_stream_reset(stream);
+    HuffmanCode* code = NULL;
+    BitStreamResult result = bit_stream_read_huffman_table(stream, &code);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    TEST_ASSERT_NULL(code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reader_writer_huffman(void) {
+    // Test that the file writer emits the same bytes as BitStream and that
+    // the reader decodes them across small buffer refills
+    static uint8_t symbols[SYMBOL_COUNT];
+    static uint8_t decoded[SYMBOL_COUNT];
+    uint64_t histogram[16];
+    fill_events(symbols, SYMBOL_COUNT, histogram);
+    HuffmanCode* code = huffman_code_from_histogram(histogram, 16);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_huffman_table(stream, code).success);
+    TEST_ASSERT_TRUE(bit_stream_write_huffman(stream, code, symbols, SYMBOL_COUNT).success);
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_huffman_table(writer, code).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_huffman(writer, code, symbols, SYMBOL_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    static uint8_t bytes[SYMBOL_COUNT];
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_size_t((bit_stream_length(stream) + 7) / 8, size);
+    TEST_ASSERT_EQUAL_MEMORY(stream->buffer, bytes, size);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 5);
+    TEST_ASSERT_NOT_NULL(reader);
+    HuffmanCode* read_code = NULL;
+    TEST_ASSERT_TRUE(bit_stream_reader_read_huffman_table(reader, &read_code).success);
+    TEST_ASSERT_TRUE(bit_stream_reader_read_huffman(reader, read_code, decoded, SYMBOL_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(symbols, decoded, sizeof(symbols));
+    
+    huffman_code_free(read_code);
+    bit_stream_reader_free(reader);
+    fclose(file);
+    huffman_code_free(code);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_huffman_lengths);
+    RUN_TEST(test_bit_stream_huffman);
+    RUN_TEST(test_huffman_table_rejects_oversubscribed);
+    RUN_TEST(test_bit_stream_reader_writer_huffman);
+    
+    return UNITY_END();
+}
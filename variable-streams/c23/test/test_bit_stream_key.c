@@ -0,0 +1,242 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define KEY_COUNT 400
+#define MAX_NAME_LENGTH 12
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// A composite key: (signed 20-bit, bytes, varint, unsigned 5-bit)
+typedef struct {
+    int64_t offset;
+    uint8_t name[MAX_NAME_LENGTH];
+    size_t name_length;
+    uint64_t sequence;
+    uint64_t flags;
+} Tuple;
+
+// Fills tuples from small alphabets so that many share prefixes and fields
+static void fill_tuples(Tuple* tuples, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        tuples[i].offset = (int64_t)(test_next_random(&state) % 7) - 3;
+        if (test_next_random(&state) % 4 == 0) {
+            tuples[i].offset *= 100000;
+        }
+        tuples[i].name_length = (size_t)(test_next_random(&state) % 4) * (test_next_random(&state) % 4);
+        for (size_t j = 0; j < tuples[i].name_length; j++) {
+            static const uint8_t alphabet[4] = {0x00, 0x01, 'a', 0xFF};
+            tuples[i].name[j] = alphabet[test_next_random(&state) % 4];
+        }
+        tuples[i].sequence = test_next_random(&state) >> (test_next_random(&state) % 64);
+        tuples[i].flags = test_next_random(&state) % 3;
+    }
+}
+
+static int order_of(int compare) {
+    return (compare > 0) - (compare < 0);
+}
+
+static int compare_tuples(const Tuple* a, const Tuple* b) {
+    if (a->offset != b->offset) {
+        return (a->offset < b->offset) ? -1 : 1;
+    }
+    size_t common = (a->name_length < b->name_length) ? a->name_length : b->name_length;
+    int order = order_of(memcmp(a->name, b->name, common));
+    if (order != 0) {
+        return order;
+    }
+    if (a->name_length != b->name_length) {
+        return (a->name_length < b->name_length) ? -1 : 1;
+    }
+    if (a->sequence != b->sequence) {
+        return (a->sequence < b->sequence) ? -1 : 1;
+    }
+    if (a->flags != b->flags) {
+        return (a->flags < b->flags) ? -1 : 1;
+    }
+    return 0;
+}
+
+static BitStream* encode_tuple(const Tuple* tuple) {
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_key_signed(stream, tuple->offset, 20).success);
+    TEST_ASSERT_TRUE(bit_stream_write_key_bytes(stream, tuple->name, tuple->name_length).success);
+    TEST_ASSERT_TRUE(bit_stream_write_key_varint(stream, tuple->sequence).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, tuple->flags, 5).success);
+    return stream;
+}
+
+void test_key_order_matches_tuple_order(void) {
+    // Test every pair of keys against the order of their tuples
+    static Tuple tuples[KEY_COUNT];
+    static BitStream* keys[KEY_COUNT];
+    fill_tuples(tuples, KEY_COUNT);
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+        keys[i] = encode_tuple(&tuples[i]);
+    }
+    
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+        for (size_t j = 0; j < KEY_COUNT; j++) {
+            TEST_ASSERT_EQUAL_INT(compare_tuples(&tuples[i], &tuples[j]), order_of(bit_stream_key_compare(keys[i], keys[j])));
+        }
+    }
+    
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+        bit_stream_free(keys[i]);
+    }
+}
+
+void test_key_round_trip(void) {
+    // Test that every field reads back
+    static Tuple tuples[KEY_COUNT];
+    fill_tuples(tuples, KEY_COUNT);
+    for (size_t i = 0; i < KEY_COUNT; i++) {
+        BitStream* stream = encode_tuple(&tuples[i]);
+        bit_stream_reset(stream);
+        
+        TEST_ASSERT_EQUAL_INT64(tuples[i].offset, bit_stream_read_key_signed(stream, 20).value.i64);
+        uint8_t name[MAX_NAME_LENGTH];
+        BitStreamResult result = bit_stream_read_key_bytes(stream, name, MAX_NAME_LENGTH);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(tuples[i].name_length, result.value.u64);
+        if (tuples[i].name_length > 0) {
+            TEST_ASSERT_EQUAL_MEMORY(tuples[i].name, name, tuples[i].name_length);
+        }
+        TEST_ASSERT_EQUAL_UINT64(tuples[i].sequence, bit_stream_read_key_varint(stream).value.u64);
+        TEST_ASSERT_EQUAL_UINT64(tuples[i].flags, bit_stream_read_bits(stream, 5).value.u64);
+        TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+        bit_stream_free(stream);
+    }
+}
+
+void test_key_bytes_long(void) {
+    // Test strings long enough for the eight-byte path, with and without zeros
+    uint8_t text[40];
+    uint8_t decoded[40];
+    for (size_t i = 0; i < 40; i++) {
+        text[i] = (uint8_t)('A' + i);
+    }
+    for (size_t zero = 0; zero <= 40; zero += 13) {
+        uint8_t saved = (zero < 40) ? text[zero] : 0;
+        if (zero < 40) {
+            text[zero] = 0;
+        }
+        BitStream* stream = bit_stream_new();
+        TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x3, 3).success);
+        TEST_ASSERT_TRUE(bit_stream_write_key_bytes(stream, text, 40).success);
+        bit_stream_reset(stream);
+        TEST_ASSERT_EQUAL_UINT64(0x3, bit_stream_read_bits(stream, 3).value.u64);
+        BitStreamResult result = bit_stream_read_key_bytes(stream, decoded, 40);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(40, result.value.u64);
+        TEST_ASSERT_EQUAL_MEMORY(text, decoded, 40);
+        
+        // A buffer that is too small is reported
+        bit_stream_reset(stream);
+        bit_stream_read_bits(stream, 3);
+        result = bit_stream_read_key_bytes(stream, decoded, 39);
+        TEST_ASSERT_FALSE(result.success);
+        TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+        
+        if (zero < 40) {
+            text[zero] = saved;
+        }
+        bit_stream_free(stream);
+    }
+}
+
+void test_key_signed_i128(void) {
+    // Test that 128-bit signed keys order and read back
+    Int128 values[5] = {
+        int128_from_parts(INT64_MIN, 0), int128_from_i64(-1), int128_from_i64(0),
+        int128_from_parts(0, UINT64_MAX), int128_from_parts(INT64_MAX, UINT64_MAX)
+    };
+    BitStream* keys[5];
+    for (size_t i = 0; i < 5; i++) {
+        keys[i] = bit_stream_new();
+        TEST_ASSERT_TRUE(bit_stream_write_key_signed_i128(keys[i], values[i], 128).success);
+    }
+    for (size_t i = 0; i + 1 < 5; i++) {
+        TEST_ASSERT_TRUE(bit_stream_key_compare(keys[i], keys[i + 1]) < 0);
+    }
+    for (size_t i = 0; i < 5; i++) {
+        bit_stream_reset(keys[i]);
+        Int128 decoded = bit_stream_read_key_signed_i128(keys[i], 128).value.i128;
+        TEST_ASSERT_EQUAL_INT64(values[i].high, decoded.high);
+        TEST_ASSERT_EQUAL_UINT64(values[i].low, decoded.low);
+        bit_stream_free(keys[i]);
+    }
+}
+
+void test_key_signed_range(void) {
+    // Test that signed keys outside the field's range are refused, not truncated
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_key_signed(stream, 127, 8).success);
+    TEST_ASSERT_TRUE(bit_stream_write_key_signed(stream, -128, 8).success);
+    TEST_ASSERT_TRUE(bit_stream_write_key_signed(stream, INT64_MIN, 64).success);
+    TEST_ASSERT_TRUE(bit_stream_write_key_signed_i128(stream, int128_from_i64(-1), 1).success);
+    size_t length = bit_stream_length(stream);
+    
+    int64_t out_of_range[3] = {200, 128, -129};
+    for (size_t i = 0; i < 3; i++) {
+        BitStreamResult result = bit_stream_write_key_signed(stream, out_of_range[i], 8);
+        TEST_ASSERT_FALSE(result.success);
+        TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    }
+    BitStreamResult result = bit_stream_write_key_signed_i128(stream, int128_from_parts(0, 1ULL << 63), 64);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    result = bit_stream_write_key_signed_i128(stream, int128_from_parts(-2, 0), 65);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    TEST_ASSERT_EQUAL_size_t(length, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_INT64(127, bit_stream_read_key_signed(stream, 8).value.i64);
+    TEST_ASSERT_EQUAL_INT64(-128, bit_stream_read_key_signed(stream, 8).value.i64);
+    TEST_ASSERT_EQUAL_INT64(INT64_MIN, bit_stream_read_key_signed(stream, 64).value.i64);
+    TEST_ASSERT_EQUAL_INT64(-1, bit_stream_read_key_signed_i128(stream, 1).value.i128.high);
+    bit_stream_free(stream);
+}
+
+void test_key_varint_limits(void) {
+    // Test the smallest and largest varints and a corrupt width
+    uint64_t values[4] = {0, 1, 2, UINT64_MAX};
+    BitStream* stream = bit_stream_new();
+    for (size_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(bit_stream_write_key_varint(stream, values[i]).success);
+    }
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 65, 7).success);
+    bit_stream_reset(stream);
+    for (size_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_UINT64(values[i], bit_stream_read_key_varint(stream).value.u64);
+    }
+    BitStreamResult result = bit_stream_read_key_varint(stream);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_key_order_matches_tuple_order);
+    RUN_TEST(test_key_round_trip);
+    RUN_TEST(test_key_bytes_long);
+    RUN_TEST(test_key_signed_i128);
+    RUN_TEST(test_key_signed_range);
+    RUN_TEST(test_key_varint_limits);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define VALUE_COUNT 1001
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with pseudo-random doubles in [minimum, maximum]
+static void fill_range(double* values, size_t count, double minimum, double maximum) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        values[i] = minimum + (maximum - minimum) * (double)(state >> 11) / 9007199254740992.0;
+    }
+}
+
+// Unity's double assertions are optional, so differences are checked here
+static bool within(double delta, double expected, double actual) {
+    return actual - expected <= delta && expected - actual <= delta;
+}
+
+void test_quantizer_init(void) {
+    // Test width selection: 100 units at 0.01 need 10000 steps, 14 bits
+    Quantizer quantizer;
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, -50.0, 50.0, 0.01).success);
+    TEST_ASSERT_EQUAL_UINT8(14, quantizer.bit_width);
+    TEST_ASSERT_TRUE(quantizer.step <= 0.01);
+    
+    // Exactly 2^12 - 1 steps fit in 12 bits
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, 0.0, 4095.0, 1.0).success);
+    TEST_ASSERT_EQUAL_UINT8(12, quantizer.bit_width);
+    TEST_ASSERT_TRUE(quantizer.step == 1.0);
+    
+    // A single value needs no bits
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, 3.0, 3.0, 0.5).success);
+    TEST_ASSERT_EQUAL_UINT8(0, quantizer.bit_width);
+    
+    TEST_ASSERT_FALSE(quantizer_init(&quantizer, 1.0, 0.0, 0.1).success);
+    TEST_ASSERT_FALSE(quantizer_init(&quantizer, 0.0, 1.0, 0.0).success);
+    TEST_ASSERT_FALSE(quantizer_init(&quantizer, 0.0, INFINITY, 1.0).success);
+    TEST_ASSERT_FALSE(quantizer_init(&quantizer, 0.0, 1.0, 1e-12).success);
+}
+
+void test_quantize_codes(void) {
+    // Test rounding to the nearest code, clamping and NaN
+    Quantizer quantizer;
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, 0.0, 15.0, 1.0).success);
+    double values[9] = {0.0, 0.49, NAN, 7.2, 14.6, 15.0, -3.0, 1e9, 0.5};
+    uint64_t codes[9];
+    quantize_double(&quantizer, values, codes, 9);
+    uint64_t expected[9] = {0, 0, 0, 7, 15, 15, 0, 15, 1};
+    TEST_ASSERT_EQUAL_UINT64_ARRAY(expected, codes, 9);
+    
+    // The vector path and the scalar tail agree on every lane
+    float narrow[9];
+    for (int i = 0; i < 9; i++) {
+        narrow[i] = (float)values[i];
+    }
+    quantize_float(&quantizer, narrow, codes, 9);
+    TEST_ASSERT_EQUAL_UINT64_ARRAY(expected, codes, 9);
+    
+    double decoded[9];
+    dequantize_double(&quantizer, codes, decoded, 9);
+    TEST_ASSERT_TRUE(decoded[3] == 7.0);
+    TEST_ASSERT_TRUE(decoded[4] == 15.0);
+}
+
+void test_bit_stream_quantized_double(void) {
+    // Test a round trip within half a step and its size
+    static double values[VALUE_COUNT];
+    static double decoded[VALUE_COUNT];
+    fill_range(values, VALUE_COUNT, -40.0, 125.0);
+    Quantizer quantizer;
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, -40.0, 125.0, 0.01).success);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_quantizer(stream, &quantizer).success);
+    TEST_ASSERT_TRUE(bit_stream_write_quantized_double(stream, &quantizer, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    TEST_ASSERT_EQUAL_size_t(3 + 134 + VALUE_COUNT * 15 + 7, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    Quantizer read_quantizer;
+    TEST_ASSERT_TRUE(bit_stream_read_quantizer(stream, &read_quantizer).success);
+    TEST_ASSERT_EQUAL_UINT8(quantizer.bit_width, read_quantizer.bit_width);
+    TEST_ASSERT_TRUE(quantizer.minimum == read_quantizer.minimum && quantizer.step == read_quantizer.step);
+    TEST_ASSERT_TRUE(quantizer.inverse == read_quantizer.inverse);
+    TEST_ASSERT_TRUE(bit_stream_read_quantized_double(stream, &read_quantizer, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        TEST_ASSERT_TRUE(within(quantizer.step / 2 + 1e-12, values[i], decoded[i]));
+    }
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_quantized_float(void) {
+    // Test floats at 12 bits over [0, 1]
+    static double wide[VALUE_COUNT];
+    static float values[VALUE_COUNT];
+    static float decoded[VALUE_COUNT];
+    fill_range(wide, VALUE_COUNT, 0.0, 1.0);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        values[i] = (float)wide[i];
+    }
+    Quantizer quantizer;
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, 0.0, 1.0, 1.0 / 4000).success);
+    TEST_ASSERT_EQUAL_UINT8(12, quantizer.bit_width);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_quantized_float(stream, &quantizer, values, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_size_t(VALUE_COUNT * 12, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_quantized_float(stream, &quantizer, decoded, VALUE_COUNT).success);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        TEST_ASSERT_TRUE(within(quantizer.step / 2 + 1e-6, values[i], decoded[i]));
+    }
+    
+    // Reading past the end fails
+    BitStreamResult result = bit_stream_read_quantized_float(stream, &quantizer, decoded, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_quantized_single_value(void) {
+    // Test that a single-value range writes nothing and reads the value back
+    Quantizer quantizer;
+    TEST_ASSERT_TRUE(quantizer_init(&quantizer, 2.5, 2.5, 0.1).success);
+    double values[5] = {2.5, 2.5, 2.5, 2.5, 2.5};
+    double decoded[5];
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_quantized_double(stream, &quantizer, values, 5).success);
+    TEST_ASSERT_EQUAL_size_t(0, bit_stream_length(stream));
+    TEST_ASSERT_TRUE(bit_stream_read_quantized_double(stream, &quantizer, decoded, 5).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_quantizer_init);
+    RUN_TEST(test_quantize_codes);
+    RUN_TEST(test_bit_stream_quantized_double);
+    RUN_TEST(test_bit_stream_quantized_float);
+    RUN_TEST(test_bit_stream_quantized_single_value);
+    
+    return UNITY_END();
+}
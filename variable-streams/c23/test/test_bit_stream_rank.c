@@ -0,0 +1,124 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define FLAG_COUNT 20000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills flags with a presence map where roughly one in every `one_in` is set
+static void fill_flags(bool* flags, size_t count, uint64_t one_in) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        flags[i] = (state % one_in) == 0;
+    }
+}
+
+// Checks every rank and select of the index against the flags
+static void check_index(const bool* flags, size_t count) {
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bool_array(stream, flags, count).success);
+    RankSelectIndex* index = rank_select_index_new(stream);
+    TEST_ASSERT_NOT_NULL(index);
+    
+    uint64_t ones = 0;
+    uint64_t zeros = 0;
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT64(ones, rank_select_index_rank1(index, i));
+        if (flags[i]) {
+            TEST_ASSERT_EQUAL_size_t(i, rank_select_index_select1(index, ones));
+            ones++;
+        } else {
+            TEST_ASSERT_EQUAL_size_t(i, rank_select_index_select0(index, zeros));
+            zeros++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(ones, rank_select_index_ones(index));
+    TEST_ASSERT_EQUAL_UINT64(ones, rank_select_index_rank1(index, count));
+    TEST_ASSERT_EQUAL_UINT64(ones, rank_select_index_rank1(index, SIZE_MAX));
+    TEST_ASSERT_EQUAL_size_t(SIZE_MAX, rank_select_index_select1(index, ones));
+    TEST_ASSERT_EQUAL_size_t(SIZE_MAX, rank_select_index_select0(index, zeros));
+    
+    rank_select_index_free(index);
+    bit_stream_free(stream);
+}
+
+void test_rank_select_densities(void) {
+    // Test dense, sparse and very sparse maps with a partial last word, and
+    // their complements for select0
+    static bool flags[FLAG_COUNT];
+    uint64_t densities[4] = {2, 7, 300, 5000};
+    for (size_t d = 0; d < 4; d++) {
+        fill_flags(flags, FLAG_COUNT, densities[d]);
+        check_index(flags, FLAG_COUNT - 3);
+        for (size_t i = 0; i < FLAG_COUNT; i++) {
+            flags[i] = !flags[i];
+        }
+        check_index(flags, FLAG_COUNT - 3);
+    }
+}
+
+void test_rank_select_uniform(void) {
+    // Test all-set and all-clear maps, including lengths at block boundaries
+    static bool flags[FLAG_COUNT];
+    size_t lengths[4] = {1, 64, 512, 1024 * 8 + 1};
+    for (size_t l = 0; l < 4; l++) {
+        memset(flags, 1, sizeof(flags));
+        check_index(flags, lengths[l]);
+        memset(flags, 0, sizeof(flags));
+        check_index(flags, lengths[l]);
+    }
+}
+
+void test_rank_select_empty(void) {
+    // Test an index over an empty stream
+    BitStream* stream = bit_stream_new();
+    RankSelectIndex* index = rank_select_index_new(stream);
+    TEST_ASSERT_NOT_NULL(index);
+    TEST_ASSERT_EQUAL_UINT64(0, rank_select_index_ones(index));
+    TEST_ASSERT_EQUAL_UINT64(0, rank_select_index_rank1(index, 10));
+    TEST_ASSERT_EQUAL_size_t(SIZE_MAX, rank_select_index_select1(index, 0));
+    TEST_ASSERT_EQUAL_size_t(SIZE_MAX, rank_select_index_select0(index, 0));
+    rank_select_index_free(index);
+    bit_stream_free(stream);
+}
+
+void test_rank_select_after_rollback(void) {
+    // Test that the index covers only the bits left after a rollback
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0xA5, 8).success);
+    BitStreamCheckpoint checkpoint = bit_stream_checkpoint(stream);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0xFFFF, 16).success);
+    TEST_ASSERT_TRUE(bit_stream_rollback(stream, checkpoint).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x1, 3).success);
+    
+    RankSelectIndex* index = rank_select_index_new(stream);
+    TEST_ASSERT_NOT_NULL(index);
+    TEST_ASSERT_EQUAL_UINT64(5, rank_select_index_ones(index));
+    TEST_ASSERT_EQUAL_size_t(0, rank_select_index_select1(index, 0));
+    TEST_ASSERT_EQUAL_size_t(10, rank_select_index_select1(index, 4));
+    TEST_ASSERT_EQUAL_UINT64(4, rank_select_index_rank1(index, 10));
+    rank_select_index_free(index);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_rank_select_densities);
+    RUN_TEST(test_rank_select_uniform);
+    RUN_TEST(test_rank_select_empty);
+    RUN_TEST(test_rank_select_after_rollback);
+    
+    return UNITY_END();
+}
@@ -1,5 +1,6 @@
 #include "bit_stream.h"
 #include "unity.h"
+#include "test_helpers.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -429,6 +430,276 @@ void test_bit_stream_lsb_order_all_bit_lengths(void) {
     }
 }
 
+// Reference packer for the writer layout: a value is split into chunks least
+// significant first, and each chunk fills the current byte from the top down
+static void reference_writer_pack(uint8_t* buffer, size_t* position, uint64_t value, uint8_t bit_count) {
+    uint8_t bits_written = 0;
+    while (bits_written < bit_count) {
+        uint8_t bit_pos = *position % 8;
+        uint8_t bits_left_in_byte = 8 - bit_pos;
+        uint8_t bits_to_write = (bit_count - bits_written < bits_left_in_byte) ?
+                                (bit_count - bits_written) : bits_left_in_byte;
+        uint8_t chunk = (uint8_t)((value >> bits_written) & ((1U << bits_to_write) - 1));
+        buffer[*position / 8] |= (uint8_t)(chunk << (bits_left_in_byte - bits_to_write));
+        bits_written += bits_to_write;
+        *position += bits_to_write;
+    }
+}
+
+void test_bit_stream_writer_output_matches_reference(void) {
+    // Test that the store-once writer produces identical bytes for every
+    // width and alignment, across buffer sizes that force the flush path
+    size_t capacities[] = {1, 3, 16, 4096};
+    
+    for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+        uint8_t expected[8192];
+        memset(expected, 0, sizeof(expected));
+        size_t position = 0;
+        
+        FILE* file = fopen(TEST_FILE_PATH, "wb");
+        TEST_ASSERT_NOT_NULL(file);
+        BitStreamWriter* writer = bit_stream_writer_with_capacity(file, capacities[c]);
+        TEST_ASSERT_NOT_NULL(writer);
+        
+        uint64_t seed = TEST_RANDOM_SEED;
+        for (int i = 0; i < 1000; i++) {
+            test_next_random(&seed);
+            uint8_t bit_count = (uint8_t)(seed % 64) + 1;
+            uint64_t value = seed * 0xD1B54A32D192ED03ULL;
+            
+            BitStreamResult result = bit_stream_writer_write_bits(writer, value, bit_count);
+            TEST_ASSERT_TRUE(result.success);
+            if (bit_count < 64) {
+                value &= (1ULL << bit_count) - 1;
+            }
+            reference_writer_pack(expected, &position, value, bit_count);
+        }
+        
+        BitStreamResult result = bit_stream_writer_flush(writer);
+        TEST_ASSERT_TRUE(result.success);
+        bit_stream_writer_free(writer);
+        fclose(file);
+        
+        uint8_t actual[8192];
+        file = fopen(TEST_FILE_PATH, "rb");
+        TEST_ASSERT_NOT_NULL(file);
+        size_t bytes_read = fread(actual, 1, sizeof(actual), file);
+        fclose(file);
+        
+        TEST_ASSERT_EQUAL_size_t((position + 7) / 8, bytes_read);
+        TEST_ASSERT_EQUAL_MEMORY(expected, actual, bytes_read);
+    }
+}
+
+void test_bit_stream_writer_checkpoint_rollback(void) {
+    // Test rolling back buffered bits, and refusing once they are flushed
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    BitStreamResult result;
+    
+    result = bit_stream_writer_write_bits(writer, 0b1, 1);
+    TEST_ASSERT_TRUE(result.success);
+    
+    BitStreamCheckpoint checkpoint = bit_stream_writer_checkpoint(writer);
+    
+    result = bit_stream_writer_write_bits(writer, 0x7F, 7);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_write_bits(writer, 0xFFFF, 16);
+    TEST_ASSERT_TRUE(result.success);
+    
+    result = bit_stream_writer_rollback(writer, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    
+    result = bit_stream_writer_write_bits(writer, 0b010, 3);
+    TEST_ASSERT_TRUE(result.success);
+    
+    // Fill past the buffer so the checkpointed byte reaches the file
+    checkpoint = bit_stream_writer_checkpoint(writer);
+    for (int i = 0; i < 4; i++) {
+        result = bit_stream_writer_write_bits(writer, 0, 64);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    
+    result = bit_stream_writer_rollback(writer, checkpoint);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_CHECKPOINT, result.error.code);
+    
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    uint8_t first_byte = 0;
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_size_t(1, fread(&first_byte, 1, 1, file));
+    fclose(file);
+    
+    TEST_ASSERT_EQUAL_UINT8(0b10100000, first_byte);
+}
+
+void test_bit_stream_writer_reserve_and_patch_field(void) {
+    // Test that the writer holds back an open field until it is patched,
+    // even when the payload is larger than the buffer
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    BitStreamResult result;
+    
+    result = bit_stream_writer_write_bits(writer, 0b101, 3);
+    TEST_ASSERT_TRUE(result.success);
+    
+    result = bit_stream_writer_reserve_field(writer, 20);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamField count_field = result.value.field;
+    
+    const int num_values = 50;
+    for (int i = 0; i < num_values; i++) {
+        result = bit_stream_writer_write_bits(writer, (uint64_t)i * 0x01010101ULL, 33);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    
+    // Nothing may reach the file while the field is open
+    TEST_ASSERT_EQUAL_size_t(0, writer->bytes_flushed);
+    
+    result = bit_stream_writer_patch_field(writer, count_field, num_values);
+    TEST_ASSERT_TRUE(result.success);
+    
+    // A closed field cannot be patched again
+    result = bit_stream_writer_patch_field(writer, count_field, 0);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_FIELD, result.error.code);
+    
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(reader);
+    
+    result = bit_stream_reader_read_bits(reader, 3);
+    TEST_ASSERT_EQUAL_UINT64(0b101, result.value.u64);
+    result = bit_stream_reader_read_bits(reader, 20);
+    TEST_ASSERT_EQUAL_UINT64(num_values, result.value.u64);
+    for (int i = 0; i < num_values; i++) {
+        result = bit_stream_reader_read_bits(reader, 33);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(((uint64_t)i * 0x01010101ULL) & ((1ULL << 33) - 1), result.value.u64);
+    }
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+}
+
+void test_bit_stream_writer_rollback_restores_patches(void) {
+    // Test that a rollback reopens a field patched since the checkpoint, and
+    // is refused once the patched bytes have reached the file
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    BitStreamResult result;
+    
+    result = bit_stream_writer_reserve_field(writer, 8);
+    TEST_ASSERT_TRUE(result.success);
+    BitStreamField field = result.value.field;
+    result = bit_stream_writer_write_bits(writer, 0x11, 8);
+    TEST_ASSERT_TRUE(result.success);
+    
+    BitStreamCheckpoint checkpoint = bit_stream_writer_checkpoint(writer);
+    result = bit_stream_writer_patch_field(writer, field, 0xAB);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_rollback(writer, checkpoint);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT8(0x00, writer->buffer[0]);
+    
+    // The field is open again, so it holds back flushing and can be patched
+    for (int i = 0; i < 4; i++) {
+        result = bit_stream_writer_write_bits(writer, 0, 64);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    TEST_ASSERT_EQUAL_size_t(0, writer->bytes_flushed);
+    checkpoint = bit_stream_writer_checkpoint(writer);
+    result = bit_stream_writer_patch_field(writer, field, 0x5A);
+    TEST_ASSERT_TRUE(result.success);
+    
+    // Once the patched byte is flushed the patch cannot be undone
+    for (int i = 0; i < 4; i++) {
+        result = bit_stream_writer_write_bits(writer, 0, 64);
+        TEST_ASSERT_TRUE(result.success);
+    }
+    TEST_ASSERT_TRUE(writer->bytes_flushed > 0);
+    result = bit_stream_writer_rollback(writer, checkpoint);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_CHECKPOINT, result.error.code);
+    
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    uint8_t bytes[2] = {0, 0};
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_size_t(2, fread(bytes, 1, 2, file));
+    fclose(file);
+    
+    TEST_ASSERT_EQUAL_UINT8(0x5A, bytes[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x11, bytes[1]);
+}
+
+void test_bit_stream_reader_writer_signed_bits(void) {
+    // Test signed fields and batches through the file reader and writer
+    int64_t values[64];
+    for (int i = 0; i < 64; i++) {
+        values[i] = (i % 3 == 0) ? -i * 37 : i * 53;
+    }
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamResult result = bit_stream_writer_write_signed_bits(writer, -3, 5);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_write_signed_bits_batch(writer, values, 64, 13);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_write_signed_bits_i128(writer, int128_from_i64(-123456789), 90);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(reader);
+    
+    result = bit_stream_reader_read_signed_bits(reader, 5);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-3, result.value.i64);
+    
+    int64_t decoded[64];
+    result = bit_stream_reader_read_signed_bits_batch(reader, decoded, 64, 13);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    result = bit_stream_reader_read_signed_bits_i128(reader, 90);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-1, result.value.i128.high);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)-123456789, result.value.i128.low);
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+}
+
 int main(void) {
     UNITY_BEGIN();
     
@@ -439,6 +710,11 @@ int main(void) {
     RUN_TEST(test_bit_stream_reader_writer_non_byte_aligned);
     RUN_TEST(test_bit_stream_lsb_order_128bit);
     RUN_TEST(test_bit_stream_lsb_order_all_bit_lengths);
+    RUN_TEST(test_bit_stream_writer_output_matches_reference);
+    RUN_TEST(test_bit_stream_writer_checkpoint_rollback);
+    RUN_TEST(test_bit_stream_writer_reserve_and_patch_field);
+    RUN_TEST(test_bit_stream_writer_rollback_restores_patches);
+    RUN_TEST(test_bit_stream_reader_writer_signed_bits);
     
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_rice.bin"
+
+#define GAP_COUNT 1000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+// Fills gaps with roughly geometric values of the given mean, plus a few
+// large outliers that need the escape
+static void fill_gaps(uint64_t* gaps, size_t count, uint64_t mean) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        uint64_t gap = 0;
+        uint64_t bits = state;
+        while ((bits & 1) == 0 && gap < 20 * mean) {
+            gap += mean / 2 + 1;
+            bits >>= 1;
+        }
+        gaps[i] = gap + (state >> 40) % (mean + 1);
+        if (i % 97 == 13) {
+            gaps[i] = state;
+        }
+    }
+}
+
+void test_rice_select_k(void) {
+    // Test that k tracks the rounded-up mean of the block
+    uint64_t zeros[4] = {0, 0, 0, 1};
+    TEST_ASSERT_EQUAL_UINT8(0, rice_select_k(zeros, 4));
+    
+    uint64_t small[4] = {3, 5, 4, 4};
+    TEST_ASSERT_EQUAL_UINT8(2, rice_select_k(small, 4));
+    
+    uint64_t medium[2] = {1000, 1100};
+    TEST_ASSERT_EQUAL_UINT8(11, rice_select_k(medium, 2));
+    
+    uint64_t huge[2] = {UINT64_MAX, UINT64_MAX};
+    TEST_ASSERT_EQUAL_UINT8(63, rice_select_k(huge, 2));
+    
+    TEST_ASSERT_EQUAL_UINT8(0, rice_select_k(NULL, 0));
+}
+
+void test_rice_bits(void) {
+    // Test the code layout: quotient zeros, a one, then k remainder bits
+    BitStream* stream = bit_stream_new();
+    
+    // 9 with k = 2: 00 1 01
+    TEST_ASSERT_TRUE(bit_stream_write_rice(stream, 9, 2).success);
+    // 0 with k = 0: 1
+    TEST_ASSERT_TRUE(bit_stream_write_rice(stream, 0, 0).success);
+    TEST_ASSERT_EQUAL_size_t(6, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_bits(stream, 6);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(0x0B, result.value.u64);
+    
+    // A quotient past the escape costs a fixed 96 bits
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_write_rice(stream, 1000, 0).success);
+    TEST_ASSERT_EQUAL_size_t(96, bit_stream_length(stream));
+    bit_stream_reset(stream);
+    result = bit_stream_read_rice(stream, 0);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(1000, result.value.u64);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_rice_round_trip(void) {
+    // Test scalar codes for every k, including wide remainders
+    BitStream* stream = bit_stream_new();
+    uint64_t samples[] = {0, 1, 2, 31, 32, 1000, 123456789, UINT64_MAX >> 1, UINT64_MAX};
+    size_t sample_count = sizeof(samples) / sizeof(samples[0]);
+    
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 3, 2).success);
+    for (uint8_t k = 0; k < 64; k++) {
+        for (size_t i = 0; i < sample_count; i++) {
+            TEST_ASSERT_TRUE(bit_stream_write_rice(stream, samples[i], k).success);
+        }
+    }
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(3, bit_stream_read_bits(stream, 2).value.u64);
+    for (uint8_t k = 0; k < 64; k++) {
+        for (size_t i = 0; i < sample_count; i++) {
+            BitStreamResult result = bit_stream_read_rice(stream, k);
+            TEST_ASSERT_TRUE(result.success);
+            TEST_ASSERT_EQUAL_UINT64(samples[i], result.value.u64);
+        }
+    }
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    BitStreamResult result = bit_stream_write_rice(stream, 1, 64);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_BIT_COUNT, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_rice_block(void) {
+    // Test blocks of geometric gaps at several scales, with escapes mixed in
+    static uint64_t gaps[GAP_COUNT];
+    static uint64_t decoded[GAP_COUNT];
+    uint64_t means[] = {1, 12, 300, 70000};
+    
+    for (size_t m = 0; m < sizeof(means) / sizeof(means[0]); m++) {
+        BitStream* stream = bit_stream_new();
+        fill_gaps(gaps, GAP_COUNT, means[m]);
+        
+        TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 1).success);
+        TEST_ASSERT_TRUE(bit_stream_write_rice_block(stream, gaps, GAP_COUNT).success);
+        TEST_ASSERT_TRUE(bit_stream_write_rice_block(stream, gaps, 7).success);
+        
+        bit_stream_reset(stream);
+        TEST_ASSERT_EQUAL_UINT64(1, bit_stream_read_bits(stream, 1).value.u64);
+        TEST_ASSERT_TRUE(bit_stream_read_rice_block(stream, decoded, GAP_COUNT).success);
+        TEST_ASSERT_EQUAL_MEMORY(gaps, decoded, sizeof(gaps));
+        TEST_ASSERT_TRUE(bit_stream_read_rice_block(stream, decoded, 7).success);
+        TEST_ASSERT_EQUAL_MEMORY(gaps, decoded, 7 * sizeof(uint64_t));
+        TEST_ASSERT_EQUAL_size_t(bit_stream_length(stream), bit_stream_position(stream));
+        
+        // Reading past the last block reports the end of the stream
+        BitStreamResult result = bit_stream_read_rice_block(stream, decoded, 1);
+        TEST_ASSERT_FALSE(result.success);
+        TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+        
+        bit_stream_free(stream);
+    }
+}
+
+void test_bit_stream_reader_writer_rice(void) {
+    // Test that the file writer emits the same bytes as BitStream and that
+    // the reader decodes them across small buffer refills
+    static uint64_t gaps[GAP_COUNT];
+    static uint64_t decoded[GAP_COUNT];
+    fill_gaps(gaps, GAP_COUNT, 40);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_rice(stream, 77, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_rice_block(stream, gaps, GAP_COUNT).success);
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_rice(writer, 77, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_rice_block(writer, gaps, GAP_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    static uint8_t bytes[16384];
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_size_t((bit_stream_length(stream) + 7) / 8, size);
+    TEST_ASSERT_EQUAL_MEMORY(stream->buffer, bytes, size);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 5);
+    TEST_ASSERT_NOT_NULL(reader);
+    
+    BitStreamResult result = bit_stream_reader_read_rice(reader, 3);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(77, result.value.u64);
+    TEST_ASSERT_TRUE(bit_stream_reader_read_rice_block(reader, decoded, GAP_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(gaps, decoded, sizeof(gaps));
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_rice_select_k);
+    RUN_TEST(test_rice_bits);
+    RUN_TEST(test_bit_stream_rice_round_trip);
+    RUN_TEST(test_bit_stream_rice_block);
+    RUN_TEST(test_bit_stream_reader_writer_rice);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define VALUE_COUNT 3000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values like definition levels and dictionary indices: runs of a
+// repeated value mixed with stretches of random values below 2^bit_width
+static void fill_levels(uint32_t* values, size_t count, uint8_t bit_width) {
+    uint64_t state = TEST_RANDOM_SEED;
+    uint32_t mask = (bit_width == 32) ? 0xFFFFFFFFU : (1U << bit_width) - 1;
+    size_t i = 0;
+    while (i < count) {
+        test_next_random(&state);
+        size_t length = 1 + state % 40;
+        bool repeat = (state >> 40) & 1;
+        for (size_t k = 0; k < length && i < count; k++, i++) {
+            if (!repeat) {
+                test_next_random(&state);
+            }
+            values[i] = (uint32_t)(state >> 20) & mask;
+        }
+    }
+}
+
+void test_rle_hybrid_parquet_bytes(void) {
+    // The bit-packed example from the Parquet encodings spec: 0..7 at 3 bits
+    uint32_t values[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t bytes[32];
+    const uint8_t packed[] = {0x03, 0x88, 0xC6, 0xFA};
+    TEST_ASSERT_EQUAL_size_t(sizeof(packed), rle_hybrid_encode(values, 8, 3, bytes));
+    TEST_ASSERT_EQUAL_MEMORY(packed, bytes, sizeof(packed));
+    
+    // 100 copies of 5 as one RLE run
+    uint32_t repeated[100];
+    for (size_t i = 0; i < 100; i++) {
+        repeated[i] = 5;
+    }
+    const uint8_t run[] = {0xC8, 0x01, 0x05};
+    TEST_ASSERT_EQUAL_size_t(sizeof(run), rle_hybrid_encode(repeated, 100, 3, bytes));
+    TEST_ASSERT_EQUAL_MEMORY(run, bytes, sizeof(run));
+    
+    uint32_t decoded[100];
+    TEST_ASSERT_EQUAL_size_t(sizeof(run), rle_hybrid_decode(run, sizeof(run), 3, decoded, 100));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(repeated, decoded, 100);
+    
+    // A run longer than the values asked for or a cut-off group is refused
+    TEST_ASSERT_EQUAL_size_t(0, rle_hybrid_decode(run, sizeof(run), 3, decoded, 99));
+    TEST_ASSERT_EQUAL_size_t(0, rle_hybrid_decode(packed, 3, 3, decoded, 8));
+}
+
+void test_rle_hybrid_round_trip(void) {
+    // Test every width, with a count that leaves a partial final group
+    static uint32_t values[VALUE_COUNT];
+    static uint32_t decoded[VALUE_COUNT];
+    static uint8_t bytes[VALUE_COUNT * 8];
+    for (uint8_t bit_width = 0; bit_width <= 32; bit_width++) {
+        fill_levels(values, VALUE_COUNT - 3, bit_width);
+        size_t length = rle_hybrid_encode(values, VALUE_COUNT - 3, bit_width, bytes);
+        TEST_ASSERT_TRUE(length <= rle_hybrid_max_encoded_length(VALUE_COUNT - 3, bit_width));
+        TEST_ASSERT_EQUAL_size_t(length, rle_hybrid_decode(bytes, length, bit_width, decoded, VALUE_COUNT - 3));
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(values, decoded, VALUE_COUNT - 3);
+    }
+}
+
+void test_bit_stream_rle_hybrid(void) {
+    // Test the stream form after an unaligned field
+    static uint32_t values[VALUE_COUNT];
+    static uint32_t decoded[VALUE_COUNT];
+    fill_levels(values, VALUE_COUNT, 2);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_rle_hybrid(stream, values, VALUE_COUNT, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    TEST_ASSERT_TRUE(bit_stream_length(stream) < VALUE_COUNT * 2);
+    
+    uint32_t wide = 4;
+    BitStreamResult result = bit_stream_write_rle_hybrid(stream, &wide, 1, 2);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    result = bit_stream_write_rle_hybrid(stream, &wide, 1, 33);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_BIT_COUNT, result.error.code);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_rle_hybrid(stream, decoded, VALUE_COUNT, 2).success);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(values, decoded, VALUE_COUNT);
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    
+    result = bit_stream_read_rle_hybrid(stream, decoded, 1, 2);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_rle_hybrid_read_leaves_stream_unchanged(void) {
+    // Test that a failed read from inside the last byte keeps the length and
+    // the position instead of aligning past the end
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, 3).success);
+    
+    uint32_t decoded[1];
+    BitStreamResult result = bit_stream_read_rle_hybrid(stream, decoded, 1, 4);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_position(stream));
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_rle_hybrid_parquet_bytes);
+    RUN_TEST(test_rle_hybrid_round_trip);
+    RUN_TEST(test_bit_stream_rle_hybrid);
+    RUN_TEST(test_rle_hybrid_read_leaves_stream_unchanged);
+    
+    return UNITY_END();
+}
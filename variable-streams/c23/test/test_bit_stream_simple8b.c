@@ -0,0 +1,121 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#define VALUE_COUNT 2000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with runs of very different magnitudes, including zero runs
+static void fill_values(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        unsigned width = (unsigned)((i / 37) % 61);
+        values[i] = (width == 0) ? 0 : state & ((1ULL << width) - 1);
+    }
+}
+
+void test_simple8b_word(void) {
+    // Test the selector choice and layout of single words
+    uint64_t values[SIMPLE8B_MAX_WORD_VALUES];
+    uint64_t unpacked[SIMPLE8B_MAX_WORD_VALUES];
+    uint64_t word;
+    
+    memset(values, 0, sizeof(values));
+    TEST_ASSERT_EQUAL_size_t(240, simple8b_pack_word(values, 240, &word));
+    TEST_ASSERT_EQUAL_UINT64(0, word);
+    TEST_ASSERT_EQUAL_size_t(120, simple8b_pack_word(values, 200, &word));
+    TEST_ASSERT_EQUAL_UINT64(1ULL << 60, word);
+    
+    // Seven 8-bit values, then a 9-bit one that forces 10 bits for six
+    for (size_t i = 0; i < 8; i++) {
+        values[i] = 200 + i;
+    }
+    TEST_ASSERT_EQUAL_size_t(7, simple8b_pack_word(values, 7, &word));
+    TEST_ASSERT_EQUAL_UINT64(9, word >> 60);
+    TEST_ASSERT_EQUAL_UINT64(200, word & 0xFF);
+    values[5] = 300;
+    TEST_ASSERT_EQUAL_size_t(6, simple8b_pack_word(values, 8, &word));
+    TEST_ASSERT_EQUAL_UINT64(10, word >> 60);
+    TEST_ASSERT_EQUAL_size_t(6, simple8b_unpack_word(word, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(values, unpacked, 6 * sizeof(uint64_t));
+    
+    // Too few values left for a wider selector
+    TEST_ASSERT_EQUAL_size_t(3, simple8b_pack_word(values, 3, &word));
+    TEST_ASSERT_EQUAL_UINT64(13, word >> 60);
+    
+    values[0] = 1ULL << 60;
+    TEST_ASSERT_EQUAL_size_t(0, simple8b_pack_word(values, 1, &word));
+}
+
+void test_bit_stream_simple8b(void) {
+    // Test a column of mixed magnitudes after unaligned bit fields
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    fill_values(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_simple8b(stream, values, VALUE_COUNT).success);
+    // One padded byte for the bit field, then whole words
+    TEST_ASSERT_EQUAL_size_t(8, bit_stream_length(stream) % 64);
+    TEST_ASSERT_TRUE(bit_stream_write_simple8b(stream, values, 1).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(5, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_simple8b(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_simple8b(stream, decoded, 1).success);
+    TEST_ASSERT_EQUAL_UINT64(values[0], decoded[0]);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    BitStreamResult result = bit_stream_read_simple8b(stream, decoded, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    // Values of 60 bits or more cannot be packed
+    values[10] = UINT64_MAX;
+    result = bit_stream_write_simple8b(stream, values, 20);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_simple8b_read_leaves_stream_unchanged(void) {
+    // Test that a failed read from inside the last byte keeps the length and
+    // the position instead of aligning past the end
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, 3).success);
+    
+    uint64_t decoded[1];
+    BitStreamResult result = bit_stream_read_simple8b(stream, decoded, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_position(stream));
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_simple8b_word);
+    RUN_TEST(test_bit_stream_simple8b);
+    RUN_TEST(test_simple8b_read_leaves_stream_unchanged);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,250 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_tans.bin"
+
+#define SYMBOL_COUNT 5000
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+// Fills symbols with a small skewed alphabet: 0 about 90% of the time, the
+// other three symbols sharing the rest
+static void fill_events(uint8_t* symbols, size_t count, uint64_t* histogram) {
+    uint64_t state = TEST_RANDOM_SEED;
+    memset(histogram, 0, 4 * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        uint8_t symbol = (state % 10 != 0) ? 0 : (uint8_t)(1 + (state >> 32) % 3);
+        symbols[i] = symbol;
+        histogram[symbol]++;
+    }
+}
+
+void test_bit_stream_read_bits_backward(void) {
+    // Test that fields come back last to first
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x123456789ABCDEF0ULL, 64).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, bit_stream_length(stream)).success);
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits_backward(stream, 7).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0x123456789ABCDEF0ULL, bit_stream_read_bits_backward(stream, 64).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits_backward(stream, 3).value.u64);
+    TEST_ASSERT_EQUAL_size_t(0, bit_stream_position(stream));
+    
+    BitStreamResult result = bit_stream_read_bits_backward(stream, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reader_read_bits_backward(void) {
+    // Test backward reads across small buffer refills
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    for (uint64_t i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(bit_stream_writer_write_bits_msb(writer, i * TEST_RANDOM_SEED >> (i % 50), (uint8_t)(64 - i % 50)).success);
+    }
+    TEST_ASSERT_TRUE(bit_stream_writer_write_bits_msb(writer, 1, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 3);
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_TRUE(bit_stream_reader_seek_end(reader).success);
+    
+    // Padding after the final 1 bit reads as zeros
+    while (bit_stream_reader_read_bits_backward(reader, 1).value.u64 == 0) {
+    }
+    for (uint64_t i = 100; i-- > 0;) {
+        BitStreamResult result = bit_stream_reader_read_bits_backward(reader, (uint8_t)(64 - i % 50));
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(i * TEST_RANDOM_SEED >> (i % 50), result.value.u64);
+    }
+    BitStreamResult result = bit_stream_reader_read_bits_backward(reader, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+}
+
+void test_tans_normalized_counts(void) {
+    // Test that counts fill the table and keep rare symbols representable
+    uint64_t histogram[5] = {1000000, 1, 0, 30, 5000};
+    TansCode* code = tans_code_from_histogram(histogram, 5, 8);
+    TEST_ASSERT_NOT_NULL(code);
+    uint32_t sum = 0;
+    for (uint8_t s = 0; s < 5; s++) {
+        sum += tans_code_normalized_count(code, s);
+    }
+    TEST_ASSERT_EQUAL_UINT32(256, sum);
+    TEST_ASSERT_EQUAL_UINT16(1, tans_code_normalized_count(code, 1));
+    TEST_ASSERT_EQUAL_UINT16(0, tans_code_normalized_count(code, 2));
+    TEST_ASSERT_TRUE(tans_code_normalized_count(code, 0) > 240);
+    tans_code_free(code);
+    
+    // Table sizes outside the supported range and empty histograms fail
+    TEST_ASSERT_NULL(tans_code_from_histogram(histogram, 5, TANS_MIN_TABLE_LOG - 1));
+    TEST_ASSERT_NULL(tans_code_from_histogram(histogram, 5, TANS_MAX_TABLE_LOG + 1));
+    uint64_t empty[3] = {0, 0, 0};
+    TEST_ASSERT_NULL(tans_code_from_histogram(empty, 3, 8));
+}
+
+void test_bit_stream_tans(void) {
+    // Test a fractional-bit round trip: Huffman needs at least one bit per
+    // symbol here, tANS gets close to the entropy of about 0.6 bits
+    static uint8_t symbols[SYMBOL_COUNT];
+    static uint8_t decoded[SYMBOL_COUNT];
+    uint64_t histogram[4];
+    fill_events(symbols, SYMBOL_COUNT, histogram);
+    TansCode* code = tans_code_from_histogram(histogram, 4, 10);
+    TEST_ASSERT_NOT_NULL(code);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_tans_table(stream, code).success);
+    size_t header_bits = bit_stream_length(stream);
+    TEST_ASSERT_TRUE(bit_stream_write_tans(stream, code, symbols, SYMBOL_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_length(stream) - header_bits < SYMBOL_COUNT * 7 / 10);
+    
+    bit_stream_reset(stream);
+    TansCode* read_code = NULL;
+    TEST_ASSERT_TRUE(bit_stream_read_tans_table(stream, &read_code).success);
+    TEST_ASSERT_EQUAL_size_t(header_bits, bit_stream_position(stream));
+    for (uint8_t s = 0; s < 4; s++) {
+        TEST_ASSERT_EQUAL_UINT16(tans_code_normalized_count(code, s), tans_code_normalized_count(read_code, s));
+    }
+    
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, bit_stream_length(stream)).success);
+    TEST_ASSERT_TRUE(bit_stream_read_tans(stream, read_code, decoded, SYMBOL_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(symbols, decoded, sizeof(symbols));
+    TEST_ASSERT_EQUAL_size_t(header_bits, bit_stream_position(stream));
+    
+    uint8_t unknown = 7;
+    BitStreamResult result = bit_stream_write_tans(stream, code, &unknown, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    tans_code_free(read_code);
+    tans_code_free(code);
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_tans_single_symbol(void) {
+    // Test that a certain symbol costs no bits beyond the final states
+    uint8_t symbols[1000];
+    uint8_t decoded[1000];
+    memset(symbols, 3, sizeof(symbols));
+    uint64_t histogram[4] = {0, 0, 0, 1000};
+    TansCode* code = tans_code_from_histogram(histogram, 4, TANS_MIN_TABLE_LOG);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_tans(stream, code, symbols, sizeof(symbols)).success);
+    TEST_ASSERT_EQUAL_size_t(2 * TANS_MIN_TABLE_LOG + 1, bit_stream_length(stream));
+    
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, bit_stream_length(stream)).success);
+    TEST_ASSERT_TRUE(bit_stream_read_tans(stream, code, decoded, sizeof(decoded)).success);
+    TEST_ASSERT_EQUAL_MEMORY(symbols, decoded, sizeof(symbols));
+    
+    tans_code_free(code);
+    bit_stream_free(stream);
+}
+
+void test_tans_table_rejects_bad_counts(void) {
+    // Test that counts which do not fill the table are refused
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 5, 4).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 2, 9).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 10, 6).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 3, 5).success);
+    
+    bit_stream_reset(stream);
+    TansCode* code = NULL;
+    BitStreamResult result = bit_stream_read_tans_table(stream, &code);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    TEST_ASSERT_NULL(code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reader_writer_tans(void) {
+    // Test that the file writer emits the same bytes as BitStream and that
+    // the reader decodes them from the end of the file
+    static uint8_t symbols[SYMBOL_COUNT];
+    static uint8_t decoded[SYMBOL_COUNT];
+    uint64_t histogram[4];
+    fill_events(symbols, SYMBOL_COUNT, histogram);
+    TansCode* code = tans_code_from_histogram(histogram, 4, 11);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_tans_table(stream, code).success);
+    TEST_ASSERT_TRUE(bit_stream_write_tans(stream, code, symbols, SYMBOL_COUNT).success);
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_tans_table(writer, code).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_tans(writer, code, symbols, SYMBOL_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    static uint8_t bytes[SYMBOL_COUNT];
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_size_t((bit_stream_length(stream) + 7) / 8, size);
+    TEST_ASSERT_EQUAL_MEMORY(stream->buffer, bytes, size);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 5);
+    TEST_ASSERT_NOT_NULL(reader);
+    TansCode* read_code = NULL;
+    TEST_ASSERT_TRUE(bit_stream_reader_read_tans_table(reader, &read_code).success);
+    TEST_ASSERT_TRUE(bit_stream_reader_seek_end(reader).success);
+    TEST_ASSERT_TRUE(bit_stream_reader_read_tans(reader, read_code, decoded, SYMBOL_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(symbols, decoded, sizeof(symbols));
+    
+    tans_code_free(read_code);
+    bit_stream_reader_free(reader);
+    fclose(file);
+    tans_code_free(code);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_bit_stream_read_bits_backward);
+    RUN_TEST(test_bit_stream_reader_read_bits_backward);
+    RUN_TEST(test_tans_normalized_counts);
+    RUN_TEST(test_bit_stream_tans);
+    RUN_TEST(test_bit_stream_tans_single_symbol);
+    RUN_TEST(test_tans_table_rejects_bad_counts);
+    RUN_TEST(test_bit_stream_reader_writer_tans);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_universal.bin"
+
+#define VALUE_COUNT 400
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+// Fills values with a spread of magnitudes, from 1 up to the full 64 bits
+static void fill_values(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        unsigned width = (unsigned)(i % 64) + 1;
+        uint64_t value = (width == 64) ? state : state & ((1ULL << width) - 1);
+        values[i] = value | 1;
+    }
+}
+
+void test_elias_gamma_bits(void) {
+    // Test the code layout: N zeros followed by the N+1 bits of the value
+    BitStream* stream = bit_stream_new();
+    
+    TEST_ASSERT_TRUE(bit_stream_write_elias_gamma(stream, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_write_elias_gamma(stream, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_elias_gamma(stream, 5).success);
+    TEST_ASSERT_EQUAL_size_t(1 + 3 + 5, bit_stream_length(stream));
+    
+    // 1 | 010 | 00101
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_bits(stream, 9);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(0x145, result.value.u64);
+    
+    result = bit_stream_write_elias_gamma(stream, 0);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_exp_golomb_bits(void) {
+    // Test that order k keeps k low bits out of the prefix
+    BitStream* stream = bit_stream_new();
+    
+    // Order 0: 0 -> 1, 3 -> 00100
+    TEST_ASSERT_TRUE(bit_stream_write_exp_golomb(stream, 0, 0).success);
+    TEST_ASSERT_TRUE(bit_stream_write_exp_golomb(stream, 3, 0).success);
+    // Order 2: 3 -> 111, 4 -> 01000
+    TEST_ASSERT_TRUE(bit_stream_write_exp_golomb(stream, 3, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_exp_golomb(stream, 4, 2).success);
+    TEST_ASSERT_EQUAL_size_t(1 + 5 + 3 + 5, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_bits(stream, 14);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(0x24E8, result.value.u64);
+    
+    result = bit_stream_write_exp_golomb(stream, UINT64_MAX, 1);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_universal_round_trip(void) {
+    // Test every code across widths that take both decode paths
+    BitStream* stream = bit_stream_new();
+    uint64_t values[VALUE_COUNT];
+    uint64_t decoded[VALUE_COUNT];
+    fill_values(values, VALUE_COUNT);
+    
+    // Start unaligned so codes straddle bytes differently
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 5, 3).success);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        TEST_ASSERT_TRUE(bit_stream_write_elias_gamma(stream, values[i]).success);
+        TEST_ASSERT_TRUE(bit_stream_write_elias_delta(stream, values[i]).success);
+        TEST_ASSERT_TRUE(bit_stream_write_exp_golomb(stream, values[i] >> 3, 3).success);
+    }
+    TEST_ASSERT_TRUE(bit_stream_write_elias_gamma_batch(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_elias_delta_batch(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_exp_golomb_batch(stream, values, VALUE_COUNT, 0).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(5, bit_stream_read_bits(stream, 3).value.u64);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        BitStreamResult result = bit_stream_read_elias_gamma(stream);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(values[i], result.value.u64);
+        result = bit_stream_read_elias_delta(stream);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(values[i], result.value.u64);
+        result = bit_stream_read_exp_golomb(stream, 3);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(values[i] >> 3, result.value.u64);
+    }
+    TEST_ASSERT_TRUE(bit_stream_read_elias_gamma_batch(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_elias_delta_batch(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_read_exp_golomb_batch(stream, decoded, VALUE_COUNT, 0).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    TEST_ASSERT_EQUAL_size_t(bit_stream_length(stream), bit_stream_position(stream));
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_universal_truncated(void) {
+    // Test that a code cut short by the end of the stream is reported
+    BitStream* stream = bit_stream_new();
+    
+    // The prefix of gamma(1000) without its value bits
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 9).success);
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_elias_gamma(stream);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    // A zero run too long for any 64-bit value
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 64).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 8).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 1).success);
+    bit_stream_reset(stream);
+    result = bit_stream_read_elias_gamma(stream);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reader_writer_universal(void) {
+    // Test that the file writer emits the same bytes as BitStream and that
+    // the reader decodes them across small buffer refills
+    uint64_t values[VALUE_COUNT];
+    uint64_t decoded[VALUE_COUNT];
+    fill_values(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_write_elias_gamma_batch(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_elias_delta_batch(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_exp_golomb_batch(stream, values, VALUE_COUNT, 5).success);
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    TEST_ASSERT_TRUE(bit_stream_writer_write_bits_msb(writer, 1, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_elias_gamma_batch(writer, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_elias_delta_batch(writer, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_exp_golomb_batch(writer, values, VALUE_COUNT, 5).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    static uint8_t bytes[16384];
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_size_t((bit_stream_length(stream) + 7) / 8, size);
+    TEST_ASSERT_EQUAL_MEMORY(stream->buffer, bytes, size);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 3);
+    TEST_ASSERT_NOT_NULL(reader);
+    
+    BitStreamResult result = bit_stream_reader_read_bits_msb(reader, 1);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(1, result.value.u64);
+    
+    for (size_t i = 0; i < 10; i++) {
+        result = bit_stream_reader_read_elias_gamma(reader);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(values[i], result.value.u64);
+    }
+    TEST_ASSERT_TRUE(bit_stream_reader_read_elias_gamma_batch(reader, decoded + 10, VALUE_COUNT - 10).success);
+    TEST_ASSERT_EQUAL_MEMORY(values + 10, decoded + 10, sizeof(values) - 10 * sizeof(uint64_t));
+    
+    TEST_ASSERT_TRUE(bit_stream_reader_read_elias_delta_batch(reader, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_reader_read_exp_golomb_batch(reader, decoded, VALUE_COUNT, 5).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    result = bit_stream_reader_read_elias_gamma(reader);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_elias_gamma_bits);
+    RUN_TEST(test_exp_golomb_bits);
+    RUN_TEST(test_bit_stream_universal_round_trip);
+    RUN_TEST(test_bit_stream_universal_truncated);
+    RUN_TEST(test_bit_stream_reader_writer_universal);
+    
+    return UNITY_END();
+}
@@ -0,0 +1,218 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+#define VALUE_COUNT 1003
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with a spread of byte lengths
+static void fill_values(uint64_t* values, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        unsigned width = (unsigned)(state % 64) + 1;
+        values[i] = (width == 64) ? state : (state >> 7) & ((1ULL << width) - 1);
+    }
+}
+
+void test_leb128_bytes(void) {
+    // Test the protobuf encodings of a few well-known values
+    uint8_t bytes[LEB128_MAX_BYTES];
+    uint64_t value;
+    
+    TEST_ASSERT_EQUAL_size_t(1, leb128_encode_u64(0, bytes));
+    TEST_ASSERT_EQUAL_HEX8(0x00, bytes[0]);
+    
+    TEST_ASSERT_EQUAL_size_t(2, leb128_encode_u64(300, bytes));
+    TEST_ASSERT_EQUAL_HEX8(0xAC, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, bytes[1]);
+    TEST_ASSERT_EQUAL_size_t(2, leb128_decode_u64(bytes, 2, &value));
+    TEST_ASSERT_EQUAL_UINT64(300, value);
+    
+    TEST_ASSERT_EQUAL_size_t(10, leb128_encode_u64(UINT64_MAX, bytes));
+    TEST_ASSERT_EQUAL_HEX8(0x01, bytes[9]);
+    TEST_ASSERT_EQUAL_size_t(10, leb128_decode_u64(bytes, 10, &value));
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, value);
+    
+    // Truncated, and a tenth byte that overflows 64 bits
+    TEST_ASSERT_EQUAL_size_t(0, leb128_decode_u64(bytes, 9, &value));
+    bytes[9] = 0x02;
+    TEST_ASSERT_EQUAL_size_t(0, leb128_decode_u64(bytes, 10, &value));
+}
+
+void test_bit_stream_varint(void) {
+    // Test that varints start on a byte boundary after bit fields
+    BitStream* stream = bit_stream_new();
+    
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_varint(stream, 300).success);
+    TEST_ASSERT_TRUE(bit_stream_write_varint_signed(stream, -2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 1).success);
+    TEST_ASSERT_TRUE(bit_stream_write_varint(stream, 1).success);
+    TEST_ASSERT_EQUAL_size_t(8 * 6, bit_stream_length(stream));
+    
+    uint8_t expected[] = {0xA0, 0xAC, 0x02, 0x03, 0x80, 0x01};
+    TEST_ASSERT_EQUAL_MEMORY(expected, stream->buffer, sizeof(expected));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(5, bit_stream_read_bits(stream, 3).value.u64);
+    BitStreamResult result = bit_stream_read_varint(stream);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(300, result.value.u64);
+    result = bit_stream_read_varint_signed(stream);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-2, result.value.i64);
+    TEST_ASSERT_EQUAL_UINT64(1, bit_stream_read_bits(stream, 1).value.u64);
+    result = bit_stream_read_varint(stream);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_UINT64(1, result.value.u64);
+    
+    result = bit_stream_read_varint(stream);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_varint_batch(void) {
+    // Test the word-at-a-time batch decode against the scalar one
+    static uint64_t values[VALUE_COUNT];
+    static uint64_t decoded[VALUE_COUNT];
+    fill_values(values, VALUE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_varint_batch(stream, values, VALUE_COUNT).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_varint_batch(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    bit_stream_reset(stream);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        BitStreamResult result = bit_stream_read_varint(stream);
+        TEST_ASSERT_TRUE(result.success);
+        TEST_ASSERT_EQUAL_UINT64(values[i], result.value.u64);
+    }
+    
+    // A stream cut inside its last varint
+    BitStreamCheckpoint checkpoint = bit_stream_checkpoint(stream);
+    checkpoint.bit_length -= 8;
+    checkpoint.bit_position = 0;
+    TEST_ASSERT_TRUE(bit_stream_rollback(stream, checkpoint).success);
+    BitStreamResult result = bit_stream_read_varint_batch(stream, decoded, VALUE_COUNT);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    
+    bit_stream_free(stream);
+}
+
+void test_varint_read_leaves_stream_unchanged(void) {
+    // Test that aligning to read never grows the stream: a failed read from
+    // inside the last byte keeps the length and the position
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, 3).success);
+    
+    BitStreamResult result = bit_stream_read_varint(stream);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    uint64_t values[1];
+    uint32_t small[1];
+    result = bit_stream_read_varint_batch(stream, values, 1);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    result = bit_stream_read_stream_vbyte(stream, small, 1);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_length(stream));
+    TEST_ASSERT_EQUAL_size_t(3, bit_stream_position(stream));
+    
+    // Inside the stream the read alignment skips the rest of the byte
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x7F, 13).success);
+    TEST_ASSERT_TRUE(bit_stream_set_position(stream, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_align_read(stream).success);
+    TEST_ASSERT_EQUAL_size_t(8, bit_stream_position(stream));
+    TEST_ASSERT_EQUAL_UINT64(0x7F, bit_stream_read_varint(stream).value.u64);
+    TEST_ASSERT_EQUAL_size_t(16, bit_stream_length(stream));
+    
+    bit_stream_free(stream);
+}
+
+void test_stream_vbyte_layout(void) {
+    // Test the control byte and data layout of one group
+    uint32_t values[5] = {1, 0x100, 0x10000, 0x1000000, 7};
+    uint8_t bytes[32];
+    
+    size_t length = stream_vbyte_encode(values, 5, bytes);
+    TEST_ASSERT_EQUAL_size_t(2 + 1 + 2 + 3 + 4 + 1, length);
+    TEST_ASSERT_EQUAL_HEX8(0xE4, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, bytes[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, bytes[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x07, bytes[length - 1]);
+    
+    uint32_t decoded[5];
+    TEST_ASSERT_EQUAL_size_t(length, stream_vbyte_decode(bytes, length, decoded, 5));
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    // Too short for the data the control bytes announce
+    TEST_ASSERT_EQUAL_size_t(0, stream_vbyte_decode(bytes, length - 1, decoded, 5));
+}
+
+void test_stream_vbyte_round_trip(void) {
+    // Test the vector kernels, exact-length buffers and odd tails
+    static uint32_t values[VALUE_COUNT];
+    static uint32_t decoded[VALUE_COUNT];
+    static uint8_t bytes[VALUE_COUNT * 5];
+    uint64_t wide[VALUE_COUNT];
+    fill_values(wide, VALUE_COUNT);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        values[i] = (uint32_t)(wide[i] >> (wide[i] % 32));
+    }
+    
+    size_t counts[] = {0, 1, 4, 7, 8, 33, VALUE_COUNT};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t count = counts[c];
+        size_t length = stream_vbyte_encode(values, count, bytes);
+        TEST_ASSERT_TRUE(length <= stream_vbyte_max_encoded_length(count));
+        memset(decoded, 0xAA, sizeof(decoded));
+        TEST_ASSERT_EQUAL_size_t(length, stream_vbyte_decode(bytes, length, decoded, count));
+        TEST_ASSERT_EQUAL_MEMORY(values, decoded, count * sizeof(uint32_t));
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 1, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_stream_vbyte(stream, values, VALUE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_varint(stream, 99).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(1, bit_stream_read_bits(stream, 2).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_stream_vbyte(stream, decoded, VALUE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_EQUAL_UINT64(99, bit_stream_read_varint(stream).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_leb128_bytes);
+    RUN_TEST(test_bit_stream_varint);
+    RUN_TEST(test_bit_stream_varint_batch);
+    RUN_TEST(test_varint_read_leaves_stream_unchanged);
+    RUN_TEST(test_stream_vbyte_layout);
+    RUN_TEST(test_stream_vbyte_round_trip);
+    
+    return UNITY_END();
+}
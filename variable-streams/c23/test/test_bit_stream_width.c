@@ -0,0 +1,125 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define VALUE_COUNT 1003
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+}
+
+// Fills values with pseudo-random values below 2^bits
+static void fill_below(uint64_t* values, size_t count, unsigned bits) {
+    uint64_t state = TEST_RANDOM_SEED;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        values[i] = (bits == 64) ? state : state & ((1ULL << bits) - 1);
+    }
+}
+
+void test_bit_width_required_unsigned(void) {
+    // Test widths from values placed in the vector body and the scalar tail
+    static uint64_t values[VALUE_COUNT];
+    static uint32_t narrow[VALUE_COUNT];
+    fill_below(values, VALUE_COUNT, 12);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        values[i] &= 0x7FF;
+        narrow[i] = (uint32_t)values[i];
+    }
+    TEST_ASSERT_EQUAL_UINT8(11, bit_width_required_u64(values, VALUE_COUNT));
+    TEST_ASSERT_EQUAL_UINT8(11, bit_width_required_u32(narrow, VALUE_COUNT));
+    
+    values[500] = 1ULL << 40;
+    narrow[VALUE_COUNT - 1] = 1U << 31;
+    TEST_ASSERT_EQUAL_UINT8(41, bit_width_required_u64(values, VALUE_COUNT));
+    TEST_ASSERT_EQUAL_UINT8(32, bit_width_required_u32(narrow, VALUE_COUNT));
+    values[VALUE_COUNT - 1] = UINT64_MAX;
+    TEST_ASSERT_EQUAL_UINT8(64, bit_width_required_u64(values, VALUE_COUNT));
+    
+    // All zero or empty columns still need one bit
+    memset(values, 0, sizeof(values));
+    TEST_ASSERT_EQUAL_UINT8(1, bit_width_required_u64(values, VALUE_COUNT));
+    TEST_ASSERT_EQUAL_UINT8(1, bit_width_required_u32(narrow, 0));
+}
+
+void test_bit_width_required_signed(void) {
+    // Test the two's complement range edges of each width
+    int64_t values[9] = {0, 3, -4, 1, -1, 2, 0, -3, 1};
+    TEST_ASSERT_EQUAL_UINT8(3, bit_width_required_i64(values, 9));
+    values[8] = 4;
+    TEST_ASSERT_EQUAL_UINT8(4, bit_width_required_i64(values, 9));
+    values[2] = -9;
+    TEST_ASSERT_EQUAL_UINT8(5, bit_width_required_i64(values, 9));
+    values[1] = INT64_MIN;
+    TEST_ASSERT_EQUAL_UINT8(64, bit_width_required_i64(values, 9));
+    
+    int64_t minus_one[5] = {-1, -1, -1, -1, -1};
+    TEST_ASSERT_EQUAL_UINT8(1, bit_width_required_i64(minus_one, 5));
+    TEST_ASSERT_EQUAL_UINT8(1, bit_width_required_i64(minus_one, 0));
+    
+    int32_t narrow[11] = {0, 0, 0, 0, 0, 0, 0, 0, -128, 127, 5};
+    TEST_ASSERT_EQUAL_UINT8(8, bit_width_required_i32(narrow, 11));
+    narrow[3] = -129;
+    TEST_ASSERT_EQUAL_UINT8(9, bit_width_required_i32(narrow, 11));
+    narrow[10] = INT32_MAX;
+    TEST_ASSERT_EQUAL_UINT8(32, bit_width_required_i32(narrow, 11));
+}
+
+void test_bit_width_required_128(void) {
+    // Test 128-bit columns, with the widest value in either half
+    UInt128 values[5] = {
+        uint128_from_parts(0, 7), uint128_from_parts(0, 1ULL << 50), uint128_from_parts(0, 0),
+        uint128_from_parts(0, 3), uint128_from_parts(0, 9)
+    };
+    TEST_ASSERT_EQUAL_UINT8(51, bit_width_required_u128(values, 5));
+    values[4] = uint128_from_parts(0x1F, 0);
+    TEST_ASSERT_EQUAL_UINT8(69, bit_width_required_u128(values, 5));
+    
+    Int128 signed_values[5] = {
+        int128_from_i64(-5), int128_from_i64(100), int128_from_i64(0),
+        int128_from_i64(-1), int128_from_i64(3)
+    };
+    TEST_ASSERT_EQUAL_UINT8(8, bit_width_required_i128(signed_values, 5));
+    signed_values[1] = int128_from_parts(-2, 0);
+    TEST_ASSERT_EQUAL_UINT8(66, bit_width_required_i128(signed_values, 5));
+    signed_values[4] = int128_from_parts(INT64_MAX, UINT64_MAX);
+    TEST_ASSERT_EQUAL_UINT8(128, bit_width_required_i128(signed_values, 5));
+}
+
+void test_bit_width_required_feeds_batch(void) {
+    // Test that the width round trips a signed column through the batch API
+    static int64_t values[VALUE_COUNT];
+    static int64_t decoded[VALUE_COUNT];
+    fill_below((uint64_t*)values, VALUE_COUNT, 20);
+    for (size_t i = 0; i < VALUE_COUNT; i++) {
+        values[i] -= 1 << 19;
+    }
+    uint8_t width = bit_width_required_i64(values, VALUE_COUNT);
+    TEST_ASSERT_EQUAL_UINT8(20, width);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_signed_bits_batch(stream, values, VALUE_COUNT, width).success);
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_signed_bits_batch(stream, decoded, VALUE_COUNT, width).success);
+    TEST_ASSERT_EQUAL_INT64_ARRAY(values, decoded, VALUE_COUNT);
+    
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_bit_width_required_unsigned);
+    RUN_TEST(test_bit_width_required_signed);
+    RUN_TEST(test_bit_width_required_128);
+    RUN_TEST(test_bit_width_required_feeds_batch);
+    
+    return UNITY_END();
+}
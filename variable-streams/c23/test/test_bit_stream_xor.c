@@ -0,0 +1,213 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include "test_helpers.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SAMPLE_COUNT 3000
+#define TEST_FILE_PATH "test_xor.bin"
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+// Fills samples with a slowly drifting sensor reading in steps of 1/16,
+// holding its value about half of the time
+static void fill_samples(double* samples, size_t count) {
+    uint64_t state = TEST_RANDOM_SEED;
+    double reading = 21.5;
+    for (size_t i = 0; i < count; i++) {
+        test_next_random(&state);
+        if (state % 2 == 0) {
+            reading += ((double)(state % 5) - 2.0) / 16.0;
+        }
+        samples[i] = reading;
+    }
+}
+
+void test_bit_stream_xor_double(void) {
+    // Test a round trip of slowly changing doubles and its size
+    static double samples[SAMPLE_COUNT];
+    static double decoded[SAMPLE_COUNT];
+    fill_samples(samples, SAMPLE_COUNT);
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x5, 3).success);
+    TEST_ASSERT_TRUE(bit_stream_write_xor_double(stream, samples, SAMPLE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2A, 7).success);
+    TEST_ASSERT_LESS_THAN_size_t(SAMPLE_COUNT * 16, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x5, bit_stream_read_bits(stream, 3).value.u64);
+    TEST_ASSERT_TRUE(bit_stream_read_xor_double(stream, decoded, SAMPLE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(samples, decoded, sizeof(samples));
+    TEST_ASSERT_EQUAL_UINT64(0x2A, bit_stream_read_bits(stream, 7).value.u64);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_xor_control_bits(void) {
+    // Test the exact layout: raw value, repeat, new window, reused window
+    double values[4] = {1.0, 1.0, 1.5, 1.25};
+    double decoded[4];
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_xor_double(stream, values, 4).success);
+    
+    // 1.0 ^ 1.5 has the single mantissa bit 51 set: 12 leading zeros and a
+    // length of 1; 1.5 ^ 1.25 sets bits 51 and 50, outside that window
+    size_t expected = 64 + 1 + (2 + 12 + 1) + (2 + 12 + 2);
+    TEST_ASSERT_EQUAL_size_t(expected, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_EQUAL_UINT64(0x3FF0000000000000ULL, bit_stream_read_bits(stream, 64).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0, bit_stream_read_bits(stream, 1).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0x3, bit_stream_read_bits(stream, 2).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(12, bit_stream_read_bits(stream, 6).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(0, bit_stream_read_bits(stream, 6).value.u64);
+    TEST_ASSERT_EQUAL_UINT64(1, bit_stream_read_bits(stream, 1).value.u64);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_xor_double(stream, decoded, 4).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_xor_special_values(void) {
+    // Test that values round trip bit for bit, including NaN and -0.0
+    double values[8] = {0.0, -0.0, NAN, INFINITY, -INFINITY, 1e-310, -1.0e300, 0.1};
+    double decoded[8];
+    float narrow[8];
+    float narrow_decoded[8];
+    for (int i = 0; i < 8; i++) {
+        narrow[i] = (float)values[i];
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_xor_double(stream, values, 8).success);
+    TEST_ASSERT_TRUE(bit_stream_write_xor_float(stream, narrow, 8).success);
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_xor_double(stream, decoded, 8).success);
+    TEST_ASSERT_TRUE(bit_stream_read_xor_float(stream, narrow_decoded, 8).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    TEST_ASSERT_EQUAL_MEMORY(narrow, narrow_decoded, sizeof(narrow));
+    TEST_ASSERT_TRUE(bit_stream_is_eof(stream));
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_xor_float(void) {
+    // Test floats, whose windows use 5-bit fields
+    static double samples[SAMPLE_COUNT];
+    static float values[SAMPLE_COUNT];
+    static float decoded[SAMPLE_COUNT];
+    fill_samples(samples, SAMPLE_COUNT);
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        values[i] = (float)samples[i];
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_xor_float(stream, values, SAMPLE_COUNT).success);
+    TEST_ASSERT_LESS_THAN_size_t(SAMPLE_COUNT * 12, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    TEST_ASSERT_TRUE(bit_stream_read_xor_float(stream, decoded, SAMPLE_COUNT).success);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_xor_rejects_bad_input(void) {
+    // Test a reused window before any window exists
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x3FF0000000000000ULL, 64).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0x2, 2).success);
+    TEST_ASSERT_TRUE(bit_stream_write_bits(stream, 0, 14).success);
+    
+    double decoded[4];
+    bit_stream_reset(stream);
+    BitStreamResult result = bit_stream_read_xor_double(stream, decoded, 2);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_INVALID_VALUE, result.error.code);
+    bit_stream_free(stream);
+    
+    // Test a stream that ends inside the meaningful bits
+    double values[2] = {1.0, 3.141592653589793};
+    stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_xor_double(stream, values, 2).success);
+    stream->bit_length -= 8;
+    bit_stream_reset(stream);
+    result = bit_stream_read_xor_double(stream, decoded, 2);
+    TEST_ASSERT_FALSE(result.success);
+    TEST_ASSERT_EQUAL(BIT_STREAM_ERROR_END_OF_STREAM, result.error.code);
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reader_writer_xor(void) {
+    // Test that the file writer and reader match the BitStream layout
+    static double samples[SAMPLE_COUNT];
+    static double decoded[SAMPLE_COUNT];
+    float narrow[64];
+    float narrow_decoded[64];
+    fill_samples(samples, SAMPLE_COUNT);
+    for (int i = 0; i < 64; i++) {
+        narrow[i] = (float)samples[i] * 3.0f;
+    }
+    
+    BitStream* stream = bit_stream_new();
+    TEST_ASSERT_TRUE(bit_stream_write_xor_double(stream, samples, SAMPLE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_write_xor_float(stream, narrow, 64).success);
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_xor_double(writer, samples, SAMPLE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_write_xor_float(writer, narrow, 64).success);
+    TEST_ASSERT_TRUE(bit_stream_writer_flush(writer).success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    static uint8_t bytes[SAMPLE_COUNT * 8];
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_size_t((bit_stream_length(stream) + 7) / 8, size);
+    TEST_ASSERT_EQUAL_MEMORY(stream->buffer, bytes, size);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 5);
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_TRUE(bit_stream_reader_read_xor_double(reader, decoded, SAMPLE_COUNT).success);
+    TEST_ASSERT_TRUE(bit_stream_reader_read_xor_float(reader, narrow_decoded, 64).success);
+    TEST_ASSERT_EQUAL_MEMORY(samples, decoded, sizeof(samples));
+    TEST_ASSERT_EQUAL_MEMORY(narrow, narrow_decoded, sizeof(narrow));
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+    bit_stream_free(stream);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_bit_stream_xor_double);
+    RUN_TEST(test_bit_stream_xor_control_bits);
+    RUN_TEST(test_bit_stream_xor_special_values);
+    RUN_TEST(test_bit_stream_xor_float);
+    RUN_TEST(test_bit_stream_xor_rejects_bad_input);
+    RUN_TEST(test_bit_stream_reader_writer_xor);
+    
+    return UNITY_END();
+}
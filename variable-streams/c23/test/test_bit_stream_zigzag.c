@@ -0,0 +1,167 @@
+#include "bit_stream.h"
+#include "unity.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+// Temporary file path for testing
+#define TEST_FILE_PATH "test_zigzag.bin"
+
+void setUp(void) {
+    // This is run before each test
+}
+
+void tearDown(void) {
+    // This is run after each test
+    remove(TEST_FILE_PATH);
+}
+
+void test_zigzag_scalar(void) {
+    // Test the interleaved mapping and its inverse
+    TEST_ASSERT_EQUAL_UINT64(0, zigzag_encode_i64(0));
+    TEST_ASSERT_EQUAL_UINT64(1, zigzag_encode_i64(-1));
+    TEST_ASSERT_EQUAL_UINT64(2, zigzag_encode_i64(1));
+    TEST_ASSERT_EQUAL_UINT64(3, zigzag_encode_i64(-2));
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX - 1, zigzag_encode_i64(INT64_MAX));
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, zigzag_encode_i64(INT64_MIN));
+    
+    int64_t samples[] = {0, 1, -1, 63, -64, 1000000, -1000000, INT64_MAX, INT64_MIN};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        TEST_ASSERT_EQUAL_INT64(samples[i], zigzag_decode_u64(zigzag_encode_i64(samples[i])));
+    }
+}
+
+void test_zigzag_i128(void) {
+    // Test the 128-bit mapping across the word boundary
+    UInt128 encoded = zigzag_encode_i128(int128_from_i64(-1));
+    TEST_ASSERT_EQUAL_UINT64(0, encoded.high);
+    TEST_ASSERT_EQUAL_UINT64(1, encoded.low);
+    
+    encoded = zigzag_encode_i128(int128_from_parts(0, 0x8000000000000000ULL));
+    TEST_ASSERT_EQUAL_UINT64(1, encoded.high);
+    TEST_ASSERT_EQUAL_UINT64(0, encoded.low);
+    
+    Int128 samples[] = {
+        int128_from_i64(0), int128_from_i64(-7), int128_from_i64(INT64_MIN),
+        int128_from_parts(INT64_MAX, UINT64_MAX), int128_from_parts(INT64_MIN, 0),
+        int128_from_parts(-3, 12345)
+    };
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        Int128 decoded = zigzag_decode_u128(zigzag_encode_i128(samples[i]));
+        TEST_ASSERT_EQUAL_INT64(samples[i].high, decoded.high);
+        TEST_ASSERT_EQUAL_UINT64(samples[i].low, decoded.low);
+    }
+}
+
+void test_zigzag_batch_matches_scalar(void) {
+    // Test the vector kernels against the scalar mapping, including tails
+    int64_t values[37];
+    uint64_t encoded[37];
+    int64_t decoded[37];
+    for (int i = 0; i < 37; i++) {
+        values[i] = (int64_t)((uint64_t)i * 0x9E3779B97F4A7C15ULL);
+    }
+    
+    zigzag_encode_i64_batch(values, encoded, 37);
+    for (int i = 0; i < 37; i++) {
+        TEST_ASSERT_EQUAL_UINT64(zigzag_encode_i64(values[i]), encoded[i]);
+    }
+    
+    zigzag_decode_u64_batch(encoded, decoded, 37);
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(values));
+}
+
+void test_bit_stream_zigzag(void) {
+    // Test small deltas of either sign in narrow fields
+    BitStream* stream = bit_stream_new();
+    int64_t deltas[300];
+    int64_t decoded[300];
+    for (int i = 0; i < 300; i++) {
+        deltas[i] = (i % 2 == 0) ? i % 16 : -(i % 16);
+    }
+    
+    BitStreamResult result = bit_stream_write_zigzag(stream, -3, 3);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_zigzag_batch(stream, deltas, 300, 5);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_write_zigzag_i128(stream, int128_from_parts(-2, 99), 100);
+    TEST_ASSERT_TRUE(result.success);
+    
+    TEST_ASSERT_EQUAL_size_t(3 + 300 * 5 + 100, bit_stream_length(stream));
+    
+    bit_stream_reset(stream);
+    
+    result = bit_stream_read_zigzag(stream, 3);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-3, result.value.i64);
+    
+    result = bit_stream_read_zigzag_batch(stream, decoded, 300, 5);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_MEMORY(deltas, decoded, sizeof(deltas));
+    
+    result = bit_stream_read_zigzag_i128(stream, 100);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-2, result.value.i128.high);
+    TEST_ASSERT_EQUAL_UINT64(99, result.value.i128.low);
+    
+    bit_stream_free(stream);
+}
+
+void test_bit_stream_reader_writer_zigzag(void) {
+    // Test ZigZag fields through the file reader and writer
+    int64_t deltas[300];
+    int64_t decoded[300];
+    for (int i = 0; i < 300; i++) {
+        deltas[i] = (i % 3 == 0) ? -i : i;
+    }
+    
+    FILE* file = fopen(TEST_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamWriter* writer = bit_stream_writer_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(writer);
+    
+    BitStreamResult result = bit_stream_writer_write_zigzag(writer, -1, 1);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_write_zigzag_batch(writer, deltas, 300, 10);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_write_zigzag_i128(writer, int128_from_i64(INT64_MIN), 70);
+    TEST_ASSERT_TRUE(result.success);
+    result = bit_stream_writer_flush(writer);
+    TEST_ASSERT_TRUE(result.success);
+    bit_stream_writer_free(writer);
+    fclose(file);
+    
+    file = fopen(TEST_FILE_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    BitStreamReader* reader = bit_stream_reader_with_capacity(file, 16);
+    TEST_ASSERT_NOT_NULL(reader);
+    
+    result = bit_stream_reader_read_zigzag(reader, 1);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-1, result.value.i64);
+    
+    result = bit_stream_reader_read_zigzag_batch(reader, decoded, 300, 10);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_MEMORY(deltas, decoded, sizeof(deltas));
+    
+    result = bit_stream_reader_read_zigzag_i128(reader, 70);
+    TEST_ASSERT_TRUE(result.success);
+    TEST_ASSERT_EQUAL_INT64(-1, result.value.i128.high);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)INT64_MIN, result.value.i128.low);
+    
+    bit_stream_reader_free(reader);
+    fclose(file);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_zigzag_scalar);
+    RUN_TEST(test_zigzag_i128);
+    RUN_TEST(test_zigzag_batch_matches_scalar);
+    RUN_TEST(test_bit_stream_zigzag);
+    RUN_TEST(test_bit_stream_reader_writer_zigzag);
+    
+    return UNITY_END();
+}
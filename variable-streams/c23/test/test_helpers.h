@@ -0,0 +1,20 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include <stdint.h>
+
+// Shared fixtures for the tests. Test data comes from one xorshift64
+// generator so that every run of every test sees the same values.
+
+// Default starting state of the generator; any nonzero state works
+#define TEST_RANDOM_SEED 0x9E3779B97F4A7C15ULL
+
+// Advances a xorshift64 state and returns the new state
+static inline uint64_t test_next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+#endif /* TEST_HELPERS_H */